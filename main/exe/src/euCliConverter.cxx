@@ -2,6 +2,9 @@
 #include "eudaq/DataConverter.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/ParallelFileReader.hh"
+#include "eudaq/StdEventBatchConverter.hh"
+#include <fstream>
 #include <iostream>
 
 int main(int /*argc*/, const char **argv) {
@@ -11,6 +14,10 @@ int main(int /*argc*/, const char **argv) {
   eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
 					 "output file");
   eudaq::OptionFlag iprint(op, "ip", "iprint", "enable print of input Event");
+  eudaq::Option<std::string> file_conf(op, "c", "config", "", "string", "configuration file");
+  eudaq::OptionFlag stdev(op, "std", "stdevent", "convert to StdEvent before writing");
+  eudaq::Option<uint32_t> jobs(op, "j", "jobs", 1, "uint32_t",
+			       "threads deserializing and converting the input (1: no read ahead, 0: all cores)");
 
   try{
     op.Parse(argv);
@@ -34,20 +41,82 @@ int main(int /*argc*/, const char **argv) {
     type_in = "native";
   if(type_out=="raw")
     type_out = "native";
+  if(type_in=="lz4" || type_in=="zst")
+    type_in = "native-" + type_in;
+  if(type_out=="lz4" || type_out=="zst")
+    type_out = "native-" + type_out;
   
-  eudaq::FileReaderUP reader;
+  eudaq::FileReaderSP reader;
   eudaq::FileWriterUP writer;
-  reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
+  reader = eudaq::Factory<eudaq::FileReader>::MakeShared(eudaq::str2hash(type_in), infile_path);
+  if(reader && jobs.Value() != 1)
+    reader = std::make_shared<eudaq::ParallelFileReader>(reader, jobs.Value());
   if(!type_out.empty())
     writer = eudaq::Factory<eudaq::FileWriter>::MakeUnique(eudaq::str2hash(type_out), outfile_path);
-  while(1){
+  // empty configuration object, prevents crash if no config file given
+  eudaq::Configuration eu_cfg("", "");
+  std::ifstream conffile(file_conf.Value());
+  if(conffile)
+    eu_cfg.Load(conffile, std::string("euCliConverter"));
+  else if(!file_conf.Value().empty())
+    std::cout << "WARNING, config file '" << file_conf.Value() << "' not found!" << std::endl;
+  eudaq::ConfigurationSPC config_spc = std::make_shared<const eudaq::Configuration>(eu_cfg);
+  // e.g. EUDAQ_FW_FORMAT_VERSION for the native writer
+  if(writer)
+    writer->SetConfiguration(config_spc);
+  std::unique_ptr<eudaq::StdEventBatchConverter> converter;
+  if(stdev.Value())
+    converter.reset(new eudaq::StdEventBatchConverter(config_spc, jobs.Value()));
+  // events are converted in batches, one batch keeps all the workers busy
+  const size_t batch_size = 256;
+  std::vector<eudaq::EventSPC> batch;
+  std::vector<eudaq::StdEventSP> batch_std;
+  std::vector<std::exception_ptr> errors;
+  uint32_t skipped = 0;
+  bool eof = false;
+  while(!eof){
     auto ev = reader->GetNextEvent();
     if(!ev)
-      break;
-    if(print_ev_in)
-      ev->Print(std::cout);
-    if(writer)
-      writer->WriteEvent(ev);
+      eof = true;
+    else{
+      if(print_ev_in)
+	ev->Print(std::cout);
+      if(!converter){
+	if(writer)
+	  writer->WriteEvent(ev);
+	continue;
+      }
+      batch.push_back(ev);
+      if(batch.size() < batch_size)
+	continue;
+    }
+    if(batch.empty())
+      continue;
+    auto ok = converter->ConvertBatch(batch, batch_std, &errors);
+    for(size_t i = 0; i < batch.size(); i++){
+      // events the converters discard or cannot convert are skipped
+      try{
+	if(errors[i])
+	  std::rethrow_exception(errors[i]);
+      }
+      catch(const eudaq::StdEventConverterException &e){
+	std::cout<<"WARNING, event "<< batch[i]->GetEventN() <<" skipped: "<< e.what() <<std::endl;
+	ok[i] = false;
+      }
+      catch(const std::exception &e){
+	std::cout<<"WARNING, event "<< batch[i]->GetEventN() <<" skipped, conversion failed: "<< e.what() <<std::endl;
+	ok[i] = false;
+      }
+      if(!ok[i]){
+	skipped++;
+	continue;
+      }
+      if(writer)
+	writer->WriteEvent(batch_std[i]);
+    }
+    batch.clear();
   }
+  if(skipped)
+    std::cout<< skipped <<" events could not be converted and were skipped"<<std::endl;
   return 0;
 }
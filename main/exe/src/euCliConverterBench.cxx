@@ -0,0 +1,206 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/StdEventBatchConverter.hh"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  const uint32_t STATEFUL = eudaq::cstr2hash("BenchStateful");
+  const uint32_t FAILING = eudaq::cstr2hash("BenchFailing");
+  const uint32_t FAILING_STREAM = 100;
+
+  // the threads which converted the events of each stream
+  std::mutex g_mtx;
+  std::map<uint32_t, std::set<std::thread::id>> g_threads;
+
+  struct BenchState : public eudaq::StdEventConverterState {
+    uint32_t n = 0;
+  };
+
+  // numbers the events of each stream, which only comes out right in stream order
+  class StatefulConverter : public eudaq::StdEventConverter {
+  public:
+    bool Converting(eudaq::EventSPC, eudaq::StdEventSP, eudaq::ConfigurationSPC) const override {
+      EUDAQ_THROW("BenchStateful needs a conversion context");
+    }
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StdEventSP d2, eudaq::ConfigurationSPC conf,
+			     eudaq::StdEventConversionContext &ctx) const override {
+      uint32_t stm = d1->GetStreamN();
+      auto &st = ctx.GetState<BenchState>(stm);
+      st.n++;
+      {
+	std::lock_guard<std::mutex> lk(g_mtx);
+	g_threads[stm].insert(std::this_thread::get_id());
+      }
+      auto &plane = d2->AddPlane(stm, "Bench", "Stateful");
+      plane.SetSizeZS(1024, 1024, 0);
+      uint32_t nhit = conf ? conf->Get("HITS", 100) : 100;
+      for(uint32_t h = 0; h < nhit; h++)
+	plane.PushPixel((h * 7 + st.n) % 1024, (h * 13) % 1024, 1);
+      d2->SetTag("Seq" + std::to_string(stm), st.n);
+      d2->SetTimeBegin(uint64_t(d1->GetEventN()) * 1000 + stm);
+      return true;
+    }
+  };
+
+  // discards some events and fails on others
+  class FailingConverter : public eudaq::StdEventConverter {
+  public:
+    bool IsStateless() const override {return true;}
+    bool Converting(eudaq::EventSPC d1, eudaq::StdEventSP d2, eudaq::ConfigurationSPC) const override {
+      uint32_t n = d1->GetEventN();
+      if(n % 7 == 3)
+	throw eudaq::DataDiscarded("event " + std::to_string(n) + " discarded");
+      if(n % 7 == 5)
+	return false;
+      d2->AddPlane(FAILING_STREAM, "Bench", "Failing").SetSizeZS(1, 1, 0);
+      d2->SetTag("Failing", n);
+      return true;
+    }
+  };
+
+  auto d0 = eudaq::Factory<eudaq::StdEventConverter>::Register<StatefulConverter>(STATEFUL);
+  auto d1 = eudaq::Factory<eudaq::StdEventConverter>::Register<FailingConverter>(FAILING);
+
+  eudaq::EventSP MakeRaw(uint32_t type, uint32_t stm, uint32_t n){
+    auto ev = eudaq::Event::MakeShared("RawEvent");
+    ev->SetExtendWord(type);
+    ev->SetStreamN(stm);
+    ev->SetEventN(n);
+    ev->SetTriggerN(n);
+    return ev;
+  }
+
+  struct Result{
+    bool ok = false;
+    bool error = false;
+    eudaq::StdEventSP ev;
+  };
+
+  bool Same(const Result &a, const Result &b){
+    if(a.ok != b.ok || a.error != b.error)
+      return false;
+    if(!a.ok)
+      return true;
+    if(a.ev->NumPlanes() != b.ev->NumPlanes() || a.ev->GetTags() != b.ev->GetTags() ||
+       a.ev->GetFlag() != b.ev->GetFlag() || a.ev->GetTriggerN() != b.ev->GetTriggerN() ||
+       a.ev->GetTimeBegin() != b.ev->GetTimeBegin())
+      return false;
+    for(size_t p = 0; p < a.ev->NumPlanes(); p++){
+      auto &pa = a.ev->GetPlane(p), &pb = b.ev->GetPlane(p);
+      if(pa.ID() != pb.ID() || pa.HitPixels() != pb.HitPixels())
+	return false;
+      for(size_t h = 0; h < pa.HitPixels(); h++)
+	if(pa.GetX(h) != pb.GetX(h) || pa.GetY(h) != pb.GetY(h))
+	  return false;
+    }
+    return true;
+  }
+
+  double seconds(Clock::time_point t0){
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ StdEvent Converter Benchmark", "2.0",
+			 "Batch conversion to StandardEvent, checked against the serial conversion");
+  eudaq::Option<uint32_t> nev(op, "n", "events", 1000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> nstm(op, "s", "streams", 4, "uint32_t", "streams merged into each packet");
+  eudaq::Option<uint32_t> jobs(op, "j", "jobs", 4, "uint32_t", "conversion threads");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  // merged packets of stateful sub-events, the failing one last as a failure
+  // stops the serial conversion of a packet; single failing events in between
+  std::vector<eudaq::EventSPC> in;
+  for(uint32_t n = 0; n < nev.Value(); n++){
+    if(n % 5 == 4){
+      in.push_back(MakeRaw(FAILING, FAILING_STREAM, n));
+      continue;
+    }
+    auto pkt = eudaq::Event::MakeShared("RawEvent");
+    pkt->SetFlagPacket();
+    pkt->SetEventN(n);
+    pkt->SetTriggerN(n);
+    for(uint32_t s = 0; s < nstm.Value(); s++)
+      pkt->AddSubEvent(MakeRaw(STATEFUL, s + 1, n));
+    if(n % 3 == 0)
+      pkt->AddSubEvent(MakeRaw(FAILING, FAILING_STREAM, n));
+    in.push_back(pkt);
+  }
+
+  auto conf = std::make_shared<const eudaq::Configuration>("HITS = 200", "");
+  std::vector<Result> ref(in.size());
+  eudaq::StdEventConversionContext ctx(conf);
+  auto t0 = Clock::now();
+  for(size_t i = 0; i < in.size(); i++){
+    ref[i].ev = eudaq::StandardEvent::MakeShared();
+    try{
+      ref[i].ok = ctx.Convert(in[i], ref[i].ev);
+    }
+    catch(const eudaq::StdEventConverterException &){
+      ref[i].error = true;
+    }
+  }
+  double t_serial = seconds(t0);
+  g_threads.clear();
+
+  eudaq::StdEventBatchConverter batch_cvt(conf, jobs.Value());
+  std::vector<Result> res(in.size());
+  const size_t batch_size = 256;
+  t0 = Clock::now();
+  for(size_t i0 = 0; i0 < in.size(); i0 += batch_size){
+    std::vector<eudaq::EventSPC> batch(in.begin() + i0, in.begin() + std::min(in.size(), i0 + batch_size));
+    std::vector<eudaq::StdEventSP> out;
+    std::vector<std::exception_ptr> errors;
+    auto ok = batch_cvt.ConvertBatch(batch, out, &errors);
+    for(size_t i = 0; i < batch.size(); i++){
+      auto &r = res[i0 + i];
+      r.ok = ok[i];
+      r.ev = out[i];
+      try{
+	if(errors[i])
+	  std::rethrow_exception(errors[i]);
+      }
+      catch(const eudaq::StdEventConverterException &){
+	r.error = true;
+	r.ok = false;
+      }
+    }
+  }
+  double t_batch = seconds(t0);
+
+  for(size_t i = 0; i < in.size(); i++){
+    if(!Same(ref[i], res[i])){
+      std::cerr<<"ERROR: batch conversion of event "<< i <<" differs from the serial one"<<std::endl;
+      return 1;
+    }
+  }
+  std::set<std::thread::id> all;
+  for(auto &stm: g_threads){
+    // a stream is always converted by the same worker
+    if(stm.first != FAILING_STREAM && stm.second.size() != 1){
+      std::cerr<<"ERROR: stream "<< stm.first <<" converted on "<< stm.second.size() <<" threads"<<std::endl;
+      return 1;
+    }
+    all.insert(stm.second.begin(), stm.second.end());
+  }
+  if(jobs.Value() > 1 && nstm.Value() > 1 && all.size() < 2){
+    std::cerr<<"ERROR: the sub-events of the packets were converted on a single thread"<<std::endl;
+    return 1;
+  }
+  std::cout<< in.size() <<" events, serial "<< t_serial*1e6/in.size() <<" us/event, batch of "
+	   << batch_cvt.GetNumWorkers() <<" workers "<< t_batch*1e6/in.size() <<" us/event"<<std::endl;
+  return 0;
+}
@@ -0,0 +1,173 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/FileReader.hh"
+#include "eudaq/FileNamer.hh"
+#include "eudaq/Configuration.hh"
+#include "eudaq/RawEvent.hh"
+#include "eudaq/BufferSerializer.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  // repeated bytes, so that compression has something to do
+  uint8_t Pattern(uint32_t n, size_t i){
+    return uint8_t(n + i / 64);
+  }
+
+  eudaq::EventSP MakeEvent(uint32_t n, uint32_t nev, size_t size){
+    eudaq::EventSP ev = eudaq::Event::MakeShared("RawEvent");
+    ev->SetRunN(1);
+    ev->SetEventN(n);
+    ev->SetTriggerN(n);
+    ev->SetTimestamp(1000 * uint64_t(n), 1000 * uint64_t(n) + 500);
+    if(n == 0)
+      ev->SetBORE();
+    if(n == nev - 1)
+      ev->SetEORE();
+    std::vector<uint8_t> data(size + n % 7);
+    for(size_t i = 0; i < data.size(); i++)
+      data[i] = Pattern(n, i);
+    ev->AddBlock(0, data);
+    return ev;
+  }
+
+  std::string Check(eudaq::EventSPC ev, uint32_t n, size_t size){
+    if(!ev)
+      return "event " + std::to_string(n) + " is missing";
+    if(ev->GetEventN() != n || ev->GetTriggerN() != n || ev->GetTimestampBegin() != 1000 * uint64_t(n))
+      return "event " + std::to_string(ev->GetEventN()) + " read instead of " + std::to_string(n);
+    if(ev->NumBlocks() != 1)
+      return "event " + std::to_string(n) + " has " + std::to_string(ev->NumBlocks()) + " blocks";
+    auto data = ev->GetBlockView(0);
+    bool ok = data.size() == size + n % 7;
+    for(size_t i = 0; ok && i < data.size(); i++)
+      ok = data[i] == Pattern(n, i);
+    return ok ? "" : "event " + std::to_string(n) + " was read back damaged";
+  }
+
+  bool SameBytes(eudaq::EventSPC a, eudaq::EventSPC b){
+    eudaq::BufferSerializer sa, sb;
+    a->Serialize(sa);
+    b->Serialize(sb);
+    return sa.size() == sb.size() && std::equal(sa.data(), sa.data() + sa.size(), sb.data());
+  }
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ File Benchmark", "2.0",
+			 "Writes events with a FileWriter and reads them back");
+  eudaq::Option<std::string> type(op, "t", "type", "native", "string", "file format: native, native-lz4 or native-zst");
+  eudaq::Option<uint32_t> nev(op, "n", "events", 1000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> size(op, "s", "size", 1000, "uint32_t", "data bytes per event");
+  eudaq::Option<std::string> pattern(op, "o", "output", "eudaq_filebench$X", "string", "output file pattern");
+  eudaq::Option<std::string> conf(op, "c", "config", "", "string",
+				  "configuration of the writer and the reader, KEY=VALUE separated by commas");
+  eudaq::OptionFlag compare(op, "m", "mapped",
+			    "read back through the memory mapping and the stream reader, and compare them");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  auto cfg = std::make_shared<eudaq::Configuration>();
+  for(auto &kv: eudaq::split(conf.Value(), ",")){
+    size_t eq = kv.find('=');
+    if(eq == std::string::npos){
+      std::cerr<<"ERROR: "<< kv <<" is not KEY=VALUE"<<std::endl;
+      return 1;
+    }
+    cfg->SetString(eudaq::trim(kv.substr(0, eq)), eudaq::trim(kv.substr(eq + 1)));
+  }
+  std::string ext = ".raw";
+  if(type.Value() == "native-lz4")
+    ext = ".raw.lz4";
+  else if(type.Value() == "native-zst")
+    ext = ".raw.zst";
+  std::string patt = pattern.Value();
+  std::string filename = eudaq::FileNamer(patt).Set('X', ext).Set('R', 1);
+  std::remove(filename.c_str());
+  std::remove((filename + ".idx").c_str());
+
+  std::vector<eudaq::EventSP> evs;
+  for(uint32_t n = 0; n < nev.Value(); n++)
+    evs.push_back(MakeEvent(n, nev.Value(), size.Value()));
+
+  try{
+    auto t0 = Clock::now();
+    {
+      auto writer = eudaq::Factory<eudaq::FileWriter>::MakeUnique(eudaq::str2hash(type.Value()), patt);
+      if(!writer){
+	std::cerr<<"ERROR: no writer for "<< type.Value() <<std::endl;
+	return 1;
+      }
+      writer->SetConfiguration(cfg);
+      for(auto &ev: evs)
+	writer->WriteEvent(ev);
+      writer->Flush();
+    }
+    double dt_write = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    auto reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type.Value()), filename);
+    if(!reader){
+      std::cerr<<"ERROR: no reader for "<< type.Value() <<std::endl;
+      return 1;
+    }
+    eudaq::Factory<eudaq::FileReader>::UP_BASE stream;
+    if(compare.IsSet()){
+      cfg->Set("EUDAQ_FR_MMAP", 1);
+      auto stream_cfg = std::make_shared<eudaq::Configuration>(*cfg);
+      stream_cfg->Set("EUDAQ_FR_MMAP", 0);
+      stream = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type.Value()), filename);
+      stream->SetConfiguration(stream_cfg);
+    }
+    reader->SetConfiguration(cfg);
+    t0 = Clock::now();
+    for(uint32_t n = 0; n < nev.Value(); n++){
+      auto ev = reader->GetNextEvent();
+      std::string err = Check(ev, n, size.Value());
+      if(err.empty() && stream){
+	auto ev_stream = stream->GetNextEvent();
+	if(!ev_stream || !SameBytes(ev, ev_stream))
+	  err = "event " + std::to_string(n) + " differs between the mapped and the stream reader";
+      }
+      if(!err.empty()){
+	std::cerr<<"ERROR: "<< err <<std::endl;
+	return 1;
+      }
+    }
+    if(reader->GetNextEvent() || (stream && stream->GetNextEvent())){
+      std::cerr<<"ERROR: more events read than written"<<std::endl;
+      return 1;
+    }
+    double dt_read = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    // through the index, written by default
+    uint32_t mid = nev.Value() / 2;
+    if(nev.Value() && cfg->Get("EUDAQ_FW_INDEX", 1)){
+      std::string err;
+      if(!reader->Seek(mid))
+	err = "seeking to event " + std::to_string(mid) + " failed";
+      else
+	err = Check(reader->GetNextEvent(), mid, size.Value());
+      if(!err.empty()){
+	std::cerr<<"ERROR: "<< err <<std::endl;
+	return 1;
+      }
+    }
+    double mb = nev.Value() * double(size.Value()) / 1e6;
+    std::cout<< nev.Value() <<" events of "<< size.Value() <<" bytes through "<< filename
+	     <<", written at "<< mb / dt_write <<" MB/s, read at "<< mb / dt_read <<" MB/s"<<std::endl;
+  }
+  catch(const std::exception &e){
+    std::cerr<<"ERROR: "<< e.what() <<std::endl;
+    return 1;
+  }
+  return 0;
+}
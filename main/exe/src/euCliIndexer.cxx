@@ -0,0 +1,83 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/MappedFileDeserializer.hh"
+#include "eudaq/NativeFormat.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/FileReader.hh"
+
+#include <iostream>
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line FileIndexer", "2.0",
+			 "Create the seek index of a native data file");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string", "input file");
+  eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
+					 "output index file (default: input file + .idx)");
+  eudaq::Option<uint32_t> check(op, "c", "check", 0, "uint32_t",
+				"verify that the index leads to this event number");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  std::string infile_path = file_input.Value();
+  std::string outfile_path = file_output.Value();
+  if(outfile_path.empty())
+    outfile_path = eudaq::FileIndex::IndexPath(infile_path);
+
+  eudaq::FileIndex index;
+  eudaq::MappedFileDeserializer des(infile_path);
+  uint32_t version = eudaq::NativeFormat::ReadHeader(des);
+  while(des.HasData()){
+    uint64_t offset = des.Tell();
+    if(version > 1){
+      // framed records are indexed from their headers, without deserializing them
+      eudaq::NativeFormat::RecordInfo info;
+      try{
+	eudaq::NativeFormat::PeekRecord(des, info);
+	des.Seek(offset + eudaq::NativeFormat::RECORD_PREFIX_SIZE + info.length);
+      }
+      catch(const eudaq::FileReadException &){
+	std::cerr<<"WARNING: truncated record at byte "<< offset <<" is not indexed"<<std::endl;
+	break;
+      }
+      eudaq::FileIndex::Entry entry = {info.event_n, info.trigger_n, info.timestamp, offset};
+      index.Add(entry);
+      continue;
+    }
+    uint32_t id;
+    des.PreRead(id);
+    auto ev = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, des);
+    if(!ev){
+      std::cerr<<"ERROR: unknown event type at byte "<< offset <<", index is incomplete"<<std::endl;
+      break;
+    }
+    eudaq::FileIndex::Entry entry = {ev->GetEventN(), ev->GetTriggerN(),
+				     ev->GetTimestampBegin(), offset};
+    index.Add(entry);
+  }
+  index.Save(outfile_path);
+  std::cout<< "Indexed "<< index.Size() << " events of "<< infile_path
+	   <<" into "<< outfile_path <<std::endl;
+
+  if(check.IsSet()){
+    eudaq::FileIndex loaded;
+    auto entry = loaded.Load(outfile_path) ? loaded.FindEvent(check.Value()) : nullptr;
+    if(!entry || loaded.Size() != index.Size()){
+      std::cerr<<"ERROR: event "<< check.Value() <<" not found in the index"<<std::endl;
+      return 1;
+    }
+    eudaq::MappedFileDeserializer chk(infile_path);
+    chk.Seek(entry->offset + (version > 1 ? eudaq::NativeFormat::RECORD_PREFIX_SIZE : 0));
+    uint32_t id;
+    chk.PreRead(id);
+    auto ev = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, chk);
+    if(!ev || ev->GetEventN() != entry->event_n){
+      std::cerr<<"ERROR: seeking to event "<< check.Value() <<" failed"<<std::endl;
+      return 1;
+    }
+    std::cout<< "Event "<< ev->GetEventN() <<" found at byte "<< entry->offset <<std::endl;
+  }
+  return 0;
+}
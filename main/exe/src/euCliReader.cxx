@@ -1,5 +1,7 @@
 #include "eudaq/OptionParser.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/ParallelFileReader.hh"
+#include "eudaq/FileIndex.hh"
 #include "eudaq/StdEventConverter.hh"
 
 #include <iostream>
@@ -12,16 +14,20 @@ int main(int /*argc*/, const char **argv) {
   eudaq::Option<uint32_t> eventh(op, "E", "eventhigh", 0, "uint32_t", "event number high");
   eudaq::Option<uint32_t> triggerl(op, "tg", "trigger", 0, "uint32_t", "trigger number low");
   eudaq::Option<uint32_t> triggerh(op, "TG", "triggerhigh", 0, "uint32_t", "trigger number high");
-  eudaq::Option<uint32_t> timestampl(op, "ts", "timestamp", 0, "uint32_t", "timestamp low");
-  eudaq::Option<uint32_t> timestamph(op, "TS", "timestamphigh", 0, "uint32_t", "timestamp high");
+  eudaq::Option<uint64_t> timestampl(op, "ts", "timestamp", 0, "uint64_t", "timestamp low");
+  eudaq::Option<uint64_t> timestamph(op, "TS", "timestamphigh", 0, "uint64_t", "timestamp high");
   eudaq::OptionFlag stat(op, "s", "statistics", "enable print of statistics");
   eudaq::OptionFlag stdev(op, "std", "stdevent", "enable converter of StdEvent");
+  eudaq::Option<uint32_t> jobs(op, "j", "jobs", 1, "uint32_t",
+			       "threads deserializing the input (1: no read ahead, 0: all cores)");
 
   op.Parse(argv);
   std::string infile_path = file_input.Value();
   std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
   if(type_in=="raw")
     type_in = "native";
+  if(type_in=="lz4" || type_in=="zst")
+    type_in = "native-" + type_in;
 
   bool stdev_v = stdev.Value();
   bool stat_v = stat.Value();
@@ -31,8 +37,8 @@ int main(int /*argc*/, const char **argv) {
   uint32_t eventh_v = eventh.Value();
   uint32_t triggerl_v = triggerl.Value();
   uint32_t triggerh_v = triggerh.Value();
-  uint32_t timestampl_v = timestampl.Value();
-  uint32_t timestamph_v = timestamph.Value();
+  uint64_t timestampl_v = timestampl.Value();
+  uint64_t timestamph_v = timestamph.Value();
   bool not_all_zero = eventl_v||eventh_v||triggerl_v||triggerh_v||timestampl_v||timestamph_v;
 
 
@@ -52,20 +58,49 @@ int main(int /*argc*/, const char **argv) {
   // build shared pointer
   const eudaq::Configuration const_eu_cfg = eu_cfg;
   eudaq::ConfigurationSPC config_spc = std::make_shared<const eudaq::Configuration>(const_eu_cfg);
+  eudaq::StdEventConversionContext std_ctx(config_spc);
 
 
-  eudaq::FileReaderUP reader;
-  reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
+  eudaq::FileReaderSP reader;
+  reader = eudaq::Factory<eudaq::FileReader>::MakeShared(eudaq::str2hash(type_in), infile_path);
+  if(!reader){
+    std::cerr<<"ERROR: no reader for the file type '"<< type_in <<"'"<<std::endl;
+    return 1;
+  }
+  if(reader && jobs.Value() != 1)
+    reader = std::make_shared<eudaq::ParallelFileReader>(reader, jobs.Value());
   uint32_t event_count = 0;
   // for the gathering of statistics - initialise with end-of-range values
   std::map<uint32_t,std::string> device_list;
   uint32_t tgn_low = std::numeric_limits<uint32_t>::max();
   uint32_t tgn_high = 0;
-  
+
+  // with the index written next to the file (or by euCliIndexer) the count
+  // is known without reading the events: the reader jumps to the requested
+  // range, and stops after it where the index shows the file is ordered.
+  // The range filters below still apply.
+  eudaq::FileIndex index;
+  bool indexed = !stat_v && not_all_zero &&
+    index.Load(eudaq::FileIndex::IndexPath(infile_path));
+  if(indexed){
+    event_count = index.Size();
+    if(eventl_v)
+      reader->Seek(eventl_v);
+    else if(triggerl_v)
+      reader->SeekTrigger(triggerl_v);
+    else if(timestampl_v)
+      reader->SeekTimestamp(timestampl_v);
+  }
+
   while(1){
     auto ev = reader->GetNextEvent();
     if(!ev)
       break;
+    if(indexed &&
+       ((eventh_v && index.EventsSorted() && ev->GetEventN() >= eventh_v) ||
+	(triggerh_v && index.TriggersSorted() && ev->GetTriggerN() >= triggerh_v) ||
+	(timestamph_v && index.TimestampsSorted() && ev->GetTimestampBegin() > timestamph_v)))
+      break;
     bool in_range_evn = false;
     if(eventl_v!=0 || eventh_v!=0){
       uint32_t ev_n = ev->GetEventN();
@@ -88,8 +123,8 @@ int main(int /*argc*/, const char **argv) {
 
     bool in_range_tsn = false;
     if(timestampl_v!=0 || timestamph_v!=0){
-      uint32_t ts_beg = ev->GetTimestampBegin();
-      uint32_t ts_end = ev->GetTimestampEnd();
+      uint64_t ts_beg = ev->GetTimestampBegin();
+      uint64_t ts_end = ev->GetTimestampEnd();
       if(ts_beg >= timestampl_v && ts_end <= timestamph_v){
         in_range_tsn = true;
       }
@@ -102,7 +137,7 @@ int main(int /*argc*/, const char **argv) {
       ev->Print(std::cout);
       if(stdev_v){
         auto evstd = eudaq::StandardEvent::MakeShared();
-        eudaq::StdEventConverter::Convert(ev, evstd, config_spc);
+        std_ctx.Convert(ev, evstd);
         std::cout<< ">>>>>"<< evstd->NumPlanes() <<"<<<<"<<std::endl;
       }
     }
@@ -119,7 +154,8 @@ int main(int /*argc*/, const char **argv) {
         device_list.emplace(subev->GetStreamN(), subev->GetDescription());
       }
     }
-    event_count ++;
+    if(!indexed)
+      event_count ++;
   }
   std::cout<< "There are "<< event_count << " events"<<std::endl;
 
@@ -0,0 +1,213 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/StandardEvent.hh"
+#include "eudaq/ObjectPool.hh"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  // The per-element encoding that Serializer::write(std::vector<T>) used
+  // before the bulk path; it produces the identical byte stream.
+  template <typename T>
+  void write_elementwise(eudaq::Serializer &ser, const std::vector<std::vector<T>> &v){
+    ser.write((unsigned)v.size());
+    for(auto &col: v){
+      ser.write((unsigned)col.size());
+      for(auto &e: col)
+	ser.write(e);
+    }
+  }
+
+  template <typename T>
+  void read_elementwise(eudaq::Deserializer &ds, std::vector<std::vector<T>> &v){
+    unsigned n = ds.read<unsigned>();
+    v.resize(n);
+    for(auto &col: v){
+      unsigned len = ds.read<unsigned>();
+      col.clear();
+      col.reserve(len);
+      for(unsigned i = 0; i < len; i++)
+	col.push_back(ds.read<T>());
+    }
+  }
+
+  double seconds(Clock::time_point t0){
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+  void report(const std::string &name, size_t bytes, uint32_t n, double t){
+    std::cout<< name <<": "<< n <<" round trips, "<< bytes <<" bytes each, "
+	     << t*1e6/n <<" us/round trip, "<< bytes*n/t/1e6 <<" MB/s"<<std::endl;
+  }
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Serializer Benchmark", "2.0",
+			 "Round-trip throughput of StandardEvent serialization");
+  eudaq::Option<uint32_t> nev(op, "n", "events", 1000, "uint32_t", "number of round trips");
+  eudaq::Option<uint32_t> npl(op, "p", "planes", 6, "uint32_t", "planes per event");
+  eudaq::Option<uint32_t> nhit(op, "m", "hits", 2000, "uint32_t", "hits per plane");
+  eudaq::Option<uint32_t> pool(op, "P", "pool", 0, "uint32_t",
+			       "event pool capacity for the StandardEvent round trips, 0 = no pooling");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<uint32_t> col(0, 1151), row(0, 575);
+  eudaq::StandardEvent ev;
+  std::vector<std::vector<double>> pix(1), x(1), y(1);
+  std::vector<std::vector<uint64_t>> ts(1);
+  for(uint32_t p = 0; p < npl.Value(); p++){
+    eudaq::StandardPlane plane(p, "Bench", "MIMOSA26");
+    plane.SetSizeZS(1152, 576, 0);
+    for(uint32_t h = 0; h < nhit.Value(); h++){
+      uint32_t c = col(gen), r = row(gen);
+      plane.PushPixel(c, r, 1, uint64_t(h)*1000);
+      if(p == 0){ // columns of a single plane for the column benchmarks
+	x[0].push_back(c);
+	y[0].push_back(r);
+	pix[0].push_back(1);
+	ts[0].push_back(uint64_t(h)*1000);
+      }
+    }
+    ev.AddPlane(plane);
+  }
+
+  eudaq::BufferSerializer ref;
+  write_elementwise(ref, x);
+  write_elementwise(ref, y);
+  write_elementwise(ref, pix);
+  write_elementwise(ref, ts);
+  size_t colbytes = ref.size() * npl.Value();
+
+  auto t0 = Clock::now();
+  for(uint32_t i = 0; i < nev.Value(); i++){
+    for(uint32_t p = 0; p < npl.Value(); p++){
+      eudaq::BufferSerializer ser;
+      write_elementwise(ser, x);
+      write_elementwise(ser, y);
+      write_elementwise(ser, pix);
+      write_elementwise(ser, ts);
+      std::vector<std::vector<double>> rx, ry, rpix;
+      std::vector<std::vector<uint64_t>> rts;
+      read_elementwise(ser, rx);
+      read_elementwise(ser, ry);
+      read_elementwise(ser, rpix);
+      read_elementwise(ser, rts);
+    }
+  }
+  report("hit columns, per element (before)", colbytes, nev.Value(), seconds(t0));
+
+  t0 = Clock::now();
+  for(uint32_t i = 0; i < nev.Value(); i++){
+    for(uint32_t p = 0; p < npl.Value(); p++){
+      eudaq::BufferSerializer ser;
+      ser.write(x);
+      ser.write(y);
+      ser.write(pix);
+      ser.write(ts);
+      std::vector<std::vector<double>> rx, ry, rpix;
+      std::vector<std::vector<uint64_t>> rts;
+      ser.read(rx);
+      ser.read(ry);
+      ser.read(rpix);
+      ser.read(rts);
+    }
+  }
+  report("hit columns, bulk (after)", colbytes, nev.Value(), seconds(t0));
+
+  eudaq::BufferSerializer check;
+  check.write(x);
+  check.write(y);
+  check.write(pix);
+  check.write(ts);
+  if(check.size() != ref.size() || !std::equal(check.data(), check.data()+check.size(), ref.data())){
+    std::cerr<<"ERROR: bulk and per-element encodings differ"<<std::endl;
+    return 1;
+  }
+
+  // planes written before the columnar layout must still be readable
+  size_t n0 = x[0].size();
+  std::vector<std::vector<double>> zeros(1, std::vector<double>(n0));
+  eudaq::BufferSerializer legacy;
+  legacy.write(std::string("Bench"));
+  legacy.write(std::string("MIMOSA26"));
+  legacy.write(uint32_t(0));
+  legacy.write(uint32_t(1152));
+  legacy.write(uint32_t(576));
+  legacy.write(uint32_t(eudaq::StandardPlane::FLAG_ZS));
+  legacy.write(uint32_t(0));
+  legacy.write(pix);
+  legacy.write(std::vector<std::vector<std::vector<double>>>(1, std::vector<std::vector<double>>(n0)));
+  legacy.write(zeros);
+  legacy.write(zeros);
+  legacy.write(x);
+  legacy.write(y);
+  legacy.write(std::vector<std::vector<bool>>());
+  legacy.write(std::vector<uint32_t>());
+  legacy.write(ts);
+  eudaq::StandardPlane old(legacy);
+  const eudaq::StandardPlane &cur = ev.GetPlane(0);
+  bool same = old.HitPixels() == n0 && cur.HitPixels() == n0;
+  for(size_t i = 0; same && i < n0; i++)
+    same = old.GetX(i) == x[0][i] && old.GetY(i) == y[0][i] && old.GetPixel(i) == pix[0][i] &&
+      old.GetTimestamp(i) == ts[0][i] && cur.GetX(i) == old.GetX(i) &&
+      cur.GetY(i) == old.GetY(i) && cur.GetTimestamp(i) == old.GetTimestamp(i);
+  if(!same){
+    std::cerr<<"ERROR: legacy StandardPlane layout is not read back correctly"<<std::endl;
+    return 1;
+  }
+
+  eudaq::BufferSerializer evser;
+  ev.Serialize(evser);
+  eudaq::SetPoolCapacity(pool.Value());
+  t0 = Clock::now();
+  for(uint32_t i = 0; i < nev.Value(); i++){
+    eudaq::BufferSerializer ser;
+    ev.Serialize(ser);
+    uint32_t id;
+    ser.PreRead(id);
+    auto evr = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, ser);
+    if(!evr)
+      return 1;
+  }
+  report("StandardEvent", evser.size(), nev.Value(), seconds(t0));
+
+  // receiver side only, where pooled events are recycled
+  t0 = Clock::now();
+  for(uint32_t i = 0; i < nev.Value(); i++){
+    eudaq::BufferSerializer ser(evser.data(), evser.data()+evser.size());
+    uint32_t id;
+    ser.PreRead(id);
+    auto evr = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, ser);
+    if(!evr)
+      return 1;
+    if(i + 1 == nev.Value()){
+      // a recycled event must read back exactly like a new one
+      eudaq::BufferSerializer reser;
+      evr->Serialize(reser);
+      if(reser.size() != evser.size() ||
+	 !std::equal(reser.data(), reser.data()+reser.size(), evser.data())){
+	std::cerr<<"ERROR: StandardEvent round trip differs"<<std::endl;
+	return 1;
+      }
+    }
+  }
+  report(pool.Value() ? "StandardEvent receive, pooled" : "StandardEvent receive",
+	 evser.size(), nev.Value(), seconds(t0));
+  // lowering the capacity frees the idle events
+  eudaq::SetPoolCapacity(0);
+  if(eudaq::ObjectPool<eudaq::StandardEvent>::Instance().Size()){
+    std::cerr<<"ERROR: idle events kept after disabling the pool"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
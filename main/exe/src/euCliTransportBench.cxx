@@ -0,0 +1,256 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/DataReceiver.hh"
+#include "eudaq/DataSender.hh"
+#include "eudaq/TransportClient.hh"
+#include "eudaq/GatherSerializer.hh"
+#include "eudaq/RawEvent.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace{
+  using Clock = std::chrono::steady_clock;
+
+  // events whose serialization starts like a batch or a compressed packet,
+  // only packets of connections which negotiated these may be unpacked
+  template <uint32_t ID>
+  class LookalikeEvent : public eudaq::Event {
+  public:
+    LookalikeEvent(){SetType(ID);}
+    LookalikeEvent(eudaq::Deserializer &ds):Event(ds){}
+  };
+  using BatchLookalike = LookalikeEvent<eudaq::DataSender::BATCH_ID>;
+  using CompressedLookalike = LookalikeEvent<eudaq::DataSender::COMPRESSED_ID>;
+
+  auto d0 = eudaq::Factory<eudaq::Event>::Register<BatchLookalike, eudaq::Deserializer&>(eudaq::DataSender::BATCH_ID);
+  auto d1 = eudaq::Factory<eudaq::Event>::Register<CompressedLookalike, eudaq::Deserializer&>(eudaq::DataSender::COMPRESSED_ID);
+
+  uint32_t TypeOf(uint32_t n){
+    if(n % 10 == 3)
+      return eudaq::DataSender::BATCH_ID;
+    if(n % 10 == 7)
+      return eudaq::DataSender::COMPRESSED_ID;
+    return eudaq::RawEvent::m_id_factory;
+  }
+
+  // repeated bytes, so that compression has something to do
+  uint8_t Pattern(uint32_t n, size_t i){
+    return uint8_t(n + i / 64);
+  }
+
+  eudaq::EventSP MakeEvent(uint32_t n, uint32_t nev, size_t size){
+    eudaq::EventSP ev;
+    uint32_t type = TypeOf(n);
+    if(type == eudaq::DataSender::BATCH_ID)
+      ev = std::make_shared<BatchLookalike>();
+    else if(type == eudaq::DataSender::COMPRESSED_ID)
+      ev = std::make_shared<CompressedLookalike>();
+    else
+      ev = eudaq::Event::MakeShared("RawEvent");
+    ev->SetEventN(n);
+    if(n == 0)
+      ev->SetBORE();
+    if(n == nev - 1)
+      ev->SetEORE();
+    std::vector<uint8_t> data(size);
+    for(size_t i = 0; i < size; i++)
+      data[i] = Pattern(n, i);
+    ev->AddBlock(0, data);
+    return ev;
+  }
+
+  class BenchReceiver : public eudaq::DataReceiver {
+  public:
+    BenchReceiver(size_t size, uint32_t delay_us, uint32_t stall):m_size(size), m_delay_us(delay_us), m_stall(stall){}
+    void OnReceive(eudaq::ConnectionSPC, eudaq::EventSP ev) override {
+      if(m_stall && ev->GetEventN() == m_stall){
+	// stops reading until Release, as a hung monitor would
+	std::unique_lock<std::mutex> lk(m_mtx);
+	m_cv_release.wait(lk, [this]{return m_released;});
+      }
+      if(m_delay_us)
+	std::this_thread::sleep_for(std::chrono::microseconds(m_delay_us));
+      uint32_t n = ev->GetEventN();
+      bool ok = ev->GetType() == TypeOf(n) && ev->NumBlocks() == 1;
+      if(ok){
+	auto data = ev->GetBlockView(0);
+	ok = data.size() == m_size;
+	for(size_t i = 0; ok && i < data.size(); i++)
+	  ok = data[i] == Pattern(n, i);
+      }
+      std::lock_guard<std::mutex> lk(m_mtx);
+      if(!ok){
+	m_error = "event " + std::to_string(n) + " arrived damaged";
+      }
+      else if(m_received && n <= m_last){
+	m_error = "event " + std::to_string(n) + " arrived after event " + std::to_string(m_last);
+      }
+      m_bore |= ev->IsBORE();
+      m_eore |= ev->IsEORE();
+      m_last = n;
+      m_received++;
+    }
+    bool Done(){
+      std::lock_guard<std::mutex> lk(m_mtx);
+      return m_eore || !m_error.empty();
+    }
+    void Release(){
+      std::lock_guard<std::mutex> lk(m_mtx);
+      m_released = true;
+      m_cv_release.notify_all();
+    }
+    size_t m_size;
+    uint32_t m_delay_us;
+    uint32_t m_stall;
+    bool m_released = false;
+    std::condition_variable m_cv_release;
+    std::mutex m_mtx;
+    std::string m_error;
+    uint32_t m_received = 0;
+    uint32_t m_last = 0;
+    bool m_bore = false;
+    bool m_eore = false;
+  };
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Transport Benchmark", "2.0",
+			 "Events sent from a DataSender to a DataReceiver, checked on arrival");
+  eudaq::Option<std::string> addr(op, "a", "address", "tcp://0", "string", "address to listen on (tcp://, ipc://, shm://)");
+  eudaq::Option<uint32_t> nev(op, "n", "events", 1000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> size(op, "s", "size", 1000, "uint32_t", "data bytes per event");
+  eudaq::Option<uint32_t> queue_kb(op, "q", "queue", 0, "uint32_t", "sender queue in kB (0: send on the calling thread)");
+  eudaq::Option<std::string> policy(op, "p", "policy", "block", "string", "sender queue policy: block, drop, signal or latest");
+  eudaq::Option<uint32_t> recv_kb(op, "r", "receive", 0, "uint32_t", "receiver queue per connection in kB, the credit (0: no limit)");
+  eudaq::Option<uint32_t> batch_kb(op, "b", "batch", 0, "uint32_t", "sender batches in kB (0: no batching)");
+  eudaq::Option<std::string> codec(op, "z", "compression", "none", "string", "compression codec: none, lz4 or zstd");
+  eudaq::Option<uint32_t> decode(op, "d", "decode", 0, "uint32_t", "receiver decoding threads");
+  eudaq::Option<uint32_t> delay(op, "w", "wait", 0, "uint32_t", "receiver delay per event in us");
+  eudaq::Option<uint32_t> stall(op, "S", "stall", 0, "uint32_t", "receiver stops reading at this event, the sender has to give up within its stop timeout (0: never)");
+  eudaq::OptionFlag legacy(op, "L", "legacy", "send without negotiating any capabilities, as older senders do");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  eudaq::DataSender::QueuePolicy qp;
+  if(policy.Value() == "block")
+    qp = eudaq::DataSender::QUEUE_BLOCK;
+  else if(policy.Value() == "drop")
+    qp = eudaq::DataSender::QUEUE_DROP;
+  else if(policy.Value() == "signal")
+    qp = eudaq::DataSender::QUEUE_SIGNAL;
+  else if(policy.Value() == "latest")
+    qp = eudaq::DataSender::QUEUE_LATEST;
+  else{
+    std::cerr<<"ERROR: unknown queue policy "<< policy.Value() <<std::endl;
+    return 1;
+  }
+  bool lossy = qp == eudaq::DataSender::QUEUE_DROP || qp == eudaq::DataSender::QUEUE_LATEST;
+  eudaq::CompressionCodec cc = eudaq::CompressionCodecFromName(codec.Value());
+
+  BenchReceiver rcv(size.Value(), delay.Value(), stall.Value());
+  rcv.SetQueueLimit(uint64_t(recv_kb.Value()) * 1024);
+  rcv.SetDecodeThreads(decode.Value());
+  std::string server = rcv.Listen(addr.Value());
+  if(server.find("tcp://") == 0)
+    server = "tcp://localhost:" + server.substr(6);
+
+  std::vector<eudaq::EventSP> evs;
+  for(uint32_t n = 0; n < nev.Value(); n++)
+    evs.push_back(MakeEvent(n, nev.Value(), size.Value()));
+
+  uint64_t dropped = 0;
+  eudaq::DataSender::CompressionStatus scs = {eudaq::CompressionCodec::NONE, 0, 0, 0};
+  std::unique_ptr<eudaq::DataSender> sender;
+  std::unique_ptr<eudaq::TransportClient> client;
+  auto t0 = Clock::now();
+  if(legacy.IsSet()){
+    client.reset(eudaq::TransportClient::CreateClient(server));
+    std::string packet;
+    client->ReceivePacket(&packet, 1000000);
+    client->SendPacket("OK EUDAQ DATA Producer bench");
+    client->ReceivePacket(&packet, 1000000);
+    for(auto &ev: evs){
+      eudaq::GatherSerializer ser;
+      ev->Serialize(ser);
+      client->SendPacket(ser);
+    }
+  }
+  else{
+    sender.reset(new eudaq::DataSender("Producer", "bench"));
+    if(queue_kb.Value())
+      sender->SetQueue(uint64_t(queue_kb.Value()) * 1024, qp);
+    if(batch_kb.Value())
+      sender->SetBatching(batch_kb.Value() * 1024);
+    if(cc != eudaq::CompressionCodec::NONE)
+      sender->SetCompression(cc);
+    sender->SetStopTimeout(1000);
+    sender->Connect(server);
+    for(auto &ev: evs)
+      sender->SendEvent(ev);
+  }
+
+  if(stall.Value()){
+    // the events still queued cannot be sent, stopping must not hang
+    auto t_stop = Clock::now();
+    sender.reset();
+    double dt_stop = std::chrono::duration<double>(Clock::now() - t_stop).count();
+    rcv.Release();
+    rcv.StopListen();
+    std::lock_guard<std::mutex> lk(rcv.m_mtx);
+    if(dt_stop > 5 || rcv.m_eore){
+      std::cerr<<"ERROR: stopping took "<< dt_stop <<" s, "<< rcv.m_received <<" events received"<<std::endl;
+      return 1;
+    }
+    std::cout<<"receiver stalled at event "<< stall.Value() <<", sender stopped after "<< dt_stop <<" s"<<std::endl;
+    return 0;
+  }
+
+  while(!rcv.Done() && Clock::now() - t0 < std::chrono::seconds(60))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+  if(sender){
+    dropped = sender->GetQueueStatus().dropped;
+    scs = sender->GetCompressionStatus();
+  }
+  auto rcs = rcv.GetCompressionStatus();
+  sender.reset();
+  client.reset();
+  rcv.StopListen();
+
+  std::lock_guard<std::mutex> lk(rcv.m_mtx);
+  if(!rcv.m_error.empty()){
+    std::cerr<<"ERROR: "<< rcv.m_error <<std::endl;
+    return 1;
+  }
+  if(!rcv.m_bore || !rcv.m_eore){
+    std::cerr<<"ERROR: "<< rcv.m_received <<" events received, BORE or EORE missing"<<std::endl;
+    return 1;
+  }
+  if(rcv.m_received + dropped != nev.Value() || (dropped && !lossy)){
+    std::cerr<<"ERROR: "<< rcv.m_received <<" events received and "<< dropped <<" dropped of "<< nev.Value() <<std::endl;
+    return 1;
+  }
+  // compression is used exactly if both ends support the codec
+  bool compressed = !legacy.IsSet() && cc != eudaq::CompressionCodec::NONE && eudaq::IsCompressionAvailable(cc);
+  if(scs.codec != (compressed ? cc : eudaq::CompressionCodec::NONE) ||
+     (compressed && size.Value() >= 1024 && !(rcs.wire_bytes && rcs.wire_bytes < rcs.raw_bytes)) ||
+     (!compressed && rcs.raw_bytes)){
+    std::cerr<<"ERROR: compression "<< eudaq::CompressionCodecName(scs.codec) <<" in use, "
+	     << rcs.raw_bytes <<" bytes uncompressed from "<< rcs.wire_bytes <<std::endl;
+    return 1;
+  }
+  std::cout<< rcv.m_received <<" events of "<< size.Value() <<" bytes over "<< addr.Value()
+	   <<", "<< dropped <<" dropped, "<< rcv.m_received * double(size.Value()) / dt / 1e6 <<" MB/s";
+  if(rcs.wire_bytes)
+    std::cout<<", "<< eudaq::CompressionCodecName(scs.codec) <<" ratio "<< double(rcs.raw_bytes) / rcs.wire_bytes;
+  std::cout<<std::endl;
+  return 0;
+}
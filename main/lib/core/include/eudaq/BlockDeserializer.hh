@@ -0,0 +1,27 @@
+#ifndef EUDAQ_INCLUDED_BlockDeserializer
+#define EUDAQ_INCLUDED_BlockDeserializer
+
+#include "eudaq/Deserializer.hh"
+#include "eudaq/BlockView.hh"
+#include "eudaq/Platform.hh"
+
+namespace eudaq {
+
+  /** A Deserializer on an immutable BlockView, e.g. a record of a file.
+   * Data blocks read from it are slices of the view and share its buffer.
+   */
+  class DLLEXPORT BlockDeserializer : public Deserializer {
+  public:
+    explicit BlockDeserializer(BlockView data);
+    bool HasData() override;
+    BlockView ReadBlock(size_t len) override;
+
+  private:
+    void Deserialize(uint8_t *data, size_t len) override;
+    void PreDeserialize(uint8_t *data, size_t len) override;
+    BlockView m_data;
+    size_t m_offset;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_BlockDeserializer
@@ -0,0 +1,63 @@
+#ifndef EUDAQ_INCLUDED_BlockView
+#define EUDAQ_INCLUDED_BlockView
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace eudaq {
+
+  /** An immutable view on a slice of a reference-counted byte buffer.
+   * The underlying buffer is kept alive for as long as any view on it
+   * exists, so views can be passed between events, serializers and
+   * converters without copying the data.
+   */
+  class BlockView {
+  public:
+    using const_iterator = const uint8_t *;
+
+    BlockView() : m_data(nullptr), m_size(0) {}
+
+    /// View on (a part of) a buffer that is kept alive by owner
+    BlockView(std::shared_ptr<const void> owner, const uint8_t *data, size_t size)
+      : m_owner(std::move(owner)), m_data(data), m_size(size) {}
+
+    /// Take over the ownership of a vector without copying its content
+    explicit BlockView(std::vector<uint8_t> &&data) : m_data(nullptr), m_size(0) {
+      auto buf = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+      m_data = buf->data();
+      m_size = buf->size();
+      m_owner = std::move(buf);
+    }
+
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+    const uint8_t &operator[](size_t i) const { return m_data[i]; }
+
+    /// A view on a sub-range of this view, sharing the same buffer
+    BlockView Slice(size_t offset, size_t size) const {
+      if (offset > m_size)
+        offset = m_size;
+      if (size > m_size - offset)
+        size = m_size - offset;
+      return BlockView(m_owner, m_data + offset, size);
+    }
+
+    /// Copy the content into a newly allocated vector
+    std::vector<uint8_t> ToVector() const {
+      return std::vector<uint8_t>(begin(), end());
+    }
+
+  private:
+    std::shared_ptr<const void> m_owner;
+    const uint8_t *m_data;
+    size_t m_size;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_BlockView
@@ -4,34 +4,52 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include "eudaq/Serializer.hh"
 #include "eudaq/Deserializer.hh"
 #include "eudaq/Exception.hh"
 
 namespace eudaq {
 
+  /** A Serializer/Deserializer on a memory buffer.
+   * The buffer is reference counted: data blocks read with ReadBlock are
+   * slices of the buffer itself and keep it alive, instead of being copied.
+   * Writing to a buffer which is still referenced by such a slice makes a
+   * private copy of the buffer first.
+   */
   class DLLEXPORT BufferSerializer
     : public Serializer, public Deserializer, public Serializable {
   public:
-    BufferSerializer() : m_offset(0) {}
+    BufferSerializer()
+      : m_data(std::make_shared<std::vector<unsigned char>>()), m_offset(0) {}
     template <typename InIt>
     BufferSerializer(InIt first, InIt last)
-        : m_data(first, last), m_offset(0) {}
+      : m_data(std::make_shared<std::vector<unsigned char>>(first, last)),
+        m_offset(0) {}
+    /// Adopt an existing buffer without copying it
+    explicit BufferSerializer(std::vector<unsigned char> &&data)
+      : m_data(std::make_shared<std::vector<unsigned char>>(std::move(data))),
+        m_offset(0) {}
     BufferSerializer(Deserializer &);
     void clear() {
-      m_data.clear();
+      if (m_data.use_count() > 1)
+        m_data = std::make_shared<std::vector<unsigned char>>();
+      else
+        m_data->clear();
       m_offset = 0;
     }
-    const unsigned char &operator[](size_t i) const { return m_data[i]; }
-    size_t size() const { return m_data.size(); }
-    virtual bool HasData() { return m_data.size() != 0; }
+    const unsigned char &operator[](size_t i) const { return (*m_data)[i]; }
+    const unsigned char *data() const { return m_data->data(); }
+    size_t size() const { return m_data->size(); }
+    virtual bool HasData() { return m_data->size() != 0; }
     virtual void Serialize(Serializer &) const;
+    BlockView ReadBlock(size_t len) override;
 
   private:
     virtual void Serialize(const unsigned char *data, size_t len);
     virtual void Deserialize(unsigned char *data, size_t len);
     virtual void PreDeserialize(unsigned char *data, size_t len);
-    std::vector<unsigned char> m_data;
+    std::shared_ptr<std::vector<unsigned char>> m_data;
     size_t m_offset;
   };
 }
@@ -0,0 +1,29 @@
+#ifndef EUDAQ_INCLUDED_Compression
+#define EUDAQ_INCLUDED_Compression
+
+#include "eudaq/Platform.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eudaq {
+
+  /// Block compression codecs, the values are stored in files and on the wire
+  enum class CompressionCodec : uint32_t { NONE = 0, LZ4 = 1, ZSTD = 2 };
+
+  /// Whether the library was built with support for the codec
+  bool DLLEXPORT IsCompressionAvailable(CompressionCodec codec);
+  CompressionCodec DLLEXPORT CompressionCodecFromName(const std::string &name);
+  std::string DLLEXPORT CompressionCodecName(CompressionCodec codec);
+
+  /// Compress len bytes of data into out (replacing its content). The level
+  /// is the compression level for ZSTD and the acceleration for LZ4,
+  /// 0 selects the default of the codec
+  void DLLEXPORT Compress(CompressionCodec codec, const uint8_t *data, size_t len,
+                          std::vector<uint8_t> &out, int level = 0);
+  /// Decompress a block whose uncompressed size rawlen is known
+  void DLLEXPORT Decompress(CompressionCodec codec, const uint8_t *data, size_t len,
+                            uint8_t *out, size_t rawlen);
+}
+
+#endif // EUDAQ_INCLUDED_Compression
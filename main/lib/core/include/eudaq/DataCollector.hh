@@ -69,6 +69,7 @@ namespace eudaq {
     uint32_t m_dct_n;
     uint32_t m_evt_c;
     uint32_t m_fraction;
+    uint64_t m_mn_bytes;
     ConfigurationSPC m_conf;
   };
   //----------DOC-MARK-----END*DEC-----DOC-MARK----------
@@ -4,6 +4,7 @@
 #include "eudaq/TransportServer.hh"
 #include "eudaq/CommandReceiver.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/BlockView.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/DataSender.hh"
 #include "eudaq/Configuration.hh"
@@ -18,7 +19,8 @@
 #include <atomic>
 #include <future>
 #include <thread>
-#include <queue>
+#include <deque>
+#include <map>
 #include <mutex>
 #include <condition_variable>
 #include <type_traits>
@@ -37,11 +39,57 @@ namespace eudaq {
     virtual void OnReceive(ConnectionSPC id, EventSP ev);
     std::string Listen(const std::string &addr);
     void StopListen();//TODO: remove this method later
+    /// Bytes of received events queued per connection, 0 for no limit.
+    /// Senders taking part in the flow control get this as their credit,
+    /// the others are not read from while their queue is full.
+    void SetQueueLimit(uint64_t bytes){m_qu_limit = bytes;}
+    uint64_t GetQueueLimit() const {return m_qu_limit;}
+    /// Threads deserializing the received events, taking effect at Listen.
+    /// With 0 (default) the forwarding thread deserializes them itself.
+    void SetDecodeThreads(uint32_t n){m_n_decode = n;}
+    struct CompressionStatus {
+      uint64_t raw_bytes;  ///< size of the compressed packets once uncompressed, since Listen
+      uint64_t wire_bytes; ///< size of the same packets as received
+      double cpu_ms;       ///< time spent uncompressing
+    };
+    CompressionStatus GetCompressionStatus();
   private:
+    enum ItemType {ITEM_EVENT, ITEM_CONNECT, ITEM_DISCONNECT};
+    enum ItemState {ITEM_PENDING, ITEM_DECODING, ITEM_READY};
+    struct Item{
+      ItemType type = ITEM_EVENT;
+      ItemState state = ITEM_READY;
+      uint64_t bytes = 0;
+      BlockView data = BlockView(); // the packet, until it is deserialized into evs
+      std::vector<EventSP> evs = {};
+      bool batch = false;    // the packet may carry several events
+      bool compress = false; // the packet may be compressed
+    };
+    using ItemSP = std::shared_ptr<Item>;
+    /// The events of one connection not yet forwarded
+    struct ConnQueue{
+      std::deque<ItemSP> items;
+      uint64_t bytes = 0;
+      uint64_t window = 0;   // credit granted at the connection
+      uint64_t consumed = 0; // forwarded bytes not yet returned as credit
+      bool credit = false;   // the sender waits for credit
+      bool scheduled = false;
+      bool paused = false;   // not read from until half of the queue has drained
+      bool batch = false;    // negotiated in the handshake
+      bool compress = false;
+    };
     void DataHandler(TransportEvent &ev);
+    void Enqueue(ConnectionSPC con, ItemSP item);
+    BlockView Uncompress(const BlockView &packet);
+    static std::vector<BlockView> Unbatch(const BlockView &packet);
+    void Decode(Item &item);
+    void DecodeWorker();
+    ItemSP NextItem(ConnectionSPC &con);
+    void FlowControl();
     bool Deamon();
     bool AsyncReceiving();
     bool AsyncForwarding();
+    void ClearQueues(const std::string &when);
     
   private:
     std::unique_ptr<TransportServer> m_dataserver;
@@ -55,8 +103,21 @@ namespace eudaq {
     std::future<bool> m_fut_deamon;
     std::mutex m_mx_qu_ev;
     std::mutex m_mx_deamon;
-    std::queue<std::pair<EventSP, ConnectionSPC>> m_qu_ev;
+    uint64_t m_qu_limit;
+    std::map<ConnectionSPC, ConnQueue> m_qu_con;
+    std::deque<ConnectionSPC> m_qu_ready; // round robin over the connections with queued events
+    // to be handled by the receiving thread
+    std::map<ConnectionSPC, uint64_t> m_credits;
+    std::vector<ConnectionSPC> m_resume;
     std::condition_variable m_cv_not_empty;
+    uint32_t m_n_decode;
+    uint32_t m_n_decode_running;
+    bool m_decode_exit;
+    std::deque<ItemSP> m_qu_decode; // in arrival order, across all connections
+    std::condition_variable m_cv_decode;
+    uint64_t m_cmp_raw;
+    uint64_t m_cmp_wire;
+    double m_cmp_ms;
   };
   //----------DOC-MARK-----END*DEC-----DOC-MARK----------
 }
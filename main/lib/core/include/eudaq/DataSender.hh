@@ -4,10 +4,13 @@
 
 #include "eudaq/Platform.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/SerializedEvent.hh"
+#include "eudaq/Compression.hh"
 #include <string>
-#include <future>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 
@@ -17,20 +20,111 @@ class TransportClient;
 
   class DLLEXPORT DataSender {
   public:
+      /// What SendEvent does when the send queue is full
+      enum QueuePolicy {
+	QUEUE_BLOCK,  ///< wait until there is space again
+	QUEUE_DROP,   ///< drop the new event and count it, BORE and EORE are always sent
+	QUEUE_SIGNAL, ///< accept the event and report backpressure through the callback
+	QUEUE_LATEST  ///< drop the oldest queued events instead, BORE and EORE are always sent;
+		      ///< other queued events are discarded when the sender is destroyed
+      };
+      struct QueueStatus {
+	uint64_t bytes;    ///< bytes queued or being sent
+	uint64_t events;   ///< events queued or being sent
+	uint64_t dropped;  ///< events dropped since Connect
+	double latency_ms; ///< mean time from SendEvent until sent, since the last call
+      };
+      struct CompressionStatus {
+	CompressionCodec codec; ///< in use on the connection
+	uint64_t raw_bytes;     ///< size of the packets before compression, since Connect
+	uint64_t wire_bytes;    ///< size of the same packets as sent
+	double cpu_ms;          ///< time spent compressing
+      };
+
+      /// Type id in front of a packet carrying several events: uint32 count,
+      /// then each event as uint32 length and its serialization
+      static const uint32_t BATCH_ID = 0x48435442; // "BTCH"
+      /// Type id in front of a compressed packet: uint32 codec, uint32
+      /// uncompressed size, then the compressed packet
+      static const uint32_t COMPRESSED_ID = 0x52504d43; // "CMPR"
+      /// Largest uncompressed size of a compressed packet, as a multiple of
+      /// its compressed size; the receiver rejects larger claims
+      static const uint32_t MAX_COMPRESSION_RATIO = 1024;
+
       DataSender(const std::string & type, const std::string & name);
       ~DataSender();
+      /// Send from a thread of its own, through a queue of at most max_bytes;
+      /// 0 (default) sends on the calling thread. Takes effect at Connect.
+      void SetQueue(uint64_t max_bytes, QueuePolicy policy = QUEUE_BLOCK);
+      /// Called with true when the queue is full, with false once it has
+      /// drained to half of its size (QUEUE_SIGNAL only)
+      void SetBackpressureCallback(std::function<void(bool)> cb);
+      /// Packs consecutive events into packets of up to max_bytes, holding an
+      /// event back by at most max_delay_us; 0 (default) sends each event on
+      /// its own. Sends from a thread of its own and takes effect at Connect,
+      /// if the receiver can unpack such packets.
+      void SetBatching(uint32_t max_bytes, uint32_t max_delay_us = 1000);
+      bool IsAsync() const {return m_max_bytes > 0 || m_batch_bytes > 0;}
+      /// Compresses the packets, if the receiver supports the codec; takes
+      /// effect at Connect. The level is passed on to eudaq::Compress.
+      void SetCompression(CompressionCodec codec = CompressionCodec::LZ4, int level = 0);
+      /// How long stopping waits for the queued events to be sent, in ms;
+      /// the connection is dropped when it expires (default 10 s)
+      void SetStopTimeout(uint32_t ms);
+      QueueStatus GetQueueStatus();
+      CompressionStatus GetCompressionStatus();
       void Connect(const std::string & server);
       void SendEvent(EventSPC ev);
+      /// Sends an event serialized once for all its destinations
+      void SendEvent(SerializedEventSPC ev);
   private:
-      bool AsyncSending();
+      struct Packet{
+	SerializedEventSPC ev;
+	std::chrono::steady_clock::time_point tp;
+      };
+      void AsyncSending();
+      void StopSending();
+      void TakeCredit(uint64_t len);
+      void SendBatch(const std::vector<std::unique_ptr<Packet>> &pkts);
+      void SendData(const std::vector<GatherSerializer::Segment> &segs, uint64_t len);
       std::string m_type, m_name;
       std::unique_ptr<TransportClient> m_dataclient;
       uint64_t m_packetCounter;
-      std::future<bool> m_fut_async;
-      bool m_is_connected;
-      std::mutex m_mx_qu_ev; 
-      std::queue<EventSPC> m_qu_ev;
+      // credit based flow control, when the receiver offers it
+      bool m_credit_on;
+      int64_t m_credit;
+      uint64_t m_credit_window;
+      uint32_t m_batch_bytes;
+      uint32_t m_batch_us;
+      bool m_batch_on;
+      CompressionCodec m_codec;
+      CompressionCodec m_codec_on;
+      int m_level;
+      std::vector<uint8_t> m_raw, m_zip;
+      uint64_t m_cmp_raw;
+      uint64_t m_cmp_wire;
+      double m_cmp_ms;
+
+      uint64_t m_max_bytes;
+      uint64_t m_qu_limit; // m_max_bytes, or a default when only batching
+      QueuePolicy m_policy;
+      std::function<void(bool)> m_cb_backpressure;
+      std::thread m_thd_send;
+      std::mutex m_mx_qu_ev;
       std::condition_variable m_cv_not_empty;
+      std::condition_variable m_cv_space;
+      std::deque<std::unique_ptr<Packet>> m_qu_ev;
+      uint64_t m_qu_bytes;
+      uint64_t m_qu_events;
+      uint64_t m_dropped;
+      double m_latency_sum;
+      uint64_t m_latency_n;
+      bool m_backpressure;
+      bool m_exit;
+      bool m_sent_all; // the sending thread has finished
+      bool m_abort;    // the connection is being dropped
+      uint32_t m_stop_ms;
+      std::string m_error;
   };
 
 }
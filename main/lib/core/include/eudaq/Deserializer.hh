@@ -2,6 +2,8 @@
 #define EUDAQ_INCLUDED_Deserializer
 
 #include "eudaq/Serializable.hh"
+#include "eudaq/BlockView.hh"
+#include "eudaq/Serializer.hh"
 #include "eudaq/Time.hh"
 #include "eudaq/Exception.hh"
 #include "eudaq/Platform.hh"
@@ -9,6 +11,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <type_traits>
 
 namespace eudaq{
   class DLLEXPORT Deserializer {
@@ -33,6 +36,8 @@ namespace eudaq{
     }
       
     void read(unsigned char *dst, size_t size);
+    /// Read len bytes as a data block, implementations may avoid the copy
+    virtual BlockView ReadBlock(size_t len);
     void PreRead(uint32_t &t);
     void PreRead(uint8_t *dst, size_t size);
   protected:
@@ -40,6 +45,10 @@ namespace eudaq{
 
   private:
     template <typename T> friend struct ReadHelper;
+    template <typename T>
+    void read_vector(std::vector<T> &t, std::true_type);
+    template <typename T>
+    void read_vector(std::vector<T> &t, std::false_type);
     virtual void Deserialize(unsigned char *, size_t) = 0;
     virtual void PreDeserialize(unsigned char *, size_t) = 0;
   };
@@ -127,7 +136,18 @@ namespace eudaq{
     t = Time(sec, usec);
   }
 
+  template <> inline void Deserializer::read(BlockView &t) {
+    unsigned len = 0;
+    read(len);
+    t = ReadBlock(len);
+  }
+
   template <typename T> inline void Deserializer::read(std::vector<T> &t) {
+    read_vector(t, std::integral_constant<bool, BulkHelper<T>::value>());
+  }
+
+  template <typename T>
+  inline void Deserializer::read_vector(std::vector<T> &t, std::false_type) {
     unsigned len = 0;
     read(len);
     t.reserve(len);
@@ -136,6 +156,19 @@ namespace eudaq{
     }
   }
 
+  template <typename T>
+  inline void Deserializer::read_vector(std::vector<T> &t, std::true_type) {
+    unsigned len = 0;
+    read(len);
+    if (!len)
+      return;
+    size_t n0 = t.size();
+    t.resize(n0 + len);
+    uint8_t *dst = reinterpret_cast<uint8_t *>(&t[n0]);
+    Deserialize(dst, len * sizeof(T));
+    BulkHelper<T>::swap_bytes(dst, len);
+  }
+
   template <>
   inline void Deserializer::read<unsigned char>(std::vector<unsigned char> &t) {
     unsigned len = 0;
@@ -7,6 +7,7 @@
 #include <ostream>
 
 #include "eudaq/Serializable.hh"
+#include "eudaq/BlockView.hh"
 #include "eudaq/Serializer.hh"
 #include "eudaq/Deserializer.hh"
 #include "eudaq/Exception.hh"
@@ -47,6 +48,9 @@ namespace eudaq {
     // Event(const &&ev);
     
     Event(Deserializer & ds);
+    /// Back to the state of Event() (or Event(ds)), keeping allocated capacity
+    void Reset();
+    void Reset(Deserializer & ds);
     virtual void Serialize(Serializer &) const;
     virtual void Print(std::ostream & os, size_t offset = 0) const;
     
@@ -115,7 +119,10 @@ namespace eudaq {
     uint32_t GetRunNumber()const;
 
     //from RawdataEvent
+    /// Copy of a data block, prefer GetBlockView to avoid the copy
     std::vector<uint8_t> GetBlock(uint32_t i) const;
+    /// Shared, read-only view on a data block (empty if it does not exist)
+    BlockView GetBlockView(uint32_t i) const;
     size_t GetNumBlock() const;
     size_t NumBlocks() const;
     std::vector<uint32_t> GetBlockNumList() const;
@@ -123,22 +130,38 @@ namespace eudaq {
     /// Add a data block as std::vector
     template <typename T>
     size_t AddBlock(uint32_t id, const std::vector<T> &data){
-      m_blocks[id]=make_vector(data);
+      m_blocks[id]=BlockView(make_vector(data));
       return m_blocks.size();
     }
 
     /// Add a data block as array with given size
     template <typename T>
     size_t AddBlock(uint32_t id, const T *data, size_t bytes){
-      m_blocks[id]=make_vector(data, bytes);
+      m_blocks[id]=BlockView(make_vector(data, bytes));
+      return m_blocks.size();
+    }
+
+    /// Add a data block by taking over the buffer, without a copy
+    size_t AddBlock(uint32_t id, std::vector<uint8_t> &&data){
+      m_blocks[id]=BlockView(std::move(data));
+      return m_blocks.size();
+    }
+
+    /// Add a data block sharing the buffer of an existing view
+    size_t AddBlock(uint32_t id, BlockView data){
+      m_blocks[id]=std::move(data);
       return m_blocks.size();
     }
 
     template <typename T>
     void AppendBlock(size_t index, const std::vector<T> &data) {
       auto &&src = make_vector(data);
-      auto &&dst = m_blocks[index];
+      auto &blk = m_blocks[index];
+      std::vector<uint8_t> dst;
+      dst.reserve(blk.size() + src.size());
+      dst.insert(dst.end(), blk.begin(), blk.end());
       dst.insert(dst.end(), src.begin(), src.end());
+      blk = BlockView(std::move(dst));
     }
 
     //TODO: remove, clearn up
@@ -163,6 +186,9 @@ namespace eudaq {
       return std::vector<uint8_t>(ptr, ptr + data.size() * sizeof(T));
     }
     
+  private:
+    void Read(Deserializer & ds);
+
   private:
     uint32_t m_type;
     uint32_t m_version;
@@ -176,7 +202,7 @@ namespace eudaq {
     uint64_t m_ts_end;
     std::string m_dspt;
     std::map<std::string, std::string> m_tags;
-    std::map<uint32_t, std::vector<uint8_t>> m_blocks;
+    std::map<uint32_t, BlockView> m_blocks;
     std::vector<EventSPC> m_sub_events;
   };
 }
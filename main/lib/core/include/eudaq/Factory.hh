@@ -7,6 +7,8 @@
 #include <functional>
 #include <cstdint>
 
+#include "eudaq/ObjectPool.hh"
+
 namespace eudaq{
 
   template <typename BASE>
@@ -41,12 +43,25 @@ namespace eudaq{
     template <typename DERIVED, typename... ARGS>
     static std::uint64_t
     Register(std::uint32_t id);
+
+    // like Register, but the objects are recycled through ObjectPool<DERIVED>
+    // while pooling is enabled (SetPoolCapacity)
+    template <typename DERIVED, typename... ARGS>
+    static std::uint64_t
+    RegisterPooled(std::uint32_t id);
     
   private:
     template <typename DERIVED, typename... ARGS>
       static UP_BASE MakerFun(ARGS&& ...args){
       return UP_BASE(new DERIVED(std::forward<ARGS>(args)...), [](BASE *p) {delete p; });
     }
+    template <typename DERIVED, typename... ARGS>
+      static UP_BASE PooledMakerFun(ARGS&& ...args){
+      if(!GetPoolCapacity())
+	return MakerFun<DERIVED, ARGS...>(std::forward<ARGS>(args)...);
+      return UP_BASE(ObjectPool<DERIVED>::Instance().Acquire(std::forward<ARGS>(args)...),
+		     [](BASE *p) {ObjectPool<DERIVED>::Instance().Release(static_cast<DERIVED*>(p)); });
+    }
   };
 
   template <typename BASE>
@@ -107,6 +122,15 @@ namespace eudaq{
     return reinterpret_cast<std::uintptr_t>(&ins);
   }
 
+  template <typename BASE>
+  template <typename DERIVED, typename... ARGS>
+  std::uint64_t
+  Factory<BASE>::RegisterPooled(std::uint32_t id){
+    auto &ins = Instance<ARGS&&...>();
+    ins[id] = &PooledMakerFun<DERIVED, ARGS&&...>;
+    return reinterpret_cast<std::uintptr_t>(&ins);
+  }
+
 }
 
 #endif
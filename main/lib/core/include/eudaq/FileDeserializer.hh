@@ -17,6 +17,10 @@ namespace eudaq{
     ~FileDeserializer();
     virtual bool HasData();
     bool ReadEvent(int ver, EventSP &ev, size_t skip = 0);
+    /// Byte offset in the file of the next byte to be deserialized
+    uint64_t Tell();
+    /// Continue deserializing from the given byte offset in the file
+    void Seek(uint64_t offset);
     
   private:
     virtual void Deserialize(uint8_t *data, size_t len);
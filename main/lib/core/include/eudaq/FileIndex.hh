@@ -0,0 +1,61 @@
+#ifndef EUDAQ_INCLUDED_FileIndex
+#define EUDAQ_INCLUDED_FileIndex
+
+#include "eudaq/Platform.hh"
+#include "eudaq/Serializer.hh"
+
+#include <string>
+#include <vector>
+
+namespace eudaq {
+
+  /** In-memory copy of the sidecar index of a native data file.
+   * Each entry maps the event number, trigger number and begin timestamp
+   * of an event to the byte offset where the event starts in the data file.
+   * The index file is named after the data file with an additional ".idx"
+   * and consists of a short header followed by fixed size little-endian
+   * records, so that it can be appended to while the data file is written.
+   */
+  class DLLEXPORT FileIndex {
+  public:
+    struct Entry {
+      uint32_t event_n;
+      uint32_t trigger_n;
+      uint64_t timestamp;
+      uint64_t offset;
+    };
+
+    FileIndex();
+    static std::string IndexPath(const std::string &datafile);
+    static void WriteHeader(Serializer &ser);
+    static void WriteEntry(Serializer &ser, const Entry &e);
+
+    /// Read an index file, returns false if it does not exist or is invalid
+    bool Load(const std::string &path);
+    void Save(const std::string &path) const;
+    void Add(const Entry &e);
+    void Clear();
+    size_t Size() const { return m_entries.size(); }
+    const std::vector<Entry> &Entries() const { return m_entries; }
+
+    /// The first entry with a value not less than the requested one,
+    /// or nullptr if there is none
+    const Entry *FindEvent(uint32_t event_n) const;
+    const Entry *FindTrigger(uint32_t trigger_n) const;
+    const Entry *FindTimestamp(uint64_t timestamp) const;
+    /// Whether the key never decreases through the file, so that no event
+    /// beyond the first one above a value can be in range again
+    bool EventsSorted() const { return m_sorted_ev; }
+    bool TriggersSorted() const { return m_sorted_tg; }
+    bool TimestampsSorted() const { return m_sorted_ts; }
+
+  private:
+    std::vector<Entry> m_entries;
+    bool m_sorted_ev;
+    bool m_sorted_tg;
+    bool m_sorted_ts;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_FileIndex
@@ -30,6 +30,17 @@ namespace eudaq{
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual EventSPC GetNextEvent() {return nullptr;};
+    // Position the reader before the first event whose number, trigger
+    // number or begin timestamp is not less than the requested value.
+    // They return false if the reader can not seek, which leaves it unmoved.
+    virtual bool Seek(uint32_t /*event_n*/) {return false;};
+    virtual bool SeekTrigger(uint32_t /*trigger_n*/) {return false;};
+    virtual bool SeekTimestamp(uint64_t /*timestamp*/) {return false;};
+    // Readers which can split the file into serialized events without
+    // deserializing them return true here, GetNextRecord then hands out the
+    // serialization of the next event (which GetNextEvent would return)
+    virtual bool CanReadRecords() {return false;};
+    virtual bool GetNextRecord(BlockView &/*record*/) {return false;};
     static FileReaderSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
@@ -12,15 +12,30 @@
 namespace eudaq {
   class DLLEXPORT FileSerializer : public Serializer {
   public:
-    FileSerializer(const std::string &fname, bool overwrite = false);
+    /** With direct, the data bypasses the page cache (O_DIRECT, Linux only):
+     * it is collected into aligned blocks which are written as they fill up,
+     * Flush writes the last partial block through the page cache so that the
+     * file is always complete. Where direct I/O is not available, the file is
+     * written as usual.
+     */
+    FileSerializer(const std::string &fname, bool overwrite = false,
+                   bool direct = false);
     virtual void Flush();
+    /// Flush and wait until the data is stored on the disk (fdatasync)
+    void Sync();
     uint64_t FileBytes() const { return m_filebytes; }
+    bool IsDirect() const { return m_direct_fd >= 0; }
     ~FileSerializer();
 
   private:
     virtual void Serialize(const uint8_t *data, size_t len);
+    void WriteDirect(size_t len);
     FILE *m_file;
     uint64_t m_filebytes;
+    int m_direct_fd;
+    uint8_t *m_dbuf;   // aligned, holds the data from file offset m_doff on
+    size_t m_dlen;
+    uint64_t m_doff;
   };
 
 }
@@ -3,9 +3,11 @@
 
 #include "eudaq/Factory.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/SerializedEvent.hh"
 #include "eudaq/Configuration.hh"
 
 #include <vector>
+#include <map>
 #include <string>
 #include <memory>
 
@@ -34,7 +36,12 @@ namespace eudaq {
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual void WriteEvent(EventSPC ) {};
+    /// Writes an event which may already be serialized for other destinations,
+    /// writers storing the serialization override it to reuse the bytes
+    virtual void WriteSerialized(SerializedEventSPC ev) {WriteEvent(ev->GetEventSPC());};
     virtual uint64_t FileBytes() const {return 0;};
+    virtual void Flush() {};
+    virtual std::map<std::string, std::string> GetStatusTags() {return {};};
     static FileWriterSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
@@ -0,0 +1,50 @@
+#ifndef EUDAQ_INCLUDED_GatherSerializer
+#define EUDAQ_INCLUDED_GatherSerializer
+
+#include "eudaq/Serializer.hh"
+#include "eudaq/BlockView.hh"
+
+#include <vector>
+
+namespace eudaq {
+
+  /** A Serializer producing a list of memory segments for scatter-gather
+   * output. Data blocks of at least min_block bytes are not copied, the
+   * segments point into the blocks themselves and keep them alive; all
+   * other data is collected in an internal buffer.
+   */
+  class DLLEXPORT GatherSerializer : public Serializer {
+  public:
+    struct Segment {
+      const uint8_t *data;
+      size_t size;
+    };
+
+    explicit GatherSerializer(size_t min_block = 4096);
+    void clear();
+    /// Total number of bytes serialized
+    size_t size() const { return m_size; }
+    /// The serialized data, valid until the next write to the serializer
+    std::vector<Segment> Segments() const;
+    /// Copy of the serialized data in one contiguous buffer
+    std::vector<uint8_t> ToVector() const;
+
+  private:
+    void Serialize(const uint8_t *data, size_t len) override;
+    void SerializeBlock(const BlockView &b) override;
+
+    // segments are stored as offsets into m_buf, or as a referenced block
+    struct Part {
+      size_t offset;
+      size_t size;
+      BlockView block;
+    };
+    size_t m_min_block;
+    size_t m_size;
+    std::vector<uint8_t> m_buf;
+    std::vector<Part> m_parts;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_GatherSerializer
@@ -0,0 +1,40 @@
+#ifndef EUDAQ_INCLUDED_MappedFileDeserializer
+#define EUDAQ_INCLUDED_MappedFileDeserializer
+
+#include "eudaq/Deserializer.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Platform.hh"
+#include <memory>
+#include <string>
+
+namespace eudaq{
+  class FileMapping;
+
+  /** Deserializer reading a file through a read-only memory mapping.
+   * Fields are copied straight out of the mapped pages, and data blocks
+   * (ReadBlock) are views on the mapping itself, which stays alive for as
+   * long as any of these views exists. If the end of the mapping is
+   * reached while the file is still growing, the file is mapped again from
+   * the current position on. Reading beyond the end of a file which has
+   * not grown for 100 ms throws a FileReadException.
+   */
+  class DLLEXPORT MappedFileDeserializer : public Deserializer {
+  public:
+    MappedFileDeserializer(const std::string &fname);
+    ~MappedFileDeserializer();
+    bool HasData() override;
+    BlockView ReadBlock(size_t len) override;
+    uint64_t Tell() const { return m_pos; }
+    void Seek(uint64_t offset);
+
+  private:
+    void Deserialize(uint8_t *data, size_t len) override;
+    void PreDeserialize(uint8_t *data, size_t len) override;
+    const uint8_t *Require(size_t len);
+    bool Remap();
+    std::string m_filename;
+    std::shared_ptr<const FileMapping> m_map;
+    uint64_t m_pos;
+  };
+}
+#endif // EUDAQ_INCLUDED_MappedFileDeserializer
@@ -0,0 +1,49 @@
+#ifndef EUDAQ_INCLUDED_NativeFormat
+#define EUDAQ_INCLUDED_NativeFormat
+
+#include "eudaq/Serializer.hh"
+#include "eudaq/Deserializer.hh"
+#include "eudaq/Event.hh"
+#include "eudaq/SerializedEvent.hh"
+#include "eudaq/Platform.hh"
+
+namespace eudaq {
+
+  /** Framing of the native file format.
+   * Since version 2 a native file starts with a header (uint32 magic, uint32
+   * version) and every event is stored as a record: uint32 payload length,
+   * uint32 event type, payload (the Event serialization). Records can be
+   * skipped without deserializing them and a truncated last record can be
+   * detected. Version 1 (legacy) files are a bare concatenation of serialized
+   * events without header. Version 1 is written unless version 2 is asked
+   * for (EUDAQ_FW_FORMAT_VERSION = 2), as older readers cannot read version 2.
+   */
+  class DLLEXPORT NativeFormat {
+  public:
+    static const uint32_t MAGIC = 0x51445545; // "EUDQ"
+    static const uint32_t VERSION = 2;         // the newest version
+    static const uint32_t DEFAULT_VERSION = 1; // written by default
+    static const uint32_t HEADER_SIZE = 8;
+    static const uint32_t RECORD_PREFIX_SIZE = 8;
+
+    /// The prefix of a record and the fixed size header of its event
+    struct RecordInfo {
+      uint32_t length;
+      uint32_t type;
+      uint32_t event_n;
+      uint32_t trigger_n;
+      uint64_t timestamp;
+    };
+
+    static void WriteHeader(Serializer &ser);
+    static void WriteRecord(Serializer &ser, const Event &ev);
+    /// Same as above, from the serialization of the event
+    static void WriteRecord(Serializer &ser, const SerializedEvent &ev);
+    /// Consume the file header if there is one, returns the format version
+    static uint32_t ReadHeader(Deserializer &des);
+    /// Look at the next record without consuming it
+    static void PeekRecord(Deserializer &des, RecordInfo &info);
+  };
+}
+
+#endif // EUDAQ_INCLUDED_NativeFormat
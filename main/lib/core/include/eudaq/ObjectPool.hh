@@ -0,0 +1,107 @@
+#ifndef EUDAQ_INCLUDED_ObjectPool
+#define EUDAQ_INCLUDED_ObjectPool
+
+#include "eudaq/Platform.hh"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace eudaq {
+
+  /// Number of idle objects kept by each pool, 0 (default) disables pooling;
+  /// lowering it frees the idle objects beyond the new capacity
+  void DLLEXPORT SetPoolCapacity(size_t n);
+  /// The capacity asked for by one of several components of the process,
+  /// the largest request is used
+  void DLLEXPORT SetPoolCapacity(const void *owner, size_t n);
+  size_t DLLEXPORT GetPoolCapacity();
+
+  /// The pools of all types, known to SetPoolCapacity
+  class DLLEXPORT ObjectPoolBase {
+  public:
+    /// Frees the idle objects beyond n
+    virtual void Trim(size_t n) = 0;
+  protected:
+    ObjectPoolBase();
+    virtual ~ObjectPoolBase() = default;
+  };
+
+  /** A thread-safe free list of recycled objects of type T.
+   * Released objects are reset and kept with their allocated capacity,
+   * Acquire hands them out again instead of constructing new ones.
+   * T must provide Reset() bringing it back to the default-constructed
+   * state, and Reset(ARGS...) for each constructor used through Acquire.
+   */
+  template <typename T>
+  class ObjectPool : public ObjectPoolBase {
+  public:
+    static ObjectPool &Instance() {
+      // never destroyed, objects may be released during static destruction
+      static ObjectPool *pool = new ObjectPool;
+      return *pool;
+    }
+
+    template <typename... ARGS>
+    T *Acquire(ARGS&& ...args) {
+      std::unique_ptr<T> p;
+      {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (!m_free.empty()) {
+          p = std::move(m_free.back());
+          m_free.pop_back();
+        }
+      }
+      if (!p)
+        return new T(std::forward<ARGS>(args)...);
+      Reinit(*p, std::forward<ARGS>(args)...);
+      return p.release();
+    }
+
+    void Release(T *obj) {
+      std::unique_ptr<T> p(obj);
+      if (!p || !GetPoolCapacity())
+        return;
+      // drop the references held by the object before it becomes idle
+      p->Reset();
+      std::lock_guard<std::mutex> lk(m_mtx);
+      if (m_free.size() < GetPoolCapacity())
+        m_free.push_back(std::move(p));
+    }
+
+    size_t Size() {
+      std::lock_guard<std::mutex> lk(m_mtx);
+      return m_free.size();
+    }
+
+    void Trim(size_t n) override {
+      std::vector<std::unique_ptr<T>> excess;
+      {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_free.size() <= n)
+          return;
+        excess.reserve(m_free.size() - n);
+        for (size_t i = n; i < m_free.size(); i++)
+          excess.push_back(std::move(m_free[i]));
+        m_free.resize(n);
+      }
+      // destroyed outside of the lock
+    }
+
+  private:
+    ObjectPool() = default;
+    static void Reinit(T &) {}
+    template <typename A, typename... ARGS>
+    static void Reinit(T &obj, A &&a, ARGS&& ...args) {
+      obj.Reset(std::forward<A>(a), std::forward<ARGS>(args)...);
+    }
+
+    std::mutex m_mtx;
+    std::vector<std::unique_ptr<T>> m_free;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_ObjectPool
@@ -0,0 +1,72 @@
+#ifndef EUDAQ_INCLUDED_ParallelFileReader
+#define EUDAQ_INCLUDED_ParallelFileReader
+
+#include "eudaq/FileReader.hh"
+#include "eudaq/BlockView.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eudaq {
+
+  /** A FileReader decorator reading ahead in background threads.
+   * A prefetch thread reads from the wrapped reader while the consumer is
+   * busy. If the wrapped reader hands out serialized records (CanReadRecords),
+   * these are deserialized by a pool of worker threads, otherwise the
+   * prefetch thread reads complete events. The events are returned in file
+   * order, and the data read ahead is limited to a memory budget.
+   */
+  class DLLEXPORT ParallelFileReader : public FileReader {
+  public:
+    ParallelFileReader(FileReaderSP reader, uint32_t n_workers = 0,
+                       uint64_t budget_bytes = 64 * 1024 * 1024);
+    ~ParallelFileReader() override;
+    EventSPC GetNextEvent() override;
+    bool Seek(uint32_t event_n) override;
+    bool SeekTrigger(uint32_t trigger_n) override;
+    bool SeekTimestamp(uint64_t timestamp) override;
+
+  private:
+    struct Job {
+      uint64_t seq;
+      BlockView record;
+    };
+    struct Result {
+      EventSPC ev;
+      uint64_t bytes;
+      std::exception_ptr err;
+    };
+    void Start();
+    void Stop();
+    void Reset();
+    void Prefetch();
+    void Work();
+
+    FileReaderSP m_reader;
+    uint32_t m_n_workers;
+    uint64_t m_budget;
+    bool m_records;
+    bool m_running;
+    bool m_stop;
+    bool m_eof;
+    std::exception_ptr m_prefetch_err;
+    uint64_t m_seq_in;
+    uint64_t m_seq_out;
+    uint64_t m_bytes;
+    std::deque<Job> m_jobs;
+    std::map<uint64_t, Result> m_results;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_prefetch;
+    std::condition_variable m_cv_work;
+    std::condition_variable m_cv_out;
+    std::thread m_thd_prefetch;
+    std::vector<std::thread> m_thd_workers;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_ParallelFileReader
@@ -26,6 +26,16 @@ using std::size_t;
 
 #define EUDAQ_PLATFORM_IS(P) (EUDAQ_PLATFORM == PF_##P)
 
+// The serialization format is little-endian, on such hosts arithmetic data
+// can be copied to and from the wire format without conversion
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#define EUDAQ_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#elif defined(_WIN32)
+#define EUDAQ_LITTLE_ENDIAN 1
+#else
+#define EUDAQ_LITTLE_ENDIAN 0
+#endif
+
 #if EUDAQ_PLATFORM_IS(WIN32)
 
 #ifdef EUDAQ_CORE_EXPORTS
@@ -40,6 +40,9 @@ namespace eudaq {
     virtual void DoReset(){};
     virtual void DoTerminate(){};
     virtual void DoStatus(){};
+    /// With EUDAQ_DS_POLICY=signal, called with true when a send queue is
+    /// full and with false once it has drained; from the sending threads.
+    virtual void DoBackpressure(bool /*busy*/){};
     
     void SendEvent(EventSP ev);
     static ProducerSP Make(const std::string &code_name, const std::string &run_name,
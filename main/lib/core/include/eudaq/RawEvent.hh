@@ -8,7 +8,9 @@ namespace eudaq {
   class DLLEXPORT RawEvent : public Event {
   public:
     RawEvent();
-    RawEvent(Deserializer &);    
+    RawEvent(Deserializer &);
+    void Reset();
+    void Reset(Deserializer &);
     static const uint32_t m_id_factory = cstr2hash("RawEvent");
   };
   using RawDataEvent = RawEvent;
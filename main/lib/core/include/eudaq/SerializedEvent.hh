@@ -0,0 +1,38 @@
+#ifndef EUDAQ_INCLUDED_SerializedEvent
+#define EUDAQ_INCLUDED_SerializedEvent
+
+#include "eudaq/Event.hh"
+#include "eudaq/GatherSerializer.hh"
+#include "eudaq/Platform.hh"
+
+#include <memory>
+#include <mutex>
+
+namespace eudaq {
+  class SerializedEvent;
+  using SerializedEventSPC = std::shared_ptr<const SerializedEvent>;
+
+  /** An event with its serialization, shared by all the destinations the
+   * event is sent or written to. The event is serialized once, on the first
+   * call to Data(), from whichever thread gets there first. The event must
+   * not be modified afterwards.
+   */
+  class DLLEXPORT SerializedEvent {
+  public:
+    explicit SerializedEvent(EventSPC ev);
+    static SerializedEventSPC Make(EventSPC ev);
+    const Event &GetEvent() const {return *m_ev;}
+    EventSPC GetEventSPC() const {return m_ev;}
+    const GatherSerializer &Data() const;
+    size_t size() const {return Data().size();}
+    /// Appends the serialized event to ser
+    void WriteTo(Serializer &ser) const;
+
+  private:
+    EventSPC m_ev;
+    mutable std::once_flag m_once;
+    mutable GatherSerializer m_ser;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_SerializedEvent
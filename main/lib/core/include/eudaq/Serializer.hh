@@ -3,6 +3,7 @@
 
 
 #include "eudaq/Serializable.hh"
+#include "eudaq/BlockView.hh"
 #include "eudaq/Time.hh"
 #include "eudaq/Exception.hh"
 #include "eudaq/Platform.hh"
@@ -10,6 +11,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
+#include <utility>
+#include <type_traits>
 
 namespace eudaq {
 
@@ -17,6 +21,29 @@ namespace eudaq {
     const char *what() const throw() { return "InterruptedException"; }
   };
 
+  /** Arithmetic types whose serialized form is their little-endian memory
+   * representation, so that whole arrays of them can be (de)serialized in
+   * one go instead of element by element.
+   */
+  template <typename T> struct BulkHelper {
+    static const bool value = std::is_arithmetic<T>::value &&
+      !std::is_same<T, bool>::value && !std::is_same<T, long double>::value;
+
+    /// Convert n values between host and little-endian byte order in place
+    static void swap_bytes(uint8_t *data, size_t n) {
+#if !EUDAQ_LITTLE_ENDIAN
+      for (size_t i = 0; i < n; ++i) {
+        uint8_t *p = data + i * sizeof(T);
+        for (size_t b = 0; b < sizeof(T) / 2; ++b)
+          std::swap(p[b], p[sizeof(T) - 1 - b]);
+      }
+#else
+      (void)data;
+      (void)n;
+#endif
+    }
+  };
+
   class DLLEXPORT Serializer {
   public:
     virtual ~Serializer();
@@ -31,7 +58,14 @@ namespace eudaq {
     virtual uint64_t GetCheckSum();
   private:
     template <typename T> friend struct WriteHelper;
+    template <typename T>
+    void write_vector(const std::vector<T> &t, std::true_type);
+    template <typename T>
+    void write_vector(const std::vector<T> &t, std::false_type);
     virtual void Serialize(const uint8_t *, size_t) = 0;
+    /// Called for the content of data blocks, which serializers may keep a
+    /// reference to instead of copying it
+    virtual void SerializeBlock(const BlockView &b) { Serialize(b.data(), b.size()); }
   };
 
   template <typename T> struct WriteHelper {
@@ -104,6 +138,11 @@ namespace eudaq {
     write((int)t.GetTimeval().tv_usec);
   }
 
+  template <> inline void Serializer::write(const BlockView &t) {
+    write((unsigned)t.size());
+    SerializeBlock(t);
+  }
+
   template <> inline void Serializer::write(const std::vector<bool> &t) {
     unsigned len = t.size();
     write(len);
@@ -113,6 +152,11 @@ namespace eudaq {
   }
 
   template <typename T> inline void Serializer::write(const std::vector<T> &t) {
+    write_vector(t, std::integral_constant<bool, BulkHelper<T>::value>());
+  }
+
+  template <typename T>
+  inline void Serializer::write_vector(const std::vector<T> &t, std::false_type) {
     unsigned len = t.size();
     write(len);
     for (size_t i = 0; i < len; ++i) {
@@ -120,6 +164,22 @@ namespace eudaq {
     }
   }
 
+  template <typename T>
+  inline void Serializer::write_vector(const std::vector<T> &t, std::true_type) {
+    unsigned len = t.size();
+    write(len);
+    if (!len)
+      return;
+#if EUDAQ_LITTLE_ENDIAN
+    Serialize(reinterpret_cast<const uint8_t *>(t.data()), len * sizeof(T));
+#else
+    std::vector<uint8_t> buf(len * sizeof(T));
+    std::memcpy(buf.data(), t.data(), buf.size());
+    BulkHelper<T>::swap_bytes(buf.data(), len);
+    Serialize(buf.data(), buf.size());
+#endif
+  }
+
   template <>
   inline void
   Serializer::write<uint8_t>(const std::vector<uint8_t> &t) {
@@ -21,8 +21,14 @@ namespace eudaq {
   public:
     StandardEvent();
     StandardEvent(Deserializer &);
+    /// Back to the state of a new event, the planes are kept for reuse
+    void Reset();
+    void Reset(Deserializer &);
 
     StandardPlane &AddPlane(const StandardPlane &);
+    /// Add a new, empty plane, reusing the storage of a recycled one
+    StandardPlane &AddPlane(uint32_t id, const std::string &type,
+                            const std::string &sensor = "");
     size_t NumPlanes() const;
     const StandardPlane &GetPlane(size_t i) const;
     StandardPlane &GetPlane(size_t i);
@@ -71,7 +77,11 @@ namespace eudaq {
     void SetDetectorType(std::string type) { detector_type = type; }
 
   private:
+    void Read(Deserializer &);
+    StandardPlane &NextPlane();
+
     std::vector<StandardPlane> m_planes;
+    std::vector<StandardPlane> m_spare_planes;
     uint64_t time_begin{0}, time_end{0};
     std::string detector_type;
   };
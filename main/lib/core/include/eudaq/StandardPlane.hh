@@ -23,16 +23,31 @@ namespace eudaq {
       FLAG_WITHSUBMAT = 0x20000, // Include Submatrix ID per pixel
       FLAG_DIFFCOORDS = 0x40000 // Each frame can have different coordinates (in ZS mode)
     };
+    // Storage type of the pixel values. The pixel column starts with the
+    // type set by SetPixelType (default PIXEL_UINT8) and is widened when a
+    // value does not fit, so values are always stored without loss.
+    enum PIXELTYPE {
+      PIXEL_UINT8 = 0,
+      PIXEL_UINT16 = 1,
+      PIXEL_INT32 = 2,
+      PIXEL_DOUBLE = 3
+    };
+    // value types of the accessors, the storage is more compact
     typedef double pixel_t;
     typedef double coord_t;
     StandardPlane(uint32_t id, const std::string &type,
                   const std::string &sensor = "");
     StandardPlane(Deserializer &);
     StandardPlane();
+    // Back to the state of a new plane, keeping the capacity of the columns
+    void Reset(uint32_t id, const std::string &type, const std::string &sensor = "");
+    void Reset(Deserializer &);
     void Serialize(Serializer &) const;
     void SetSizeRaw(uint32_t w, uint32_t h, uint32_t frames = 1, int flags = 0);
     void SetSizeZS(uint32_t w, uint32_t h, uint32_t npix, uint32_t frames = 1,
                    int flags = 0);
+    void SetPixelType(PIXELTYPE type);
+    PIXELTYPE GetPixelType() const;
 
     template <typename T>
       void SetPixel(uint32_t index, uint32_t x, uint32_t y, T pix,
@@ -50,6 +65,9 @@ namespace eudaq {
 		    uint32_t frame) {
       SetPixelHelper(index, x, y, (double)pix, 0, false, frame);
     }
+    // The frames are stored one after the other: pushing to the last frame
+    // appends, pushing to an earlier one moves the pixels of the later
+    // frames (O(n)), fill multi-frame planes frame by frame.
     template <typename T>
       void PushPixel(uint32_t x, uint32_t y, T pix, uint64_t time_ps = 0, bool pivot = false,
 		     uint32_t frame = 0) {
@@ -91,18 +109,19 @@ namespace eudaq {
     // defined for short, int, double
     template <typename T> std::vector<T> GetPixels() const {
       SetupResult();
-      std::vector<T> result(m_result_pix->size());
+      std::vector<T> result(HitPixels());
       for (size_t i = 0; i < result.size(); ++i) {
-	result[i] = static_cast<T>((*m_result_pix)[i] * Polarity());
+	result[i] = static_cast<T>(GetPixel(i) * Polarity());
       }
       return result;
     }
-    const std::vector<coord_t> &XVector(uint32_t frame) const;
-    const std::vector<coord_t> &XVector() const;
-    const std::vector<coord_t> &YVector(uint32_t frame) const;
-    const std::vector<coord_t> &YVector() const;
-    const std::vector<pixel_t> &PixVector(uint32_t frame) const;
-    const std::vector<pixel_t> &PixVector() const;
+    // copies of the columns, prefer GetX/GetY/GetPixel in loops
+    std::vector<coord_t> XVector(uint32_t frame) const;
+    std::vector<coord_t> XVector() const;
+    std::vector<coord_t> YVector(uint32_t frame) const;
+    std::vector<coord_t> YVector() const;
+    std::vector<pixel_t> PixVector(uint32_t frame) const;
+    std::vector<pixel_t> PixVector() const;
 
     void SetXSize(uint32_t x);
     void SetYSize(uint32_t y);
@@ -128,8 +147,22 @@ namespace eudaq {
     void Print(std::ostream &) const;
     void Print(std::ostream &os ,size_t offset) const;
   private:
-    const std::vector<pixel_t> &
-      GetFrame(const std::vector<std::vector<pixel_t>> &v, uint32_t f) const;
+    void ReadLegacy(Deserializer &ds);
+    uint32_t CoordFrames() const;
+    uint32_t CoordIndex(uint32_t index, uint32_t frame) const;
+    uint32_t PixIndex(uint32_t index, uint32_t frame) const;
+    uint32_t ResultCoordIndex(uint32_t index) const;
+    size_t NumCoords() const;
+    double CoordX(size_t c) const;
+    double CoordY(size_t c) const;
+    void SetCoord(size_t c, double x, double y);
+    void InsertCoord(size_t c, double x, double y);
+    void WidenCoords();
+    double PixValue(size_t i) const;
+    void SetPixValue(size_t i, double pix);
+    void InsertPixValue(size_t i, double pix);
+    void WidenPixels(double pix);
+    void ConvertPixels(PIXELTYPE type);
     void SetupResult() const;
 
     std::string m_type;
@@ -142,28 +175,39 @@ namespace eudaq {
 
     // Timestamp of this plane in picoseconds
     uint64_t m_timestamp{};
-    std::vector<std::vector<pixel_t>> m_pix;
-    std::vector<std::vector<std::vector<double>>> m_waveform;
-    std::vector<std::vector<double>> m_waveform_x0;
-    std::vector<std::vector<double>> m_waveform_dx;
-    std::vector<std::vector<coord_t>> m_x, m_y;
-    std::vector<std::vector<uint64_t>> m_time;
-    std::vector<std::vector<bool>> m_pivot;
-    std::vector<uint32_t> m_mat;
 
-    mutable const std::vector<pixel_t> *m_result_pix;
-    mutable const std::vector<coord_t> *m_result_x, *m_result_y;
-    mutable const std::vector<uint64_t> *m_result_time;
-    mutable const std::vector<std::vector<double>> *m_result_waveform;
-    mutable const std::vector<double> *m_result_waveform_x0;
-    mutable const std::vector<double> *m_result_waveform_dx;
-
-    mutable std::vector<pixel_t> m_temp_pix;
-    mutable std::vector<coord_t> m_temp_x, m_temp_y;
-    mutable std::vector<uint64_t> m_temp_time;
-    mutable std::vector<std::vector<double>> m_temp_waveform;
-    mutable std::vector<double> m_temp_waveform_x0;
-    mutable std::vector<double> m_temp_waveform_dx;
+    // Hits are stored as flat columns. The pixel values of frame f are
+    // [m_offsets[f], m_offsets[f+1]) in the active pixel column. The
+    // coordinate columns (x, y, pivot, time, waveforms) hold one entry per
+    // pixel value with FLAG_DIFFCOORDS, otherwise the entries of frame 0.
+    std::vector<uint32_t> m_offsets;
+    PIXELTYPE m_pixtype;
+    PIXELTYPE m_pixtype_min;
+    std::vector<uint8_t> m_pix_u8;
+    std::vector<uint16_t> m_pix_u16;
+    std::vector<int32_t> m_pix_i32;
+    std::vector<double> m_pix_f64;
+    // coordinates fit 16 bits, otherwise (legacy files) they are kept as
+    // doubles in m_xw, m_yw instead
+    bool m_coord_wide{};
+    std::vector<uint16_t> m_x, m_y;
+    std::vector<double> m_xw, m_yw;
+    std::vector<uint8_t> m_pivot; // only with FLAG_WITHPIVOT
+    std::vector<uint32_t> m_mat;
+    // optional columns, empty until the first non-default value is set
+    std::vector<uint64_t> m_time;
+    std::vector<std::vector<double>> m_waveform;
+    std::vector<double> m_waveform_x0;
+    std::vector<double> m_waveform_dx;
+
+    // The combined result of all frames (SetupResult). It is either frame 0
+    // as stored, or a list of pixel value and coordinate indices, with the
+    // values computed for CDS.
+    mutable bool m_result;
+    mutable bool m_result_direct;
+    mutable std::vector<uint32_t> m_result_pix;
+    mutable std::vector<uint32_t> m_result_coord;
+    mutable std::vector<double> m_result_value;
   };
 
 } // namespace eudaq
@@ -0,0 +1,86 @@
+#ifndef EUDAQ_INCLUDED_StdEventBatchConverter
+#define EUDAQ_INCLUDED_StdEventBatchConverter
+
+#include "eudaq/StdEventConverter.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eudaq {
+
+  /** Converts batches of events to StandardEvents on a pool of threads.
+   * Each worker has its own StdEventConversionContext. Events whose
+   * converters are all stateless (StdEventConverter::IsStateless) are
+   * converted by whichever worker is free, the others are pinned to one
+   * worker per stream number and converted there in order, so that the
+   * per-stream converter state stays consistent. The sub-events of a packet
+   * are converted separately, each on the worker of its own stream, and
+   * merged in sub-event order: the planes are appended, tags and header
+   * fields set by a later sub-event replace those of an earlier one. The
+   * results keep the order of the input.
+   */
+  class DLLEXPORT StdEventBatchConverter {
+  public:
+    explicit StdEventBatchConverter(ConfigurationSPC conf = nullptr, uint32_t n_workers = 0);
+    ~StdEventBatchConverter();
+    StdEventBatchConverter(const StdEventBatchConverter&) = delete;
+    StdEventBatchConverter& operator = (const StdEventBatchConverter&) = delete;
+    void SetConfiguration(ConfigurationSPC conf);
+    ConfigurationSPC GetConfiguration() const {return m_conf;}
+    uint32_t GetNumWorkers() const {return m_n_workers;}
+
+    /// Converts in[i] into a new out[i] and returns the result of each
+    /// conversion. If converters throw, the whole batch is still converted;
+    /// the exception of each event is stored in errors[i] (nullptr if none)
+    /// if given, otherwise the exception of the first failing event is rethrown.
+    std::vector<bool> ConvertBatch(const std::vector<EventSPC> &in, std::vector<StdEventSP> &out,
+				   std::vector<std::exception_ptr> *errors = nullptr);
+
+  private:
+    /// A (sub-)event converted by one worker
+    struct Unit{
+      size_t i; // index of the input event
+      EventSPC ev;
+      StdEventSP out;
+    };
+    bool IsStateless(const Event &ev);
+    int Stateless(uint32_t id);
+    void AddUnits(size_t i, EventSPC ev);
+    void Merge(size_t i, size_t u0, size_t u1);
+    void Convert(uint32_t worker, size_t u);
+    void Work(uint32_t worker);
+
+    ConfigurationSPC m_conf;
+    uint32_t m_n_workers;
+    std::vector<std::unique_ptr<StdEventConversionContext>> m_ctxs;
+    std::map<uint32_t, int> m_stateless; // per event type, -1 if there is no converter
+
+    // the batch being converted
+    const std::vector<EventSPC> *m_in;
+    std::vector<StdEventSP> *m_out;
+    std::vector<Unit> m_units;
+    std::vector<uint8_t> m_ok;
+    std::vector<std::exception_ptr> m_err;
+    std::vector<uint8_t> m_ok_ev;             // per input event
+    std::vector<std::exception_ptr> m_err_ev;
+    std::vector<std::vector<size_t>> m_pinned;
+    std::vector<size_t> m_free;
+    std::atomic<size_t> m_next_free;
+
+    uint64_t m_generation;
+    uint32_t m_busy;
+    bool m_exit;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_work;
+    std::condition_variable m_cv_done;
+    std::vector<std::thread> m_thds;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_StdEventBatchConverter
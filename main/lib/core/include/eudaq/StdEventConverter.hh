@@ -6,8 +6,12 @@
 #include "eudaq/Event.hh"
 #include "eudaq/StandardEvent.hh"
 
+#include <typeindex>
+#include <typeinfo>
+
 namespace eudaq{
   class StdEventConverter;
+  class StdEventConversionContext;
 #ifndef EUDAQ_CORE_EXPORTS
   extern template class DLLEXPORT Factory<StdEventConverter>;
   extern template DLLEXPORT
@@ -39,7 +43,69 @@ namespace eudaq{
     StdEventConverter(const StdEventConverter&) = delete;
     StdEventConverter& operator = (const StdEventConverter&) = delete;
     bool Converting(EventSPC d1, StdEventSP d2, ConfigurationSPC conf) const override = 0;
+    /// Conversion with access to the per-stream state of the context (see
+    /// StdEventConversionContext::GetState), the default forwards to Converting.
+    /// Converters keeping information across events override this one.
+    virtual bool ConvertingWithState(EventSPC d1, StdEventSP d2, ConfigurationSPC conf,
+				     StdEventConversionContext &ctx) const;
+    /// Called once by StdEventConversionContext when the converter is created,
+    /// converters may resolve their configuration keys here
+    virtual void Initialize(ConfigurationSPC /*conf*/){};
+    /// Stateless converters keep no information between events and may convert
+    /// the events of a stream concurrently, the others are run in stream order
+    virtual bool IsStateless() const {return false;};
     static bool Convert(EventSPC d1, StdEventSP d2, ConfigurationSPC conf);
+    /// The header (run, event and trigger numbers, timestamps...) every converted event starts with
+    static void CopyHeader(const Event &d1, StandardEvent &d2);
+  };
+
+  /// Base of the information a converter carries from one event of a stream to the next
+  class DLLEXPORT StdEventConverterState{
+  public:
+    virtual ~StdEventConverterState(){};
+  };
+
+  /** Converts a sequence of events with the same configuration.
+   * The converter of each event type is created and initialized once and
+   * kept for the lifetime of the context, instead of once per (sub-)event as
+   * in StdEventConverter::Convert. The cross-event state of the converters
+   * is kept per stream in the context and reset by the BORE of the stream,
+   * so independent contexts can convert several runs or files concurrently.
+   * A context is not thread-safe, use one per converting thread.
+   */
+  class DLLEXPORT StdEventConversionContext{
+  public:
+    explicit StdEventConversionContext(ConfigurationSPC conf = nullptr);
+    StdEventConversionContext(const StdEventConversionContext&) = delete;
+    StdEventConversionContext& operator = (const StdEventConversionContext&) = delete;
+    /// Replaces the configuration and drops the cached converters, the stream states are kept
+    void SetConfiguration(ConfigurationSPC conf);
+    ConfigurationSPC GetConfiguration() const {return m_conf;}
+    bool Convert(EventSPC d1, StdEventSP d2);
+    /// The cached converter for an event type (or RawEvent extend word), nullptr if none exists
+    const StdEventConverter *GetConverter(uint32_t id);
+
+    /// The state of type T for a stream, default constructed on first use
+    template <typename T>
+    T &GetState(uint32_t stream_n){
+      auto &st = m_states[std::make_pair(stream_n, std::type_index(typeid(T)))];
+      if(!st)
+	st.reset(new T);
+      return static_cast<T&>(*st);
+    }
+    /// Drops the states of one stream, done automatically at its BORE
+    void ResetStates(uint32_t stream_n);
+    void ResetStates();
+
+    /// The context of the calling thread used by StdEventConverter::Convert
+    static StdEventConversionContext &ThreadDefault();
+  private:
+    friend class StdEventConverter;
+    ConfigurationSPC m_conf;
+    std::map<uint32_t, StdEventConverterUP> m_cvts;
+    std::map<std::pair<uint32_t, std::type_index>,
+	     std::unique_ptr<StdEventConverterState>> m_states;
+    uint32_t m_depth;
   };
 
 }
@@ -7,12 +7,14 @@
 
 #include "eudaq/Exception.hh"
 #include "eudaq/BufferSerializer.hh"
+#include "eudaq/GatherSerializer.hh"
 #include <string>
 #include <queue>
 #include <iosfwd>
 #include <cstring>
 #include <iostream>
 #include <mutex>
+#include <utility>
 
 namespace eudaq {
 
@@ -65,7 +67,13 @@ namespace eudaq {
     enum EventType { CONNECT, DISCONNECT, RECEIVE };
     TransportEvent(EventType et, ConnectionSP i, const std::string &p = "")
         : etype(et), id(i), packet(p) {}
-    TransportEvent & operator = (const TransportEvent& rh){etype = rh.etype; id=rh.id;  packet = rh.packet; return *this;};
+    /// Takes over the packet buffer, as the transports do for received data
+    TransportEvent(EventType et, ConnectionSP i, std::string &&p)
+        : etype(et), id(i), packet(std::move(p)) {}
+    TransportEvent(const TransportEvent&) = default;
+    TransportEvent(TransportEvent&&) = default;
+    TransportEvent & operator = (const TransportEvent&) = default;
+    TransportEvent & operator = (TransportEvent&&) = default;
     EventType etype; ///< The type of event
     ConnectionSP id; ///< The id of the connection
     std::string packet; ///< The packet of data in case of a RECEIVE event
@@ -186,6 +194,19 @@ namespace eudaq {
       SendPacket(&t[0], t.size(), inf, duringconnect);
     }
 
+    /** Send the segments as one packet.
+     * The default implementation copies them into a single buffer, transports
+     * supporting scatter-gather output send them without copying.
+     */
+    virtual void SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                            const ConnectionInfo & = ConnectionInfo::ALL,
+                            bool duringconnect = false);
+    void SendPacket(const GatherSerializer &t,
+                    const ConnectionInfo &inf = ConnectionInfo::ALL,
+                    bool duringconnect = false) {
+      SendPacket(t.Segments(), inf, duringconnect);
+    }
+
     /** Pure virtual function to close a connection.
      * This function should be implemented by the concrete Transport class to
      * close
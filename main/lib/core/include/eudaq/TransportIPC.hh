@@ -0,0 +1,31 @@
+#ifndef EUDAQ_INCLUDED_TransportIPC
+#define EUDAQ_INCLUDED_TransportIPC
+
+#include "eudaq/TransportTCP.hh"
+
+#include <string>
+
+namespace eudaq {
+
+  /** The TCP transport on Unix domain stream sockets, for components on
+   * the same host. Addresses are socket paths: ipc:///tmp/eudaq_dc
+   */
+  class IPCServer : public TCPServer {
+  public:
+    IPCServer(const std::string &param);
+    ~IPCServer() override;
+    std::string ConnectionString() const override;
+    static const std::string name;
+  private:
+    std::string m_path;
+  };
+
+  class IPCClient : public TCPClient {
+  public:
+    IPCClient(const std::string &param);
+    static const std::string name;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_TransportIPC
@@ -0,0 +1,121 @@
+#ifndef EUDAQ_INCLUDED_TransportSHM
+#define EUDAQ_INCLUDED_TransportSHM
+
+#include "eudaq/TransportServer.hh"
+#include "eudaq/TransportClient.hh"
+#include "eudaq/Platform.hh"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eudaq {
+
+  /** A connection through POSIX shared memory.
+   * The client creates one segment per connection, holding a lock-free
+   * single-producer single-consumer ring buffer for each direction. Packets
+   * are framed in the rings as on a TCP stream, with a 4 byte length header,
+   * so packets larger than a ring are streamed through it.
+   */
+  class ConnectionInfoSHM : public ConnectionInfo {
+  public:
+    ConnectionInfoSHM() = delete;
+    ConnectionInfoSHM(const ConnectionInfoSHM&) = delete;
+    ConnectionInfoSHM& operator = (const ConnectionInfoSHM&) = delete;
+    /// Creates the segment (client), or attaches to it and removes its name (server)
+    ConnectionInfoSHM(const std::string &segment, bool server, size_t ring_size = 0);
+    ~ConnectionInfoSHM() override;
+
+    /// Writes one packet to the outgoing ring, waiting while the ring is full
+    void Send(const GatherSerializer::Segment *segs, size_t nsegs);
+    /// Takes the data available in the incoming ring, returns the bytes read
+    size_t Read();
+    bool havepacket() const;
+    std::string getpacket();
+    /// Tells the other side that this end is closed
+    void Shutdown();
+    /// True once the other side has closed the connection or its process is gone
+    bool PeerClosed();
+    /// Client: keeps the control segment of the server mapped, to wake it up
+    void AttachControl(void *ctl);
+    /// Counts the wake ups of this side by the other one
+    uint32_t Wakeups() const;
+    /// Waits for the other side to write or read, unless it did since Wakeups() returned seen
+    void WaitWakeup(uint32_t seen, uint32_t timeout_us);
+    bool IsPaused() const { return m_paused; }
+    void SetPaused(bool pause) { m_paused = pause; }
+
+    bool Matches(const ConnectionInfo &other) const override;
+    void Print(std::ostream &, size_t) const override;
+    std::string GetRemote() const override { return "shm://" + m_segment; }
+
+  private:
+    void write_ring(const uint8_t *data, size_t len);
+    void wake_peer(bool data);
+    void append(size_t length, const uint8_t *data);
+    void reserve(size_t length);
+    std::string m_segment;
+    bool m_server;
+    uint8_t *m_base;
+    size_t m_len;
+    void *m_ctl; // client: the control segment of the server
+    uint32_t m_polls;
+    std::mutex m_mtx_send; // one packet at a time in the outgoing ring
+
+    unsigned char m_head[4]; // length header of the packet being received
+    size_t m_head_n;
+    size_t m_packet_len; // from the header
+    std::string m_packet; // grown as the bytes arrive, filled up to m_have
+    size_t m_have;
+    std::deque<std::string> m_ready; // complete packets
+    bool m_paused; // not read by the server
+  };
+
+  class SHMServer : public TransportServer {
+  public:
+    SHMServer(const std::string &param);
+    ~SHMServer() override;
+    void Close(const ConnectionInfo &id) override;
+    void SendPacket(const unsigned char *data, size_t len,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool duringconnect = false) override;
+    void SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool duringconnect = false) override;
+    void ProcessEvents(int timeout) override;
+    std::string ConnectionString() const override;
+    std::vector<ConnectionSPC> GetConnections() const override;
+    void PauseReceiving(const ConnectionInfo &id, bool pause) override;
+    static const std::string name;
+  private:
+    void Accept();
+
+    std::string m_name;
+    void *m_ctl; // connection slots in the control segment
+    std::vector<std::shared_ptr<ConnectionInfoSHM>> m_conn;
+    mutable std::mutex m_mtx_conn;
+  };
+
+  class SHMClient : public TransportClient {
+  public:
+    SHMClient(const std::string &param);
+    ~SHMClient() override;
+    void SendPacket(const unsigned char *data, size_t len,
+                    const ConnectionInfo &id = ConnectionInfo::ALL,
+                    bool = false) override;
+    void SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                    const ConnectionInfo &id = ConnectionInfo::ALL,
+                    bool = false) override;
+    void ProcessEvents(int timeout = -1) override;
+    /// Drops the connection, also from another thread
+    void Close(const ConnectionInfo &id) override;
+    static const std::string name;
+  private:
+    std::shared_ptr<ConnectionInfoSHM> m_buf;
+  };
+
+}
+
+#endif // EUDAQ_INCLUDED_TransportSHM
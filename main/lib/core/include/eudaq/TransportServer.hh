@@ -21,6 +21,11 @@ namespace eudaq {
     ~TransportServer() override;
     virtual std::string ConnectionString() const = 0;
     virtual std::vector<ConnectionSPC> GetConnections() const = 0;
+    /** Stops (or resumes) reading from a connection, for flow control.
+     * The data sent meanwhile waits in the transport. To be called from the
+     * thread running Process; transports without support keep reading.
+     */
+    virtual void PauseReceiving(const ConnectionInfo &, bool /*pause*/) {}
     static TransportServer* CreateServer(const std::string &name);
   };
 }
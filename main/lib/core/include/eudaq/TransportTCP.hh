@@ -18,7 +18,9 @@ typedef int SOCKET;
 
 #include <vector>
 #include <string>
+#include <deque>
 #include <map>
+#include <unordered_map>
 
 namespace eudaq {
   class ConnectionInfoTCP : public ConnectionInfo {
@@ -27,21 +29,34 @@ namespace eudaq {
     ConnectionInfoTCP(const ConnectionInfoTCP&) = delete;
     ConnectionInfoTCP& operator = (const ConnectionInfoTCP&) = delete;   
     ConnectionInfoTCP(SOCKET fd, const std::string &host = "")
-      : m_fd(fd), m_host(host), m_len(0), m_buf(""), ConnectionInfo("") {}
+      : ConnectionInfo(""), m_fd(fd), m_host(host) {}
     void append(size_t length, const char *data);
+    /// The missing part of the current packet, if it is large enough to be
+    /// received in place; nullptr if the next bytes should go through append()
+    char *bodybuffer(size_t &length);
+    /// Accounts for length bytes received into bodybuffer()
+    void bodyreceived(size_t length);
     bool havepacket() const;
     std::string getpacket();
     SOCKET GetFd() const { return m_fd; }
+    bool IsPaused() const { return m_paused; }
+    void SetPaused(bool pause) { m_paused = pause; }
     bool Matches(const ConnectionInfo &other) const override;
     void Print(std::ostream &, size_t) const override;
     std::string GetRemote() const override { return m_host; }
 
   private:
-    void update_length(bool = false);
+    void reserve(size_t length);
+    void complete();
     SOCKET m_fd;
     std::string m_host;
-    size_t m_len;
-    std::string m_buf;
+    unsigned char m_head[4]; // length header of the packet being received
+    size_t m_head_n = 0;
+    size_t m_packet_len = 0; // from the header
+    std::string m_packet; // grown as the bytes arrive, filled up to m_have
+    size_t m_have = 0;
+    std::deque<std::string> m_ready; // complete packets
+    bool m_paused = false; // not read by the server
   };
   
   class TCPServer : public TransportServer {
@@ -52,18 +67,34 @@ namespace eudaq {
     void SendPacket(const unsigned char *data, size_t len,
 		    const ConnectionInfo &id = ConnectionInfo::ALL,
 		    bool duringconnect = false) override;
+    void SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+		    const ConnectionInfo &id = ConnectionInfo::ALL,
+		    bool duringconnect = false) override;
     void ProcessEvents(int timeout) override;
     std::string ConnectionString() const override;
     std::vector<ConnectionSPC> GetConnections() const  override;
+    void PauseReceiving(const ConnectionInfo &id, bool pause) override;
     static const std::string name;
+  protected:
+    /// Serves on a socket which is already bound, listening and non-blocking
+    explicit TCPServer(SOCKET srvsock);
   private:
+    void InitPoller();
+    void ProcessEventsSelect(int timeout);
+    void ProcessEventsEpoll(int timeout);
+    void Accept();
+    bool Receive(SOCKET fd);
+
     std::vector<std::shared_ptr<ConnectionInfoTCP>> m_conn;
+    std::unordered_map<SOCKET, std::shared_ptr<ConnectionInfoTCP>> m_fdconn;
     std::mutex m_mtx_conn;
     
     int m_port;
     SOCKET m_srvsock;
     SOCKET m_maxfd;
     fd_set m_fdset;
+    int m_epfd; // epoll instance on Linux, -1 when select() is used
+    std::vector<SOCKET> m_unread; // not drained by Receive, read again first (epoll)
 
     std::shared_ptr<ConnectionInfoTCP> GetInfo(SOCKET fd) const;
   };
@@ -76,8 +107,16 @@ namespace eudaq {
     virtual void SendPacket(const unsigned char *data, size_t len,
                             const ConnectionInfo &id = ConnectionInfo::ALL,
                             bool = false);
+    void SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                    const ConnectionInfo &id = ConnectionInfo::ALL,
+                    bool = false) override;
     virtual void ProcessEvents(int timeout = -1);
+    /// Drops the connection, also from another thread
+    void Close(const ConnectionInfo &id) override;
     static const std::string name;
+  protected:
+    /// Uses a socket which is already connected and non-blocking
+    TCPClient(SOCKET sock, const std::string &param);
   private:
     void OpenConnection();
     std::string m_server;
@@ -1,4 +1,5 @@
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/ioctl.h>
 #include <netdb.h>
 #include <arpa/inet.h>
@@ -68,6 +69,9 @@
 
 #define EUDAQ_ERROR_NO_DATA_RECEIVED -1
 
+// The connection was closed by the remote host without a proper shutdown
+#define EUDAQ_ERROR_Connection_reset ECONNRESET
+
 
 namespace eudaq {
 
@@ -47,6 +47,9 @@
 
 #define EUDAQ_ERROR_NO_DATA_RECEIVED -1
 
+// The connection was closed by the remote host without a proper shutdown
+#define EUDAQ_ERROR_Connection_reset WSAECONNRESET
+
 
 namespace eudaq {
   namespace {
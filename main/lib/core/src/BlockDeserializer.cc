@@ -0,0 +1,37 @@
+#include "eudaq/BlockDeserializer.hh"
+#include "eudaq/Utils.hh"
+
+#include <cstring>
+
+namespace eudaq {
+
+  BlockDeserializer::BlockDeserializer(BlockView data)
+    : m_data(std::move(data)), m_offset(0) {}
+
+  bool BlockDeserializer::HasData() { return m_offset < m_data.size(); }
+
+  void BlockDeserializer::Deserialize(uint8_t *data, size_t len) {
+    PreDeserialize(data, len);
+    m_offset += len;
+  }
+
+  void BlockDeserializer::PreDeserialize(uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    if (len > m_data.size() - m_offset) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+                  to_string(m_data.size() - m_offset));
+    }
+    std::memcpy(data, m_data.data() + m_offset, len);
+  }
+
+  BlockView BlockDeserializer::ReadBlock(size_t len) {
+    if (len > m_data.size() - m_offset) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+                  to_string(m_data.size() - m_offset));
+    }
+    BlockView block = m_data.Slice(m_offset, len);
+    m_offset += len;
+    return block;
+  }
+}
@@ -2,44 +2,50 @@
 
 namespace eudaq {
 
-  BufferSerializer::BufferSerializer(Deserializer &des) : m_offset(0) {
-    des.read(m_data);
+  BufferSerializer::BufferSerializer(Deserializer &des)
+    : m_data(std::make_shared<std::vector<unsigned char>>()), m_offset(0) {
+    des.read(*m_data);
   }
 
-  void BufferSerializer::Serialize(Serializer &ser) const { ser.write(m_data); }
+  void BufferSerializer::Serialize(Serializer &ser) const { ser.write(*m_data); }
 
   void BufferSerializer::Serialize(const unsigned char *data, size_t len) {
-    m_data.insert(m_data.end(), data, data + len);
+    if (m_data.use_count() > 1) {
+      // still referenced by a BlockView, detach before modifying
+      m_data = std::make_shared<std::vector<unsigned char>>(*m_data);
+    }
+    m_data->insert(m_data->end(), data, data + len);
   }
 
   void BufferSerializer::Deserialize(unsigned char *data, size_t len) {
     if (!len)
       return;
-    if (len + m_offset > m_data.size()) {
+    if (len + m_offset > m_data->size()) {
       EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
-                  to_string(m_data.size() - m_offset));
+                  to_string(m_data->size() - m_offset));
     }
-    std::copy(&m_data[m_offset], &m_data[m_offset] + len, data);
-    // m_data.erase(m_data.begin(), m_data.begin() + len);
+    std::copy(&(*m_data)[m_offset], &(*m_data)[m_offset] + len, data);
     m_offset += len;
-    // std::string tmp(data, data+len);
-    // std::cout << "Deserialize: " << len << /*" \"" << tmp << "\"" <<*/
-    // std::endl;
-    // tmp = std::string(begin(), end());
-    // std::cout << "Remaining: " << (end()-begin()) << /*" \"" << tmp << "\""
-    // <<*/ std::endl;
   }
 
-
   void BufferSerializer::PreDeserialize(unsigned char *data, size_t len) {
     if (!len)
       return;
-    if (len + m_offset > m_data.size()) {
+    if (len + m_offset > m_data->size()) {
       EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
-                  to_string(m_data.size() - m_offset));
+                  to_string(m_data->size() - m_offset));
     }
-    std::copy(&m_data[m_offset], &m_data[m_offset] + len, data);
+    std::copy(&(*m_data)[m_offset], &(*m_data)[m_offset] + len, data);
   }
 
+  BlockView BufferSerializer::ReadBlock(size_t len) {
+    if (len + m_offset > m_data->size()) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+                  to_string(m_data->size() - m_offset));
+    }
+    BlockView block(m_data, m_data->data() + m_offset, len);
+    m_offset += len;
+    return block;
+  }
 
 }
@@ -0,0 +1,399 @@
+#include "eudaq/FileNamer.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/FileReader.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Compression.hh"
+#include "eudaq/SerializedEvent.hh"
+#include "eudaq/Logger.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// The compressed native format stores the same Event serializations as the
+// native format, grouped into independently compressed frames:
+//   file header: uint32 magic, uint32 version, uint32 codec
+//   frame:       uint32 raw size, uint32 compressed size, uint32 number of
+//                events, compressed data
+// Frames can be decompressed in any order. The index file of NativeFileWriter
+// is written as well, its offsets point to the frame holding the event.
+
+namespace{
+  const uint32_t FILE_MAGIC = 0x46435545; // "EUCF"
+  const uint32_t FILE_VERSION = 1;
+
+  struct Frame{
+    std::vector<uint8_t> data;
+    uint32_t raw_size;
+    uint32_t n_events;
+    std::vector<eudaq::FileIndex::Entry> index;
+  };
+}
+
+class CompressedFileWriter : public eudaq::FileWriter {
+public:
+  CompressedFileWriter(const std::string &patt, eudaq::CompressionCodec codec);
+  ~CompressedFileWriter() override;
+  void WriteEvent(eudaq::EventSPC ev) override;
+  void WriteSerialized(eudaq::SerializedEventSPC sev) override;
+  uint64_t FileBytes() const override;
+  void Flush() override;
+private:
+  void Configure();
+  void SubmitFrame();
+  void WriteFrame(Frame &frame);
+  void Drain(size_t max_pending);
+  void Compressing();
+
+  eudaq::CompressionCodec m_codec;
+  std::string m_filepattern;
+  std::unique_ptr<eudaq::FileSerializer> m_ser;
+  std::unique_ptr<eudaq::FileSerializer> m_idx;
+  uint32_t m_run_n;
+  bool m_configured;
+  bool m_index;
+  int m_level;
+  size_t m_frame_bytes;
+  size_t m_threads;
+  std::shared_ptr<eudaq::BufferSerializer> m_frame;
+  Frame m_frame_info;
+  std::deque<std::future<Frame>> m_pending;
+  // the frames are compressed by m_threads workers, started once
+  std::vector<std::thread> m_workers;
+  std::deque<std::packaged_task<Frame()>> m_jobs;
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  bool m_exit;
+};
+
+class Lz4FileWriter : public CompressedFileWriter {
+public:
+  Lz4FileWriter(const std::string &patt)
+    :CompressedFileWriter(patt, eudaq::CompressionCodec::LZ4){}
+};
+
+class ZstdFileWriter : public CompressedFileWriter {
+public:
+  ZstdFileWriter(const std::string &patt)
+    :CompressedFileWriter(patt, eudaq::CompressionCodec::ZSTD){}
+};
+
+class CompressedFileReader : public eudaq::FileReader {
+public:
+  CompressedFileReader(const std::string& filename);
+  eudaq::EventSPC GetNextEvent() override;
+  bool Seek(uint32_t event_n) override;
+  bool SeekTrigger(uint32_t trigger_n) override;
+  bool SeekTimestamp(uint64_t timestamp) override;
+private:
+  void Open();
+  void OpenIndex();
+  void ReadAhead();
+  bool SeekEntry(const eudaq::FileIndex::Entry *entry);
+  std::string m_filename;
+  std::unique_ptr<eudaq::FileDeserializer> m_des;
+  std::unique_ptr<eudaq::FileIndex> m_index;
+  eudaq::CompressionCodec m_codec;
+  size_t m_depth;
+  std::deque<std::future<std::shared_ptr<eudaq::BufferSerializer>>> m_pending;
+  std::deque<uint32_t> m_pending_events;
+  std::shared_ptr<eudaq::BufferSerializer> m_frame;
+  uint32_t m_frame_events;
+  uint32_t m_skip;
+};
+
+namespace{
+#ifdef EUDAQ_WITH_LZ4
+  auto dummy0 = eudaq::Factory<eudaq::FileWriter>::
+    Register<Lz4FileWriter, std::string&>(eudaq::cstr2hash("native-lz4"));
+  auto dummy1 = eudaq::Factory<eudaq::FileWriter>::
+    Register<Lz4FileWriter, std::string&&>(eudaq::cstr2hash("native-lz4"));
+  auto dummy2 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&>(eudaq::cstr2hash("native-lz4"));
+  auto dummy3 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&&>(eudaq::cstr2hash("native-lz4"));
+#endif
+#ifdef EUDAQ_WITH_ZSTD
+  auto dummy4 = eudaq::Factory<eudaq::FileWriter>::
+    Register<ZstdFileWriter, std::string&>(eudaq::cstr2hash("native-zst"));
+  auto dummy5 = eudaq::Factory<eudaq::FileWriter>::
+    Register<ZstdFileWriter, std::string&&>(eudaq::cstr2hash("native-zst"));
+  auto dummy6 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&>(eudaq::cstr2hash("native-zst"));
+  auto dummy7 = eudaq::Factory<eudaq::FileReader>::
+    Register<CompressedFileReader, std::string&&>(eudaq::cstr2hash("native-zst"));
+#endif
+}
+
+CompressedFileWriter::CompressedFileWriter(const std::string &patt,
+					   eudaq::CompressionCodec codec)
+  :m_codec(codec), m_filepattern(patt), m_run_n(0), m_configured(false),
+   m_index(true), m_level(0), m_frame_bytes(1024*1024), m_threads(1),
+   m_frame(std::make_shared<eudaq::BufferSerializer>()), m_exit(false){
+  m_frame_info.raw_size = 0;
+  m_frame_info.n_events = 0;
+}
+
+CompressedFileWriter::~CompressedFileWriter(){
+  try{
+    Flush();
+  }
+  catch(const std::exception &e){
+    EUDAQ_ERROR(std::string("CompressedFileWriter: ") + e.what());
+  }
+  std::unique_lock<std::mutex> lk(m_mtx);
+  m_exit = true;
+  lk.unlock();
+  m_cv.notify_all();
+  for(auto &t: m_workers)
+    t.join();
+}
+
+void CompressedFileWriter::Configure(){
+  m_configured = true;
+  m_threads = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+  auto conf = GetConfiguration();
+  if(!conf)
+    return;
+  m_index = conf->Get("EUDAQ_FW_INDEX", 1);
+  m_level = conf->Get("EUDAQ_FW_COMPRESSION_LEVEL", 0);
+  m_frame_bytes = size_t(conf->Get("EUDAQ_FW_FRAME_KB", 1024))*1024;
+  m_threads = std::max(1, conf->Get("EUDAQ_FW_THREADS", int(m_threads)));
+}
+
+void CompressedFileWriter::Compressing(){
+  std::unique_lock<std::mutex> lk(m_mtx);
+  while(true){
+    m_cv.wait(lk, [this]{return !m_jobs.empty() || m_exit;});
+    if(m_jobs.empty())
+      break;
+    auto job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+    lk.unlock();
+    job(); // an exception is passed on through the future
+    lk.lock();
+  }
+}
+
+void CompressedFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  WriteSerialized(eudaq::SerializedEvent::Make(ev));
+}
+
+void CompressedFileWriter::WriteSerialized(eudaq::SerializedEventSPC sev) {
+  const eudaq::Event *ev = &sev->GetEvent();
+  if(!m_configured)
+    Configure();
+  uint32_t run_n = ev->GetRunN();
+  if(!m_ser || m_run_n != run_n){
+    Flush();
+    std::time_t time_now = std::time(nullptr);
+    char time_buff[13];
+    time_buff[12] = 0;
+    std::strftime(time_buff, sizeof(time_buff),
+		  "%y%m%d%H%M%S", std::localtime(&time_now));
+    std::string time_str(time_buff);
+    std::string filename = eudaq::FileNamer(m_filepattern).
+      Set('X', m_codec == eudaq::CompressionCodec::LZ4 ? ".raw.lz4" : ".raw.zst").
+      Set('R', run_n).
+      Set('D', time_str);
+    m_idx.reset();
+    m_ser.reset(new eudaq::FileSerializer(filename));
+    m_ser->write(FILE_MAGIC);
+    m_ser->write(FILE_VERSION);
+    m_ser->write(uint32_t(m_codec));
+    if(m_index){
+      m_idx.reset(new eudaq::FileSerializer(eudaq::FileIndex::IndexPath(filename), true));
+      eudaq::FileIndex::WriteHeader(*m_idx);
+    }
+    m_run_n = run_n;
+  }
+  sev->WriteTo(*m_frame);
+  m_frame_info.n_events++;
+  if(m_index){
+    // the offset of the frame is filled in when it is written
+    eudaq::FileIndex::Entry entry = {ev->GetEventN(), ev->GetTriggerN(),
+				     ev->GetTimestampBegin(), 0};
+    m_frame_info.index.push_back(entry);
+  }
+  if(m_frame->size() >= m_frame_bytes)
+    SubmitFrame();
+}
+
+void CompressedFileWriter::SubmitFrame(){
+  if(!m_frame_info.n_events)
+    return;
+  auto raw = m_frame;
+  Frame info;
+  std::swap(info, m_frame_info);
+  info.raw_size = uint32_t(raw->size());
+  m_frame = std::make_shared<eudaq::BufferSerializer>();
+  m_frame_info.raw_size = 0;
+  m_frame_info.n_events = 0;
+  auto codec = m_codec;
+  int level = m_level;
+  std::packaged_task<Frame()> job([raw, info, codec, level]() mutable {
+      eudaq::Compress(codec, raw->data(), raw->size(), info.data, level);
+      return std::move(info);
+    });
+  m_pending.push_back(job.get_future());
+  std::unique_lock<std::mutex> lk(m_mtx);
+  m_jobs.push_back(std::move(job));
+  while(m_workers.size() < m_threads)
+    m_workers.emplace_back(&CompressedFileWriter::Compressing, this);
+  lk.unlock();
+  m_cv.notify_one();
+  // frames are written in order, at most m_threads are compressed at a time
+  Drain(m_threads);
+}
+
+void CompressedFileWriter::Drain(size_t max_pending){
+  while(m_pending.size() > max_pending){
+    Frame frame = m_pending.front().get();
+    m_pending.pop_front();
+    WriteFrame(frame);
+  }
+}
+
+void CompressedFileWriter::WriteFrame(Frame &frame){
+  uint64_t offset = m_ser->FileBytes();
+  m_ser->write(frame.raw_size);
+  m_ser->write(uint32_t(frame.data.size()));
+  m_ser->write(frame.n_events);
+  m_ser->append(frame.data.data(), frame.data.size());
+  m_ser->Flush();
+  if(m_idx){
+    for(auto &e: frame.index){
+      e.offset = offset;
+      eudaq::FileIndex::WriteEntry(*m_idx, e);
+    }
+    m_idx->Flush();
+  }
+}
+
+void CompressedFileWriter::Flush(){
+  if(!m_ser)
+    return;
+  SubmitFrame();
+  Drain(0);
+  m_ser->Flush();
+}
+
+uint64_t CompressedFileWriter::FileBytes() const {
+  return m_ser ?m_ser->FileBytes() :0;
+}
+
+CompressedFileReader::CompressedFileReader(const std::string& filename)
+  :m_filename(filename), m_codec(eudaq::CompressionCodec::NONE),
+   m_depth(std::max(2u, std::min(4u, std::thread::hardware_concurrency()))),
+   m_frame_events(0), m_skip(0){
+}
+
+void CompressedFileReader::Open(){
+  if(m_des)
+    return;
+  m_des.reset(new eudaq::FileDeserializer(m_filename));
+  uint32_t magic = 0, version = 0, codec = 0;
+  if(m_des->HasData()){
+    m_des->read(magic);
+    m_des->read(version);
+    m_des->read(codec);
+  }
+  if(magic != FILE_MAGIC || version != FILE_VERSION)
+    EUDAQ_THROW("CompressedFileReader: " + m_filename + " is not a compressed native file");
+  m_codec = eudaq::CompressionCodec(codec);
+  if(!eudaq::IsCompressionAvailable(m_codec))
+    EUDAQ_THROW("CompressedFileReader: " + m_filename + " uses the codec " +
+		eudaq::CompressionCodecName(m_codec) + ", which is not available");
+}
+
+void CompressedFileReader::ReadAhead(){
+  // the frames are read in this thread, and decompressed in the background
+  while(m_pending.size() < m_depth && m_des->HasData()){
+    uint32_t raw_size, comp_size, n_events;
+    m_des->read(raw_size);
+    m_des->read(comp_size);
+    m_des->read(n_events);
+    eudaq::BlockView comp = m_des->ReadBlock(comp_size);
+    auto codec = m_codec;
+    m_pending.push_back(std::async(std::launch::async, [comp, raw_size, codec](){
+	  std::vector<uint8_t> raw(raw_size);
+	  eudaq::Decompress(codec, comp.data(), comp.size(), raw.data(), raw_size);
+	  return std::make_shared<eudaq::BufferSerializer>(std::move(raw));
+	}));
+    m_pending_events.push_back(n_events);
+  }
+}
+
+eudaq::EventSPC CompressedFileReader::GetNextEvent(){
+  Open();
+  while(true){
+    while(!m_frame_events){
+      ReadAhead();
+      if(m_pending.empty())
+	return nullptr;
+      m_frame = m_pending.front().get();
+      m_frame_events = m_pending_events.front();
+      m_pending.pop_front();
+      m_pending_events.pop_front();
+    }
+    uint32_t id;
+    m_frame->PreRead(id);
+    eudaq::EventSPC ev = eudaq::Factory<eudaq::Event>::
+      Create<eudaq::Deserializer&>(id, *m_frame);
+    m_frame_events--;
+    if(!m_frame_events)
+      m_frame.reset();
+    if(m_skip){
+      m_skip--;
+      continue;
+    }
+    return ev;
+  }
+}
+
+bool CompressedFileReader::SeekEntry(const eudaq::FileIndex::Entry *entry){
+  if(!entry)
+    return false;
+  // skip the events which are in the same frame before the requested one
+  const eudaq::FileIndex::Entry *first = &m_index->Entries()[0];
+  uint32_t skip = 0;
+  while(entry - skip != first && (entry - skip - 1)->offset == entry->offset)
+    skip++;
+  m_pending.clear();
+  m_pending_events.clear();
+  m_frame.reset();
+  m_frame_events = 0;
+  m_des->Seek(entry->offset);
+  m_skip = skip;
+  return true;
+}
+
+void CompressedFileReader::OpenIndex(){
+  Open();
+  if(!m_index){
+    m_index.reset(new eudaq::FileIndex);
+    if(!m_index->Load(eudaq::FileIndex::IndexPath(m_filename)))
+      EUDAQ_INFO("CompressedFileReader: no index for " + m_filename +
+		 ", seeking is disabled");
+  }
+}
+
+bool CompressedFileReader::Seek(uint32_t event_n){
+  OpenIndex();
+  return SeekEntry(m_index->FindEvent(event_n));
+}
+
+bool CompressedFileReader::SeekTrigger(uint32_t trigger_n){
+  OpenIndex();
+  return SeekEntry(m_index->FindTrigger(trigger_n));
+}
+
+bool CompressedFileReader::SeekTimestamp(uint64_t timestamp){
+  OpenIndex();
+  return SeekEntry(m_index->FindTimestamp(timestamp));
+}
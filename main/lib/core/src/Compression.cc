@@ -0,0 +1,134 @@
+#include "eudaq/Compression.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#include <cstring>
+
+#ifdef EUDAQ_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef EUDAQ_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace eudaq {
+
+  bool IsCompressionAvailable(CompressionCodec codec){
+    switch(codec){
+    case CompressionCodec::NONE:
+      return true;
+#ifdef EUDAQ_WITH_LZ4
+    case CompressionCodec::LZ4:
+      return true;
+#endif
+#ifdef EUDAQ_WITH_ZSTD
+    case CompressionCodec::ZSTD:
+      return true;
+#endif
+    default:
+      return false;
+    }
+  }
+
+  CompressionCodec CompressionCodecFromName(const std::string &name){
+    std::string n = lcase(name);
+    if(n == "lz4")
+      return CompressionCodec::LZ4;
+    if(n == "zst" || n == "zstd")
+      return CompressionCodec::ZSTD;
+    if(n == "none" || n.empty())
+      return CompressionCodec::NONE;
+    EUDAQ_THROW("Unknown compression codec: " + name);
+  }
+
+  std::string CompressionCodecName(CompressionCodec codec){
+    switch(codec){
+    case CompressionCodec::NONE:
+      return "none";
+    case CompressionCodec::LZ4:
+      return "lz4";
+    case CompressionCodec::ZSTD:
+      return "zstd";
+    }
+    return "unknown(" + to_string(uint32_t(codec)) + ")";
+  }
+
+  void Compress(CompressionCodec codec, const uint8_t *data, size_t len,
+                std::vector<uint8_t> &out, int level){
+#if !defined(EUDAQ_WITH_LZ4) && !defined(EUDAQ_WITH_ZSTD)
+    (void)level; // only used by the codecs
+#endif
+    switch(codec){
+    case CompressionCodec::NONE:
+      out.assign(data, data + len);
+      return;
+#ifdef EUDAQ_WITH_LZ4
+    case CompressionCodec::LZ4:{
+      if(len > size_t(LZ4_MAX_INPUT_SIZE))
+        EUDAQ_THROW("LZ4: block of " + to_string(len) + " bytes is too large");
+      out.resize(LZ4_compressBound(int(len)));
+      int n = level > 1 ?
+        LZ4_compress_fast(reinterpret_cast<const char*>(data),
+                          reinterpret_cast<char*>(out.data()),
+                          int(len), int(out.size()), level) :
+        LZ4_compress_default(reinterpret_cast<const char*>(data),
+                             reinterpret_cast<char*>(out.data()),
+                             int(len), int(out.size()));
+      if(n <= 0 && len)
+        EUDAQ_THROW("LZ4: compression failed");
+      out.resize(n);
+      return;
+    }
+#endif
+#ifdef EUDAQ_WITH_ZSTD
+    case CompressionCodec::ZSTD:{
+      out.resize(ZSTD_compressBound(len));
+      size_t n = ZSTD_compress(out.data(), out.size(), data, len,
+                               level ? level : 3);
+      if(ZSTD_isError(n))
+        EUDAQ_THROW(std::string("ZSTD: ") + ZSTD_getErrorName(n));
+      out.resize(n);
+      return;
+    }
+#endif
+    default:
+      EUDAQ_THROW("Compression codec " + CompressionCodecName(codec) +
+                  " is not available in this build");
+    }
+  }
+
+  void Decompress(CompressionCodec codec, const uint8_t *data, size_t len,
+                  uint8_t *out, size_t rawlen){
+    switch(codec){
+    case CompressionCodec::NONE:
+      if(len != rawlen)
+        EUDAQ_THROW("Uncompressed block has an inconsistent size");
+      if(len)
+        std::memcpy(out, data, len);
+      return;
+#ifdef EUDAQ_WITH_LZ4
+    case CompressionCodec::LZ4:{
+      int n = LZ4_decompress_safe(reinterpret_cast<const char*>(data),
+                                  reinterpret_cast<char*>(out),
+                                  int(len), int(rawlen));
+      if(n < 0 || size_t(n) != rawlen)
+        EUDAQ_THROW("LZ4: corrupted block");
+      return;
+    }
+#endif
+#ifdef EUDAQ_WITH_ZSTD
+    case CompressionCodec::ZSTD:{
+      size_t n = ZSTD_decompress(out, rawlen, data, len);
+      if(ZSTD_isError(n))
+        EUDAQ_THROW(std::string("ZSTD: ") + ZSTD_getErrorName(n));
+      if(n != rawlen)
+        EUDAQ_THROW("ZSTD: corrupted block");
+      return;
+    }
+#endif
+    default:
+      EUDAQ_THROW("Compression codec " + CompressionCodecName(codec) +
+                  " is not available in this build");
+    }
+  }
+}
@@ -16,6 +16,7 @@ namespace eudaq {
     m_dct_n= str2hash(GetFullName());
     m_evt_c = 0;
     m_fraction = 1;
+    m_mn_bytes = 0;
   }
 
   DataCollector::~DataCollector(){  
@@ -81,6 +82,12 @@ namespace eudaq {
       m_fwpatt = conf->Get("EUDAQ_FW_PATTERN", "$12D_run$6R$X");
       m_dct_n = conf->Get("EUDAQ_ID", m_dct_n);
       m_fraction = conf->Get("EUDAQ_DATACOL_SEND_MONITOR_FRACTION", 10);
+      // per monitor, the newest events are kept; 0 sends on the writing thread
+      m_mn_bytes = uint64_t(conf->Get("EUDAQ_MN_BUFFER_MB", 4.)*1024*1024);
+      SetPoolCapacity(this, conf->Get("EUDAQ_EVENT_POOL", 0));
+      // per producer, 0 for no limit
+      SetQueueLimit(uint64_t(conf->Get("EUDAQ_DR_BUFFER_MB", 64.)*1024*1024));
+      SetDecodeThreads(conf->Get("EUDAQ_DR_DECODE_THREADS", 0));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -96,6 +103,8 @@ namespace eudaq {
       m_data_addr = Listen(m_data_addr);
       SetStatusTag("_SERVER", m_data_addr);
       m_writer = Factory<FileWriter>::Create<std::string&>(str2hash(m_fwtype), m_fwpatt);
+      if(m_writer)
+	m_writer->SetConfiguration(GetConfiguration());
       m_evt_c = 0;
 
       std::string mn_str = GetConfiguration()->Get("EUDAQ_MN", "");
@@ -108,6 +117,9 @@ namespace eudaq {
 	if(!mn_addr.empty()){
 	  m_senders[mn_addr]
 	    = std::shared_ptr<DataSender>(new DataSender("DataCollector", GetName()));
+	  m_senders[mn_addr]->SetQueue(m_mn_bytes, DataSender::QUEUE_LATEST);
+	  // a stalled monitor holds up the end of the run for at most a second
+	  m_senders[mn_addr]->SetStopTimeout(1000);
 	  m_senders[mn_addr]->Connect(mn_addr);
 	}
 	lk.unlock();
@@ -127,9 +139,15 @@ namespace eudaq {
     try {
       DoStopRun();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = std::move(m_senders);
       m_senders.clear();
       lk.unlock();
+      // the queued events are sent out without holding m_mtx_sender
+      senders.clear();
       StopListen();
+      auto file_writer = m_writer;
+      if(file_writer)
+	file_writer->Flush();
       CommandReceiver::OnStopRun();
     } catch (const Exception &e) {
       std::string msg = "Error stopping for run " + std::to_string(GetRunNumber()) + ": " + e.what();
@@ -143,8 +161,11 @@ namespace eudaq {
     try{
       DoReset();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = std::move(m_senders);
       m_senders.clear();
       lk.unlock();
+      // the queued events are sent out without holding m_mtx_sender
+      senders.clear();
       StopListen();
       CommandReceiver::OnReset();
     } catch (const std::exception &e) {
@@ -165,6 +186,23 @@ namespace eudaq {
   void DataCollector::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
     SetStatusTag("MonitorEventN", std::to_string(float(m_evt_c/m_fraction)));
+    std::unique_lock<std::mutex> lk(m_mtx_sender);
+    auto senders = m_senders;
+    lk.unlock();
+    uint64_t mn_dropped = 0;
+    for(auto &e: senders)
+      if(e.second && e.second->IsAsync())
+	mn_dropped += e.second->GetQueueStatus().dropped;
+    SetStatusTag("MonitorDropped", std::to_string(mn_dropped));
+    auto file_writer = m_writer;
+    if(file_writer)
+      for(auto &tag: file_writer->GetStatusTags())
+	SetStatusTag(tag.first, tag.second);
+    auto cmp = GetCompressionStatus();
+    if(cmp.wire_bytes){
+      SetStatusTag("RecvCompressRatio", std::to_string(double(cmp.raw_bytes)/cmp.wire_bytes));
+      SetStatusTag("RecvDecompressMs", std::to_string(cmp.cpu_ms));
+    }
     DoStatus();
     // if(m_writer && m_writer->FileBytes()){
     //   SetStatusTag("FILEBYTES", std::to_string(m_writer->FileBytes()));
@@ -196,9 +234,11 @@ namespace eudaq {
       ev->SetEventN(m_evt_c);
       m_evt_c ++;
       ev->SetStreamN(m_dct_n);
+      // serialized once for the file writer and all the monitors
+      auto sev = SerializedEvent::Make(ev);
       auto file_writer = m_writer;
       if(file_writer)
-	file_writer->WriteEvent(ev);
+	file_writer->WriteSerialized(sev);
       else
 	EUDAQ_THROW("FileWriter is not created before writing.");
       std::unique_lock<std::mutex> lk(m_mtx_sender);
@@ -208,10 +248,18 @@ namespace eudaq {
 	return;
       }
       for(auto &e: senders){
-	if(e.second)
-	  e.second->SendEvent(ev);
-	else
+	if(!e.second)
 	  EUDAQ_THROW("DataCollector::WriterEvent, using a null pointer of DataSender");
+	try{
+	  e.second->SendEvent(sev);
+	}
+	catch(const Exception &ex){
+	  // a lost monitor does not stop the data taking
+	  EUDAQ_WARN("DataCollector: Monitor " + e.first + " is not sent to anymore: " + ex.what());
+	  lk.lock();
+	  m_senders.erase(e.first);
+	  lk.unlock();
+	}
       }
     }catch (const Exception &e) {
       std::string msg = "Exception writing to file: ";
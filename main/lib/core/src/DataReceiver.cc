@@ -1,8 +1,9 @@
 #include "eudaq/DataReceiver.hh"
 #include "eudaq/TransportServer.hh"
-#include "eudaq/BufferSerializer.hh"
+#include "eudaq/BlockDeserializer.hh"
 #include "eudaq/Logger.hh"
 #include "eudaq/Utils.hh"
+#include <algorithm>
 #include <iostream>
 #include <ostream>
 #include <ctime>
@@ -10,7 +11,9 @@
 namespace eudaq {
   
   DataReceiver::DataReceiver()
-    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"){
+    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"),
+     m_qu_limit(64*1024*1024), m_n_decode(0), m_n_decode_running(0), m_decode_exit(false),
+     m_cmp_raw(0), m_cmp_wire(0), m_cmp_ms(0){
   }
 
   DataReceiver::~DataReceiver(){
@@ -29,6 +32,140 @@ namespace eudaq {
   void DataReceiver::OnReceive(ConnectionSPC id, EventSP ev){
   }
   
+  void DataReceiver::Enqueue(ConnectionSPC con, ItemSP item){
+    // m_mx_qu_ev is held by the caller
+    auto &q = m_qu_con[con];
+    q.bytes += item->bytes;
+    if(item->state == ITEM_PENDING && m_n_decode_running){
+      m_qu_decode.push_back(item);
+      m_cv_decode.notify_one();
+    }
+    q.items.push_back(std::move(item));
+    if(!q.scheduled){
+      q.scheduled = true;
+      m_qu_ready.push_back(con);
+    }
+    m_cv_not_empty.notify_all();
+  }
+
+  DataReceiver::CompressionStatus DataReceiver::GetCompressionStatus(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    return CompressionStatus{m_cmp_raw, m_cmp_wire, m_cmp_ms};
+  }
+
+  BlockView DataReceiver::Uncompress(const BlockView &packet){
+    // a compressed packet (see DataSender::COMPRESSED_ID), or the packet itself
+    uint32_t id = 0;
+    BlockDeserializer ser(packet);
+    if(packet.size() >= sizeof(id))
+      ser.PreRead(id);
+    if(id != DataSender::COMPRESSED_ID)
+      return packet;
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t codec, rawlen;
+    ser.read(id);
+    ser.read(codec);
+    ser.read(rawlen);
+    BlockView zip = ser.ReadBlock(packet.size() - 3 * sizeof(uint32_t));
+    // the size is the peer's claim, checked before it is allocated
+    if(rawlen > uint64_t(zip.size()) * DataSender::MAX_COMPRESSION_RATIO)
+      EUDAQ_THROW("Compressed packet of " + to_string(zip.size()) + " bytes claims "
+		  + to_string(rawlen) + " bytes uncompressed");
+    std::vector<uint8_t> raw(rawlen);
+    Decompress(CompressionCodec(codec), zip.data(), zip.size(), raw.data(), raw.size());
+    std::chrono::duration<double, std::milli> dt = std::chrono::steady_clock::now() - t0;
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    m_cmp_raw += rawlen;
+    m_cmp_wire += packet.size();
+    m_cmp_ms += dt.count();
+    lk.unlock();
+    return BlockView(std::move(raw));
+  }
+
+  std::vector<BlockView> DataReceiver::Unbatch(const BlockView &packet){
+    // a packet of several events (see DataSender::BATCH_ID), or a single event
+    uint32_t id = 0;
+    BlockDeserializer ser(packet);
+    if(packet.size() >= sizeof(id))
+      ser.PreRead(id);
+    if(id != DataSender::BATCH_ID)
+      return std::vector<BlockView>(1, packet);
+    uint32_t n;
+    ser.read(id);
+    ser.read(n);
+    std::vector<BlockView> events;
+    events.reserve(n);
+    for(uint32_t i = 0; i < n; i++){
+      uint32_t len;
+      ser.read(len);
+      events.push_back(ser.ReadBlock(len));
+    }
+    return events;
+  }
+
+  void DataReceiver::Decode(Item &item){
+    std::vector<BlockView> events;
+    try{
+      // only what was negotiated, a plain event may start like these packets
+      BlockView packet = item.compress ? Uncompress(item.data) : item.data;
+      if(item.batch)
+	events = Unbatch(packet);
+      else
+	events.push_back(packet);
+    }
+    catch(const std::exception &e){
+      EUDAQ_WARN("DataReceiver: Malformed packet: " + std::string(e.what()));
+    }
+    item.data = BlockView();
+    // the events are read in place, their data blocks share the packet
+    item.evs.reserve(events.size());
+    for(auto &data: events){
+      try{
+	BlockDeserializer ser(std::move(data));
+	uint32_t id;
+	ser.PreRead(id);
+	item.evs.push_back(Factory<Event>::MakeUnique<Deserializer&>(id, ser));
+      }
+      catch(const std::exception &e){
+	EUDAQ_WARN("DataReceiver: Unable to deserialize an event: " + std::string(e.what()));
+      }
+    }
+  }
+
+  void DataReceiver::DecodeWorker(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    while(true){
+      m_cv_decode.wait(lk, [this]{return !m_qu_decode.empty() || m_decode_exit;});
+      if(m_decode_exit)
+	break;
+      ItemSP item = std::move(m_qu_decode.front());
+      m_qu_decode.pop_front();
+      // the forwarding thread may have taken it already
+      if(item->state != ITEM_PENDING)
+	continue;
+      item->state = ITEM_DECODING;
+      lk.unlock();
+      Decode(*item);
+      lk.lock();
+      item->state = ITEM_READY;
+      m_cv_not_empty.notify_all();
+    }
+  }
+
+  DataReceiver::ItemSP DataReceiver::NextItem(ConnectionSPC &con){
+    // m_mx_qu_ev is held by the caller; the first connection in turn whose
+    // next item is not being deserialized by a worker
+    for(auto it = m_qu_ready.begin(); it != m_qu_ready.end(); ++it){
+      auto &item = m_qu_con[*it].items.front();
+      if(item->state != ITEM_DECODING){
+	con = *it;
+	m_qu_ready.erase(it);
+	return item;
+      }
+    }
+    return nullptr;
+  }
+
   void DataReceiver::DataHandler(TransportEvent &ev) {
     auto con = ev.id;
     bool has_con_for_discon = false;
@@ -43,8 +180,7 @@ namespace eudaq {
 	if (m_vt_con[i] == con){
 	  m_vt_con.erase(m_vt_con.begin() + i);
 	  std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	  m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	  m_cv_not_empty.notify_all();
+	  Enqueue(con, std::make_shared<Item>(Item{ITEM_DISCONNECT, ITEM_READY}));
 	  has_con_for_discon = true;
 	}
       }
@@ -53,6 +189,7 @@ namespace eudaq {
       break;
     case (TransportEvent::RECEIVE):
       if (con->GetState() == 0) { //unidentified connection
+	std::vector<std::string> caps;
         do {
           size_t i0 = 0, i1 = ev.packet.find(' ');
           if (i1 == std::string::npos)
@@ -82,28 +219,63 @@ namespace eudaq {
           i1 = ev.packet.find(' ', i0);
           part = std::string(ev.packet, i0, i1 - i0);
           con->SetName(part);
+	  if (i1 == std::string::npos)
+	    break;
+	  // optional capabilities of newer senders
+	  caps = split(std::string(ev.packet, i1 + 1), " ");
         } while (false);
-        m_dataserver->SendPacket("OK", *con, true);
+	// the reply lists the capabilities which are used on this connection
+	auto has = [&caps](const std::string &cap){
+	  return std::find(caps.begin(), caps.end(), cap) != caps.end();
+	};
+	uint64_t window = m_qu_limit;
+	bool credit = has("CREDIT") && window;
+	std::string reply = "OK";
+	if(credit)
+	  reply += " CREDIT " + std::to_string(window);
+	bool batch = has("BATCH");
+	if(batch)
+	  reply += " BATCH";
+	// "COMPRESS <codec>", accepted if this build supports the codec
+	bool compress = false;
+	auto it = std::find(caps.begin(), caps.end(), "COMPRESS");
+	if(it != caps.end() && it + 1 != caps.end()){
+	  try{
+	    compress = IsCompressionAvailable(CompressionCodecFromName(*(it + 1)));
+	    if(compress)
+	      reply += " COMPRESS " + *(it + 1);
+	  }
+	  catch(const std::exception &){
+	    // unknown codec, the sender falls back to uncompressed packets
+	  }
+	}
+	m_dataserver->SendPacket(reply, *con, true);
         con->SetState(1); // successfully identified
 	EUDAQ_INFO("DataReceiver: Connection from " + to_string(*con));
 	m_vt_con.push_back(con);
 	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	m_cv_not_empty.notify_all();
+	auto &q = m_qu_con[con];
+	q.credit = credit;
+	q.window = window;
+	q.batch = batch;
+	q.compress = compress;
+	Enqueue(con, std::make_shared<Item>(Item{ITEM_CONNECT, ITEM_READY}));
       }
       else{ //identified connection  
-	BufferSerializer ser(ev.packet.begin(), ev.packet.end());
-	uint32_t id;
-	ser.PreRead(id);
-	auto ev_con = std::make_pair<EventSP, ConnectionSPC>
-	  (Factory<Event>::MakeUnique<Deserializer&>(id, ser), con);
+	// uncompressed and deserialized later, so that decoding never holds up the reading
+	auto buf = std::make_shared<const std::string>(std::move(ev.packet));
+	BlockView packet(buf, reinterpret_cast<const uint8_t*>(buf->data()), buf->size());
 	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(ev_con);
-	if(m_qu_ev.size() > 50000){
-	  m_qu_ev.pop();
-	  EUDAQ_WARN("DataReceiver: Buffer of receving event is full.");
+	auto &q = m_qu_con[con];
+	auto item = std::make_shared<Item>(Item{ITEM_EVENT, ITEM_PENDING, packet.size(), packet,
+						{}, q.batch, q.compress});
+	Enqueue(con, item);
+	// a sender without credit is held back by not reading from it
+	if(!q.credit && !q.paused && m_qu_limit && q.bytes > m_qu_limit){
+	  q.paused = true;
+	  lk.unlock();
+	  m_dataserver->PauseReceiving(*con, true);
 	}
-	m_cv_not_empty.notify_all();
       }
       break;
     default:
@@ -111,42 +283,127 @@ namespace eudaq {
     }
   }
 
+  void DataReceiver::FlowControl(){
+    std::map<ConnectionSPC, uint64_t> credits;
+    std::vector<ConnectionSPC> resume;
+    {
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      credits.swap(m_credits);
+      resume.swap(m_resume);
+    }
+    // a closed connection may share its identification with a new one
+    for(auto &con: resume)
+      if(con->GetState())
+	m_dataserver->PauseReceiving(*con, false);
+    for(auto &c: credits){
+      if(!c.first->GetState())
+	continue;
+      try{
+	m_dataserver->SendPacket("CREDIT " + std::to_string(c.second), *c.first);
+      }
+      catch(const std::exception &e){
+	EUDAQ_WARN("DataReceiver: Unable to send credit to " + to_string(*c.first) + ": " + e.what());
+      }
+    }
+  }
+
   bool DataReceiver::AsyncReceiving(){
     m_is_async_rcv_return = false;
     while (m_is_listening){
-      m_dataserver->Process(100000);
+      // short enough for the credit of a waiting sender to be returned promptly
+      m_dataserver->Process(10000);
+      FlowControl();
     }
     m_is_async_rcv_return = true;
     return 0;
   }
 
   bool DataReceiver::AsyncForwarding(){
+    // the decoding workers live as long as the forwarding
+    struct Workers{
+      DataReceiver *r = nullptr;
+      std::vector<std::thread> thds = {};
+      ~Workers(){
+	std::unique_lock<std::mutex> lk(r->m_mx_qu_ev);
+	r->m_decode_exit = true;
+	r->m_n_decode_running = 0;
+	r->m_qu_decode.clear();
+	lk.unlock();
+	r->m_cv_decode.notify_all();
+	for(auto &t: thds)
+	  t.join();
+      }
+    } workers{this};
+    {
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      m_decode_exit = false;
+      m_n_decode_running = m_n_decode;
+    }
+    for(uint32_t i = 0; i < m_n_decode; i++)
+      workers.thds.emplace_back(&DataReceiver::DecodeWorker, this);
+
     while(!m_is_async_rcv_return){
       std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
+      ConnectionSPC con;
+      ItemSP item;
+      while(!(item = NextItem(con))){
 	while(m_cv_not_empty.wait_for(lk, std::chrono::seconds(1))
 	      ==std::cv_status::timeout){
 	  if(m_is_async_rcv_return){
-	    for(auto &con: m_vt_con){
-	      OnDisconnect(con);
+	    for(auto &c: m_vt_con){
+	      OnDisconnect(c);
 	    }
 	    m_vt_con.clear();
 	    return 0;
 	  }
 	}
       }
-      auto ev = m_qu_ev.front().first;
-      auto con = m_qu_ev.front().second;
-      m_qu_ev.pop();
+      // one item per connection in turn, a fast sender cannot hold back the
+      // others; events nobody has started on are deserialized right here
+      bool decode = item->state == ITEM_PENDING;
+      if(decode)
+	item->state = ITEM_DECODING;
       lk.unlock();
-      if(ev){
-	OnReceive(con, ev);
+      if(decode)
+	Decode(*item);
+      switch(item->type){
+      case ITEM_EVENT:
+	for(auto &ev: item->evs)
+	  if(ev)
+	    OnReceive(con, ev);
+	break;
+      case ITEM_CONNECT:
+	OnConnect(con);
+	break;
+      case ITEM_DISCONNECT:
+	OnDisconnect(con);
+	break;
+      }
+      item->evs.clear();
+      lk.lock();
+      if(item->type == ITEM_DISCONNECT){
+	// always the last item of its connection
+	m_qu_con.erase(con);
+	m_credits.erase(con);
+	continue;
+      }
+      auto &q = m_qu_con[con];
+      q.items.pop_front();
+      if(q.items.empty())
+	q.scheduled = false;
+      else
+	m_qu_ready.push_back(con);
+      q.bytes -= item->bytes;
+      if(q.paused && q.bytes <= m_qu_limit / 2){
+	q.paused = false;
+	m_resume.push_back(con);
       }
-      else{
-	if(con->GetState())
-	  OnConnect(con);
-	else{
-	  OnDisconnect(con);
+      if(q.credit){
+	// returned in batches, a sender is only waiting when a whole window is still queued
+	q.consumed += item->bytes;
+	if(q.consumed >= q.window / 4){
+	  m_credits[con] += q.consumed;
+	  q.consumed = 0;
 	}
       }
     }
@@ -158,6 +415,17 @@ namespace eudaq {
     m_vt_con.clear();
     return 0;
   }
+
+  void DataReceiver::ClearQueues(const std::string &when){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    if(!m_qu_ready.empty())
+      EUDAQ_WARN("DataReceiver: Data buffer is not empty during the " + when);
+    m_qu_ready.clear();
+    m_qu_con.clear();
+    m_credits.clear();
+    m_resume.clear();
+    m_qu_decode.clear();
+  }
   
   std::string DataReceiver::Listen(const std::string &addr){
     std::unique_lock<std::mutex> lk_deamon(m_mx_deamon);
@@ -177,6 +445,12 @@ namespace eudaq {
     
     m_last_addr = dataserver->ConnectionString();
     m_dataserver.reset(dataserver);
+    {
+      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+      m_cmp_raw = 0;
+      m_cmp_wire = 0;
+      m_cmp_ms = 0;
+    }
     m_is_listening = true;
     m_is_async_rcv_return = false;
     m_fut_async_rcv = std::async(std::launch::async, &DataReceiver::AsyncReceiving, this); 
@@ -224,10 +498,7 @@ namespace eudaq {
 	  if(m_fut_async_fwd.valid()){
 	    m_fut_async_fwd.get();
 	  }
-	  if(!m_qu_ev.empty()){
-	    EUDAQ_WARN("DataReceiver: Data buffer is not empty during the stopping");
-	    m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
-	  }
+	  ClearQueues("stopping");
 	  if(m_dataserver)
 	    m_dataserver.reset();
 	}
@@ -245,10 +516,7 @@ namespace eudaq {
       if(m_fut_async_fwd.valid()){
 	m_fut_async_fwd.get();
       }
-      if(!m_qu_ev.empty()){
-	EUDAQ_WARN("DataReceiver: Data buffer is not empty during the exiting");
-	m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
-      }
+      ClearQueues("exiting");
       if(m_dataserver)
 	m_dataserver.reset();
     }
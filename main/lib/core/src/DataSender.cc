@@ -1,41 +1,169 @@
 #include "eudaq/Event.hh"
 #include "eudaq/TransportClient.hh"
 #include "eudaq/Exception.hh"
+#include "eudaq/SerializedEvent.hh"
 #include "eudaq/BufferSerializer.hh"
+#include "eudaq/Utils.hh"
 #include "eudaq/Logger.hh"
 #include "eudaq/DataSender.hh"
 
+#include <algorithm>
+
 namespace eudaq {
 
+  const uint32_t DataSender::BATCH_ID;
+  const uint32_t DataSender::COMPRESSED_ID;
+  const uint32_t DataSender::MAX_COMPRESSION_RATIO;
+
+  namespace {
+    // smaller packets are not worth compressing
+    const uint64_t MIN_COMPRESS_BYTES = 256;
+
+    // the type id in front of a serialized packet
+    uint32_t PacketId(const std::vector<GatherSerializer::Segment> &segs){
+      uint32_t id = 0;
+      size_t n = 0;
+      for(auto &s: segs)
+	for(size_t i = 0; i < s.size && n < sizeof(id); i++, n++)
+	  id |= uint32_t(s.data[i]) << (8 * n);
+      return n == sizeof(id) ? id : 0;
+    }
+  }
+
   DataSender::DataSender(const std::string & type, const std::string & name)
     : m_type(type),
     m_name(name),
-    m_packetCounter(0) {}
+    m_packetCounter(0),
+    m_credit_on(false),
+    m_credit(0),
+    m_credit_window(0),
+    m_batch_bytes(0),
+    m_batch_us(0),
+    m_batch_on(false),
+    m_codec(CompressionCodec::NONE),
+    m_codec_on(CompressionCodec::NONE),
+    m_level(0),
+    m_cmp_raw(0),
+    m_cmp_wire(0),
+    m_cmp_ms(0),
+    m_max_bytes(0),
+    m_qu_limit(0),
+    m_policy(QUEUE_BLOCK),
+    m_qu_bytes(0),
+    m_qu_events(0),
+    m_dropped(0),
+    m_latency_sum(0),
+    m_latency_n(0),
+    m_backpressure(false),
+    m_exit(false),
+    m_sent_all(true),
+    m_abort(false),
+    m_stop_ms(10000) {}
 
 
   DataSender::~DataSender(){
-    std::cout<<"dataSender clearing"<<std::endl;
-    m_is_connected = false;
-    if(m_fut_async.valid()){
-      m_fut_async.get();
+    // the events still queued are sent before the connection is closed,
+    // unless they are expendable
+    StopSending();
+  }
+
+  void DataSender::SetQueue(uint64_t max_bytes, QueuePolicy policy){
+    m_max_bytes = max_bytes;
+    m_policy = policy;
+  }
+
+  void DataSender::SetBatching(uint32_t max_bytes, uint32_t max_delay_us){
+    m_batch_bytes = max_bytes;
+    m_batch_us = max_delay_us;
+  }
+
+  void DataSender::SetCompression(CompressionCodec codec, int level){
+    m_codec = codec;
+    m_level = level;
+  }
+
+  void DataSender::SetStopTimeout(uint32_t ms){
+    m_stop_ms = ms;
+  }
+
+  DataSender::CompressionStatus DataSender::GetCompressionStatus(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    return CompressionStatus{m_codec_on, m_cmp_raw, m_cmp_wire, m_cmp_ms};
+  }
+
+  void DataSender::SetBackpressureCallback(std::function<void(bool)> cb){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    m_cb_backpressure = cb;
+  }
+
+  DataSender::QueueStatus DataSender::GetQueueStatus(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    QueueStatus st;
+    st.bytes = m_qu_bytes;
+    st.events = m_qu_events;
+    st.dropped = m_dropped;
+    double latency = m_latency_n ? m_latency_sum / m_latency_n : 0;
+    if(!m_qu_ev.empty()){
+      // a stalled connection shows up as the age of the oldest queued event
+      std::chrono::duration<double, std::milli> age =
+	std::chrono::steady_clock::now() - m_qu_ev.front()->tp;
+      latency = std::max(latency, age.count());
     }
-    std::cout<< "dataSender cleared"<<std::endl;
+    st.latency_ms = latency;
+    m_latency_sum = 0;
+    m_latency_n = 0;
+    return st;
   }
 
-  void DataSender::Connect(const std::string & server) {
-    m_is_connected = false;
-    try{
-      if(m_fut_async.valid()){
-	m_fut_async.get();
-	//previous connection is closed.
+  void DataSender::StopSending(){
+    if(!m_thd_send.joinable())
+      return;
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    m_exit = true;
+    if(m_policy == QUEUE_LATEST){
+      for(auto it = m_qu_ev.begin(); it != m_qu_ev.end();){
+	const Event &ev = (*it)->ev->GetEvent();
+	if(ev.IsBORE() || ev.IsEORE()){
+	  ++it;
+	  continue;
+	}
+	m_qu_bytes -= (*it)->ev->size();
+	m_qu_events--;
+	it = m_qu_ev.erase(it);
       }
     }
-    catch(...){
-      EUDAQ_WARN("DataSender:: connection execption from disconnetion");
+    m_cv_not_empty.notify_all();
+    // a receiver which stopped reading does not hold up the shutdown
+    if(!m_cv_space.wait_for(lk, std::chrono::milliseconds(m_stop_ms),
+			    [this]{return m_sent_all;})){
+      m_abort = true;
+      EUDAQ_WARN("DataSender:: The receiver is not reading, dropping the connection with " +
+		 to_string(m_qu_events) + " events unsent");
+      lk.unlock();
+      m_dataclient->Close(ConnectionInfo::ALL);
     }
-    
-    std::unique_lock<std::mutex> lk(m_mx_qu_ev);    
-    m_qu_ev = std::queue<EventSPC>();    
+    else
+      lk.unlock();
+    m_thd_send.join();
+  }
+
+  void DataSender::Connect(const std::string & server) {
+    StopSending();
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    m_qu_ev.clear();
+    m_qu_bytes = 0;
+    m_qu_events = 0;
+    m_dropped = 0;
+    m_latency_sum = 0;
+    m_latency_n = 0;
+    m_backpressure = false;
+    m_exit = false;
+    m_abort = false;
+    m_error.clear();
+    m_codec_on = CompressionCodec::NONE;
+    m_cmp_raw = 0;
+    m_cmp_wire = 0;
+    m_cmp_ms = 0;
     lk.unlock();
     m_dataclient.reset(TransportClient::CreateClient(server));
     std::string packet;
@@ -67,60 +195,304 @@ namespace eudaq {
     if (part != "DataReceiver" && part != "DataCollector" && part != "Monitor" )
       EUDAQ_THROW("DataSender:: Invalid response from DataReceiver server, part=" + part);
 
-    m_dataclient->SendPacket("OK EUDAQ DATA " + m_type + " " + m_name);
+    // the capabilities of this sender, older receivers ignore them
+    std::string caps = " CREDIT";
+    if(m_batch_bytes)
+      caps += " BATCH";
+    bool compress = m_codec != CompressionCodec::NONE;
+    if(compress && !IsCompressionAvailable(m_codec)){
+      EUDAQ_WARN("DataSender:: " + CompressionCodecName(m_codec) +
+		 " compression is not available in this build, sending uncompressed");
+      compress = false;
+    }
+    if(compress)
+      caps += " COMPRESS " + CompressionCodecName(m_codec);
+    m_dataclient->SendPacket("OK EUDAQ DATA " + m_type + " " + m_name + caps);
     packet = "";
     if (!m_dataclient->ReceivePacket(&packet, 1000000))
       EUDAQ_THROW("DataSender:: No response from DataReceiver server");
-    i1 = packet.find(' ');
-    if (std::string(packet, 0, i1) != "OK")
+    // "OK" followed by the capabilities accepted by the receiver:
+    // "CREDIT <bytes>", the receiver queues at most that many bytes from us;
+    // "BATCH", several events may be sent in one packet;
+    // "COMPRESS <codec>", the packets may be compressed
+    std::vector<std::string> words = split(packet, " ");
+    if (words.empty() || words[0] != "OK")
       EUDAQ_THROW("DataSender:: Connection refused by DataReceiver server: " + packet);
-    m_is_connected = true;
-    m_fut_async = std::async(std::launch::async, &DataSender::AsyncSending, this);
+    m_credit_on = false;
+    m_credit = 0;
+    m_credit_window = 0;
+    m_batch_on = false;
+    for (size_t i = 1; i < words.size(); i++) {
+      if (words[i] == "CREDIT" && i + 1 < words.size()) {
+        m_credit_window = std::stoull(words[++i]);
+        m_credit = m_credit_window;
+        m_credit_on = m_credit_window > 0;
+      }
+      else if (words[i] == "BATCH")
+        m_batch_on = m_batch_bytes > 0;
+      else if (words[i] == "COMPRESS" && i + 1 < words.size()) {
+        if (compress && words[++i] == CompressionCodecName(m_codec))
+          m_codec_on = m_codec;
+      }
+    }
+    if (compress && m_codec_on == CompressionCodec::NONE)
+      EUDAQ_WARN("DataSender:: The receiver does not support " + CompressionCodecName(m_codec) +
+                 " compression, sending uncompressed");
+    // batching alone queues a few batches
+    m_qu_limit = m_max_bytes ? m_max_bytes : 16 * uint64_t(m_batch_bytes);
+    if(IsAsync()){
+      m_sent_all = false;
+      m_thd_send = std::thread(&DataSender::AsyncSending, this);
+    }
   }
 
   void DataSender::SendEvent(EventSPC ev){
+    SendEvent(SerializedEvent::Make(ev));
+  }
+
+  void DataSender::SendEvent(SerializedEventSPC ev){
     if (!m_dataclient)
       EUDAQ_THROW("DataSender:: Transport not connected error");
 
-    /*
+    if(!m_thd_send.joinable()){
+      // large data blocks are sent straight from the event
+      const GatherSerializer &ser = ev->Data();
+      m_packetCounter += 1;
+      //TODO: catch exception below
+      SendData(ser.Segments(), ser.size());
+      return;
+    }
+
+    // serialized on the caller thread, the queue is bounded by the real size
+    std::unique_ptr<Packet> pkt(new Packet);
+    pkt->ev = ev;
+    pkt->tp = std::chrono::steady_clock::now();
+    uint64_t len = ev->size();
+    bool keep = ev->GetEvent().IsBORE() || ev->GetEvent().IsEORE();
+    std::function<void(bool)> cb;
     std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-    m_qu_ev.push(ev);
-    if(m_qu_ev.size() > 50000){
-      m_qu_ev.pop();
-      EUDAQ_WARN("DataSender:: Buffer of sending event is full.");
-    }    
+    if(!m_error.empty())
+      EUDAQ_THROW("DataSender:: " + m_error);
+    // an event larger than the whole queue is accepted when the queue is empty
+    auto has_space = [&](uint64_t limit){
+      return m_qu_bytes + len <= limit || m_qu_events == 0 || !m_error.empty();
+    };
+    if(!has_space(m_qu_limit)){
+      if(m_policy == QUEUE_DROP && !keep){
+	m_dropped++;
+	return;
+      }
+      if(m_policy == QUEUE_LATEST){
+	// never waits: the oldest events not yet being sent make room for the new one
+	for(auto it = m_qu_ev.begin(); it != m_qu_ev.end() && !has_space(m_qu_limit);){
+	  const Event &old = (*it)->ev->GetEvent();
+	  if(old.IsBORE() || old.IsEORE()){
+	    ++it;
+	    continue;
+	  }
+	  m_qu_bytes -= (*it)->ev->size();
+	  m_qu_events--;
+	  m_dropped++;
+	  it = m_qu_ev.erase(it);
+	}
+	m_qu_ev.push_back(std::move(pkt));
+	m_qu_bytes += len;
+	m_qu_events++;
+	lk.unlock();
+	m_cv_not_empty.notify_all();
+	return;
+      }
+      uint64_t limit = m_qu_limit;
+      if(m_policy == QUEUE_SIGNAL){
+	if(!m_backpressure){
+	  m_backpressure = true;
+	  cb = m_cb_backpressure;
+	}
+	// a producer ignoring the signal is blocked at twice the queue size
+	limit = 2 * m_qu_limit;
+      }
+      if(cb){
+	lk.unlock();
+	cb(true);
+	lk.lock();
+      }
+      m_cv_space.wait(lk, [&]{return has_space(limit);});
+      if(!m_error.empty())
+	EUDAQ_THROW("DataSender:: " + m_error);
+    }
+    m_qu_ev.push_back(std::move(pkt));
+    m_qu_bytes += len;
+    m_qu_events++;
+    lk.unlock();
     m_cv_not_empty.notify_all();
-    */
+  }
+
+  void DataSender::TakeCredit(uint64_t len){
+    if(!m_credit_on)
+      return;
+    // the returned credit is only looked at once half of the window is used,
+    // an event may overdraw the credit so that it is never larger than the window
+    if(m_credit > int64_t(m_credit_window / 2)){
+      m_credit -= len;
+      return;
+    }
+    std::string packet;
+    int timeout = 0;
+    while(true){
+      while(m_dataclient->ReceivePacket(&packet, timeout)){
+	if(packet.compare(0, 7, "CREDIT ") == 0)
+	  m_credit += std::stoll(packet.substr(7));
+	else
+	  EUDAQ_WARN("DataSender:: Unexpected packet from DataReceiver server: " + packet);
+	timeout = 0;
+      }
+      if(m_credit > 0)
+	break;
+      {
+	// a receiver which stopped reading does not hold up the shutdown,
+	// expendable events are not waited for at all
+	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+	if(m_abort || (m_exit && m_policy == QUEUE_LATEST))
+	  EUDAQ_THROW("DataSender:: Stopped while waiting for credit from the receiver");
+      }
+      timeout = 1000000;
+    }
+    m_credit -= len;
+  }
 
-    BufferSerializer ser;
-    ev->Serialize(ser);
-    m_packetCounter += 1;
-    //TODO: catch exception below
-    m_dataclient->SendPacket(ser);
+  void DataSender::SendBatch(const std::vector<std::unique_ptr<Packet>> &pkts){
+    BufferSerializer head; // BATCH_ID, count and the length of each event
+    head.write(BATCH_ID);
+    head.write(uint32_t(pkts.size()));
+    for(auto &p: pkts)
+      head.write(uint32_t(p->ev->size()));
+    std::vector<GatherSerializer::Segment> segs;
+    segs.push_back(GatherSerializer::Segment{head.data(), 8});
+    size_t len = head.size();
+    for(size_t i = 0; i < pkts.size(); i++){
+      segs.push_back(GatherSerializer::Segment{head.data() + 8 + 4 * i, 4});
+      for(auto &s: pkts[i]->ev->Data().Segments())
+	segs.push_back(s);
+      len += pkts[i]->ev->size();
+    }
+    SendData(segs, len);
   }
 
-  bool DataSender::AsyncSending(){
-    while(m_is_connected){//TODO:
+  void DataSender::SendData(const std::vector<GatherSerializer::Segment> &segs, uint64_t len){
+    // an event which could be taken for a compressed packet is always framed
+    bool reserved = m_codec_on != CompressionCodec::NONE && PacketId(segs) == COMPRESSED_ID;
+    if(m_codec_on != CompressionCodec::NONE && (len >= MIN_COMPRESS_BYTES || reserved)){
+      auto t0 = std::chrono::steady_clock::now();
+      m_raw.clear();
+      m_raw.reserve(len);
+      for(auto &s: segs)
+	m_raw.insert(m_raw.end(), s.data, s.data + s.size);
+      Compress(m_codec_on, m_raw.data(), m_raw.size(), m_zip, m_level);
+      CompressionCodec codec = m_codec_on;
+      // beyond the ratio the receiver accepts, the data is sent as it is
+      bool ratio_ok = uint64_t(m_zip.size()) * MAX_COMPRESSION_RATIO >= len;
+      if(!ratio_ok && reserved){
+	codec = CompressionCodec::NONE;
+	m_zip.swap(m_raw);
+      }
+      BufferSerializer head;
+      head.write(COMPRESSED_ID);
+      head.write(uint32_t(codec));
+      head.write(uint32_t(len));
+      // data which does not compress is sent as it is
+      bool framed = reserved || (ratio_ok && head.size() + m_zip.size() < len);
+      std::chrono::duration<double, std::milli> dt = std::chrono::steady_clock::now() - t0;
       std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
-	while(m_cv_not_empty.wait_for(lk, std::chrono::milliseconds(100))
-	      ==std::cv_status::timeout){
-	  if(!m_is_connected){
-	    return false;
-	  }
+      m_cmp_raw += len;
+      m_cmp_wire += framed ? head.size() + m_zip.size() : len;
+      m_cmp_ms += dt.count();
+      lk.unlock();
+      if(framed){
+	std::vector<GatherSerializer::Segment> zsegs;
+	zsegs.push_back(GatherSerializer::Segment{head.data(), head.size()});
+	zsegs.push_back(GatherSerializer::Segment{m_zip.data(), m_zip.size()});
+	TakeCredit(head.size() + m_zip.size());
+	m_dataclient->SendPacket(zsegs);
+	return;
+      }
+    }
+    TakeCredit(len);
+    m_dataclient->SendPacket(segs);
+  }
+
+  void DataSender::AsyncSending(){
+    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
+    std::vector<std::unique_ptr<Packet>> pkts;
+    while(true){
+      m_cv_not_empty.wait(lk, [this]{return !m_qu_ev.empty() || m_exit;});
+      if(m_qu_ev.empty())
+	break;
+      pkts.clear();
+      uint64_t len = 0;
+      auto take = [&]{
+	len += m_qu_ev.front()->ev->size();
+	pkts.push_back(std::move(m_qu_ev.front()));
+	m_qu_ev.pop_front();
+      };
+      take();
+      if(m_batch_on){
+	// wait for more events until the first one is due, but never hold
+	// back the end of the run
+	auto due = pkts.front()->tp + std::chrono::microseconds(m_batch_us);
+	while(len < m_batch_bytes && !pkts.back()->ev->GetEvent().IsEORE()){
+	  if(m_qu_ev.empty() &&
+	     (m_exit || !m_cv_not_empty.wait_until(lk, due, [this]{return !m_qu_ev.empty() || m_exit;}) ||
+	      m_qu_ev.empty()))
+	    break;
+	  if(len + m_qu_ev.front()->ev->size() > m_batch_bytes)
+	    break;
+	  take();
 	}
       }
-      auto ev = m_qu_ev.front();
-      m_qu_ev.pop();
       lk.unlock();
-      BufferSerializer ser;
-      ev->Serialize(ser);
+      std::string err;
+      try{
+	// a lone event goes as it is, unless it could be taken for a batch
+	auto segs = pkts.front()->ev->Data().Segments();
+	if(pkts.size() == 1 && !(m_batch_on && PacketId(segs) == BATCH_ID))
+	  SendData(segs, len);
+	else
+	  SendBatch(pkts);
+      }
+      catch(const std::exception &e){
+	err = e.what();
+      }
+      auto tp_sent = std::chrono::steady_clock::now();
+      lk.lock();
       m_packetCounter += 1;
-      //TODO: catch exception below
-      m_dataclient->SendPacket(ser);
+      m_qu_bytes -= len;
+      m_qu_events -= pkts.size();
+      for(auto &p: pkts)
+	m_latency_sum += std::chrono::duration<double, std::milli>(tp_sent - p->tp).count();
+      m_latency_n += pkts.size();
+      if(!err.empty()){
+	// the remaining events cannot be sent anymore
+	m_error = err;
+	m_qu_ev.clear();
+	m_qu_bytes = 0;
+	m_qu_events = 0;
+	m_cv_space.notify_all();
+	EUDAQ_ERROR("DataSender:: " + err);
+	break;
+      }
+      if(m_backpressure && m_qu_bytes <= m_qu_limit / 2){
+	m_backpressure = false;
+	auto cb = m_cb_backpressure;
+	if(cb){
+	  lk.unlock();
+	  cb(false);
+	  lk.lock();
+	}
+      }
+      m_cv_space.notify_all();
     }
-
-    return true;
+    m_sent_all = true;
+    m_cv_space.notify_all();
   }
 
 }
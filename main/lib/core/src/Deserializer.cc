@@ -15,6 +15,13 @@ namespace eudaq{
     Deserialize(dst, size);
   }
 
+  BlockView Deserializer::ReadBlock(size_t len){
+    std::vector<uint8_t> data(len);
+    if(len)
+      Deserialize(&data[0], len);
+    return BlockView(std::move(data));
+  }
+
   void Deserializer::PreRead(uint32_t &t){
       unsigned char buf[sizeof(uint32_t)];
       PreDeserialize(buf, sizeof(uint32_t)); // 1.x serializer is little-endian (same to intel)
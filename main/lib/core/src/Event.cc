@@ -43,6 +43,32 @@ namespace eudaq {
   }  
   
   Event::Event(Deserializer & ds) {
+    Read(ds);
+  }
+
+  void Event::Reset(){
+    m_type = 0;
+    m_version = 2;
+    m_flags = 0;
+    m_stm_n = 0;
+    m_run_n = 0;
+    m_ev_n = 0;
+    m_tg_n = 0;
+    m_extend = 0;
+    m_ts_begin = 0;
+    m_ts_end = 0;
+    m_dspt.clear();
+    m_tags.clear();
+    m_blocks.clear();
+    m_sub_events.clear();
+  }
+
+  void Event::Reset(Deserializer & ds){
+    Reset();
+    Read(ds);
+  }
+
+  void Event::Read(Deserializer & ds){
     ds.read(m_type);
     ds.read(m_version);
     ds.read(m_flags);
@@ -105,9 +131,14 @@ namespace eudaq {
   }
 
   std::vector<uint8_t> Event::GetBlock(uint32_t i) const{
+    return GetBlockView(i).ToVector();
+  }
+
+  BlockView Event::GetBlockView(uint32_t i) const{
     auto it = m_blocks.find(i);
     if(it == m_blocks.end()){
       EUDAQ_WARN(std::string("RAWDATAEVENT:: no bolck with ID ") + std::to_string(i) + " exists");
+      return BlockView();
     }
     return it->second;
   }
@@ -38,6 +38,29 @@ namespace eudaq {
     return level() > 0;
   }
 
+  uint64_t FileDeserializer::Tell() {
+#if EUDAQ_PLATFORM_IS(WIN32)
+    int64_t pos = _ftelli64(m_file);
+#else
+    int64_t pos = ftello(m_file);
+#endif
+    if (pos < 0)
+      EUDAQ_THROWX(FileReadException, "tell failed: " + m_filename);
+    return uint64_t(pos) - level();
+  }
+
+  void FileDeserializer::Seek(uint64_t offset) {
+#if EUDAQ_PLATFORM_IS(WIN32)
+    int ret = _fseeki64(m_file, int64_t(offset), SEEK_SET);
+#else
+    int ret = fseeko(m_file, off_t(offset), SEEK_SET);
+#endif
+    if (ret != 0)
+      EUDAQ_THROWX(FileReadException, "seek to " + to_string(offset) +
+                   " failed: " + m_filename);
+    m_start = m_stop = &m_buf[0];
+  }
+
   size_t FileDeserializer::FillBuffer(size_t min) {
     clearerr(m_file);
     if (level() == 0)
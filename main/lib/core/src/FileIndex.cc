@@ -0,0 +1,116 @@
+#include "eudaq/FileIndex.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/Logger.hh"
+
+#include <algorithm>
+
+namespace eudaq {
+
+  namespace {
+    const uint32_t INDEX_MAGIC = 0x58444945; // "EIDX"
+    const uint32_t INDEX_VERSION = 1;
+
+    template <typename T>
+    const FileIndex::Entry *FindFirst(const std::vector<FileIndex::Entry> &entries,
+                                      T FileIndex::Entry::*key, T value, bool sorted) {
+      if (sorted) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), value,
+                                   [key](const FileIndex::Entry &e, T v) {
+                                     return e.*key < v;
+                                   });
+        return it != entries.end() ? &(*it) : nullptr;
+      }
+      for (auto &e : entries)
+        if (e.*key >= value)
+          return &e;
+      return nullptr;
+    }
+  }
+
+  FileIndex::FileIndex()
+    : m_sorted_ev(true), m_sorted_tg(true), m_sorted_ts(true) {}
+
+  std::string FileIndex::IndexPath(const std::string &datafile) {
+    return datafile + ".idx";
+  }
+
+  void FileIndex::WriteHeader(Serializer &ser) {
+    ser.write(INDEX_MAGIC);
+    ser.write(INDEX_VERSION);
+  }
+
+  void FileIndex::WriteEntry(Serializer &ser, const Entry &e) {
+    ser.write(e.event_n);
+    ser.write(e.trigger_n);
+    ser.write(e.timestamp);
+    ser.write(e.offset);
+  }
+
+  bool FileIndex::Load(const std::string &path) {
+    Clear();
+    std::unique_ptr<FileDeserializer> des;
+    try {
+      des.reset(new FileDeserializer(path, true));
+    } catch (const FileNotFoundException &) {
+      return false;
+    }
+    try {
+      uint32_t magic = 0, version = 0;
+      if (!des->HasData())
+        return false;
+      des->read(magic);
+      des->read(version);
+      if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        EUDAQ_WARN("FileIndex: " + path + " is not a valid index file");
+        return false;
+      }
+      while (des->HasData()) {
+        Entry e;
+        des->read(e.event_n);
+        des->read(e.trigger_n);
+        des->read(e.timestamp);
+        des->read(e.offset);
+        Add(e);
+      }
+    } catch (const FileReadException &) {
+      // a truncated last record, e.g. the file is still being written
+    }
+    return true;
+  }
+
+  void FileIndex::Save(const std::string &path) const {
+    FileSerializer ser(path, true);
+    WriteHeader(ser);
+    for (auto &e : m_entries)
+      WriteEntry(ser, e);
+    ser.Flush();
+  }
+
+  void FileIndex::Add(const Entry &e) {
+    if (!m_entries.empty()) {
+      const Entry &last = m_entries.back();
+      m_sorted_ev = m_sorted_ev && last.event_n <= e.event_n;
+      m_sorted_tg = m_sorted_tg && last.trigger_n <= e.trigger_n;
+      m_sorted_ts = m_sorted_ts && last.timestamp <= e.timestamp;
+    }
+    m_entries.push_back(e);
+  }
+
+  void FileIndex::Clear() {
+    m_entries.clear();
+    m_sorted_ev = m_sorted_tg = m_sorted_ts = true;
+  }
+
+  const FileIndex::Entry *FileIndex::FindEvent(uint32_t event_n) const {
+    return FindFirst(m_entries, &Entry::event_n, event_n, m_sorted_ev);
+  }
+
+  const FileIndex::Entry *FileIndex::FindTrigger(uint32_t trigger_n) const {
+    return FindFirst(m_entries, &Entry::trigger_n, trigger_n, m_sorted_tg);
+  }
+
+  const FileIndex::Entry *FileIndex::FindTimestamp(uint64_t timestamp) const {
+    return FindFirst(m_entries, &Entry::timestamp, timestamp, m_sorted_ts);
+  }
+}
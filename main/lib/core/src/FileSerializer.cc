@@ -6,10 +6,31 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#if EUDAQ_PLATFORM_IS(WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#if EUDAQ_PLATFORM_IS(LINUX) && defined(O_DIRECT)
+#define EUDAQ_WITH_O_DIRECT
+#endif
 
 namespace eudaq {
-  FileSerializer::FileSerializer(const std::string &fname, bool overwrite)
-      : m_file(0), m_filebytes(0) {
+  namespace {
+    // offsets, lengths and buffers of direct I/O are multiples of this
+    const size_t DIRECT_ALIGN = 4096;
+    const size_t DIRECT_BUFFER = 1 << 20;
+  }
+
+  FileSerializer::FileSerializer(const std::string &fname, bool overwrite,
+                                 bool direct)
+      : m_file(0), m_filebytes(0), m_direct_fd(-1), m_dbuf(nullptr),
+        m_dlen(0), m_doff(0) {
     if (!overwrite) {
       FILE *fd = fopen(fname.c_str(), "rb");
       if (fd) {
@@ -20,15 +41,77 @@ namespace eudaq {
     m_file = fopen(fname.c_str(), "wb");
     if (!m_file)
       EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    if (!direct)
+      return;
+#ifdef EUDAQ_WITH_O_DIRECT
+    void *buf = nullptr;
+    if (posix_memalign(&buf, DIRECT_ALIGN, DIRECT_BUFFER) == 0) {
+      m_dbuf = static_cast<uint8_t *>(buf);
+      m_direct_fd = open(fname.c_str(), O_WRONLY | O_DIRECT);
+    }
+    if (m_direct_fd < 0) {
+      free(m_dbuf);
+      m_dbuf = nullptr;
+      EUDAQ_WARN("Direct I/O is not available for " + fname + ", writing through the page cache");
+    }
+#else
+    EUDAQ_WARN("Direct I/O is not supported on this platform, writing " + fname +
+               " through the page cache");
+#endif
   }
 
   FileSerializer::~FileSerializer() {
+#ifdef EUDAQ_WITH_O_DIRECT
+    if (m_direct_fd >= 0) {
+      try {
+        Flush();
+      } catch (const std::exception &e) {
+        EUDAQ_ERROR(e.what());
+      }
+      close(m_direct_fd);
+      free(m_dbuf);
+    }
+#endif
     if (m_file) {
       fclose(m_file);
     }
   }
 
+  void FileSerializer::WriteDirect(size_t len) {
+#ifdef EUDAQ_WITH_O_DIRECT
+    // len is a multiple of DIRECT_ALIGN
+    size_t done = 0;
+    while (done < len) {
+      ssize_t n = pwrite(m_direct_fd, m_dbuf + done, len - done, off_t(m_doff + done));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        EUDAQ_THROW("Error writing to file: " + to_string(errno) + ", " +
+                    strerror(errno));
+      done += n;
+    }
+    m_doff += len;
+    m_dlen -= len;
+    std::memmove(m_dbuf, m_dbuf + len, m_dlen);
+#else
+    (void)len;
+#endif
+  }
+
   void FileSerializer::Serialize(const uint8_t *data, size_t len) {
+    if (m_direct_fd >= 0) {
+      m_filebytes += len;
+      while (len) {
+        size_t n = std::min(len, DIRECT_BUFFER - m_dlen);
+        std::memcpy(m_dbuf + m_dlen, data, n);
+        m_dlen += n;
+        data += n;
+        len -= n;
+        if (m_dlen == DIRECT_BUFFER)
+          WriteDirect(m_dlen);
+      }
+      return;
+    }
     size_t written =
         std::fwrite(reinterpret_cast<const char *>(data), 1, len, m_file);
     m_filebytes += written;
@@ -38,5 +121,40 @@ namespace eudaq {
     }
   }
 
-  void FileSerializer::Flush() { fflush(m_file); }
+  void FileSerializer::Flush() {
+    if (m_direct_fd < 0) {
+      fflush(m_file);
+      return;
+    }
+#ifdef EUDAQ_WITH_O_DIRECT
+    WriteDirect(m_dlen / DIRECT_ALIGN * DIRECT_ALIGN);
+    // the partial last block goes through the page cache, it is written
+    // again directly once it is full
+    size_t done = 0;
+    while (done < m_dlen) {
+      ssize_t n = pwrite(fileno(m_file), m_dbuf + done, m_dlen - done, off_t(m_doff + done));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        EUDAQ_THROW("Error writing to file: " + to_string(errno) + ", " +
+                    strerror(errno));
+      done += n;
+    }
+#endif
+  }
+
+  void FileSerializer::Sync() {
+    Flush();
+#if EUDAQ_PLATFORM_IS(WIN32)
+    int ret = _commit(_fileno(m_file));
+#elif EUDAQ_PLATFORM_IS(MACOSX)
+    int ret = fsync(fileno(m_file));
+#else
+    int ret = fdatasync(fileno(m_file));
+#endif
+    if (ret != 0) {
+      EUDAQ_THROW("Error syncing file: " + to_string(errno) + ", " +
+                  strerror(errno));
+    }
+  }
 }
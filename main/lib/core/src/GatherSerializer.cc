@@ -0,0 +1,53 @@
+#include "eudaq/GatherSerializer.hh"
+
+namespace eudaq {
+
+  GatherSerializer::GatherSerializer(size_t min_block)
+    : m_min_block(min_block), m_size(0) {}
+
+  void GatherSerializer::clear() {
+    m_size = 0;
+    m_buf.clear();
+    m_parts.clear();
+  }
+
+  void GatherSerializer::Serialize(const uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    if (m_parts.empty() || !m_parts.back().block.empty())
+      m_parts.push_back(Part{m_buf.size(), 0, BlockView()});
+    m_buf.insert(m_buf.end(), data, data + len);
+    m_parts.back().size += len;
+    m_size += len;
+  }
+
+  void GatherSerializer::SerializeBlock(const BlockView &b) {
+    if (b.size() < m_min_block) {
+      Serialize(b.data(), b.size());
+      return;
+    }
+    m_parts.push_back(Part{0, b.size(), b});
+    m_size += b.size();
+  }
+
+  std::vector<GatherSerializer::Segment> GatherSerializer::Segments() const {
+    std::vector<Segment> segs;
+    segs.reserve(m_parts.size());
+    for (auto &p : m_parts) {
+      if (p.block.empty())
+        segs.push_back(Segment{m_buf.data() + p.offset, p.size});
+      else
+        segs.push_back(Segment{p.block.data(), p.size});
+    }
+    return segs;
+  }
+
+  std::vector<uint8_t> GatherSerializer::ToVector() const {
+    std::vector<uint8_t> v;
+    v.reserve(m_size);
+    for (auto &s : Segments())
+      v.insert(v.end(), s.data, s.data + s.size);
+    return v;
+  }
+
+}
@@ -0,0 +1,207 @@
+#include "eudaq/MappedFileDeserializer.hh"
+#include "eudaq/Utils.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#if EUDAQ_PLATFORM_IS(WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace eudaq {
+
+  /// A read-only mapping of a file from an offset to its end, as it is at
+  /// construction time
+  class FileMapping {
+  public:
+    /// The offset is rounded down to what the system can map from
+    FileMapping(const std::string &fname, uint64_t offset = 0);
+    ~FileMapping();
+    const uint8_t *data() const { return m_data; }
+    uint64_t begin() const { return m_begin; } // file offset of data()
+    uint64_t end() const { return m_begin + m_size; }
+    static uint64_t FileSize(const std::string &fname);
+  private:
+    FileMapping(const FileMapping &) = delete;
+    FileMapping &operator=(const FileMapping &) = delete;
+    const uint8_t *m_data;
+    uint64_t m_begin;
+    uint64_t m_size;
+  };
+
+#if EUDAQ_PLATFORM_IS(WIN32)
+  FileMapping::FileMapping(const std::string &fname, uint64_t offset)
+    :m_data(nullptr), m_begin(0), m_size(0){
+    HANDLE file = CreateFileA(fname.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+      EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      EUDAQ_THROWX(FileReadException, "Unable to get the size of file: " + fname);
+    }
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    uint64_t total = size.QuadPart;
+    m_begin = std::min(offset, total) / si.dwAllocationGranularity * si.dwAllocationGranularity;
+    m_size = total - m_begin;
+    if (m_size) {
+      HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping)
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ,
+                                                            DWORD(m_begin >> 32), DWORD(m_begin),
+                                                            SIZE_T(m_size)));
+      if (mapping)
+        CloseHandle(mapping);
+      if (!m_data) {
+        CloseHandle(file);
+        EUDAQ_THROWX(FileReadException, "Unable to map file: " + fname);
+      }
+    }
+    CloseHandle(file);
+  }
+
+  FileMapping::~FileMapping(){
+    if (m_data)
+      UnmapViewOfFile(m_data);
+  }
+
+  uint64_t FileMapping::FileSize(const std::string &fname){
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if (!GetFileAttributesExA(fname.c_str(), GetFileExInfoStandard, &attr))
+      return 0;
+    return (uint64_t(attr.nFileSizeHigh) << 32) | attr.nFileSizeLow;
+  }
+#else
+  FileMapping::FileMapping(const std::string &fname, uint64_t offset)
+    :m_data(nullptr), m_begin(0), m_size(0){
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+      EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      EUDAQ_THROWX(FileReadException, "Unable to get the size of file: " + fname);
+    }
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    uint64_t total = st.st_size;
+    m_begin = std::min(offset, total) / page * page;
+    m_size = total - m_begin;
+    if (m_size) {
+      void *addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, off_t(m_begin));
+      if (addr == MAP_FAILED) {
+        close(fd);
+        EUDAQ_THROWX(FileReadException, "Unable to map file: " + fname + ", " +
+                     strerror(errno));
+      }
+      madvise(addr, m_size, MADV_SEQUENTIAL);
+      m_data = static_cast<const uint8_t *>(addr);
+    }
+    close(fd);
+  }
+
+  FileMapping::~FileMapping(){
+    if (m_data)
+      munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+
+  uint64_t FileMapping::FileSize(const std::string &fname){
+    struct stat st;
+    if (stat(fname.c_str(), &st) != 0)
+      return 0;
+    return st.st_size;
+  }
+#endif
+
+  MappedFileDeserializer::MappedFileDeserializer(const std::string &fname)
+    :m_filename(fname), m_map(std::make_shared<const FileMapping>(fname)), m_pos(0){
+  }
+
+  MappedFileDeserializer::~MappedFileDeserializer(){
+  }
+
+  bool MappedFileDeserializer::Remap(){
+    // only the part from the current position on is mapped again, the
+    // blocks read before keep their own mapping alive
+    if (FileMapping::FileSize(m_filename) <= m_map->end())
+      return false;
+    m_map = std::make_shared<const FileMapping>(m_filename, m_pos);
+    return true;
+  }
+
+  bool MappedFileDeserializer::HasData(){
+    if (m_pos < m_map->end())
+      return true;
+    Remap();
+    return m_pos < m_map->end();
+  }
+
+  void MappedFileDeserializer::Seek(uint64_t offset){
+    if (offset < m_map->begin() || offset > m_map->end()) {
+      auto map = std::make_shared<const FileMapping>(m_filename, offset);
+      if (offset > map->end())
+        EUDAQ_THROWX(FileReadException, "seek to " + to_string(offset) +
+                     " beyond the end of file: " + m_filename);
+      m_map = map;
+    }
+    m_pos = offset;
+  }
+
+  const uint8_t *MappedFileDeserializer::Require(size_t len){
+    // a file which is still being written is waited for while it grows, a
+    // writer may have made only part of a record visible yet; a length beyond
+    // the end of a file which stopped growing is an error
+    uint64_t last = m_map->end();
+    int n_idle = 0;
+    const int max_idle = 10;
+    while (m_pos + len > m_map->end()) {
+      if (m_interrupting) {
+        m_interrupting = false;
+        throw InterruptedException();
+      }
+      uint64_t size = FileMapping::FileSize(m_filename);
+      if (m_pos + len <= size) {
+        m_map = std::make_shared<const FileMapping>(m_filename, m_pos);
+        break;
+      }
+      if (size > last) {
+        last = size;
+        n_idle = 0;
+      }
+      else if (++n_idle >= max_idle)
+        EUDAQ_THROWX(FileReadException, "Error reading from file '" + m_filename +
+                     "': unexpected end of file, " + to_string(len) + " bytes needed at byte " +
+                     to_string(m_pos) + " of " + to_string(size));
+      mSleep(10);
+    }
+    return m_map->data() + (m_pos - m_map->begin());
+  }
+
+  void MappedFileDeserializer::Deserialize(uint8_t *data, size_t len){
+    if (!len)
+      return;
+    std::memcpy(data, Require(len), len);
+    m_pos += len;
+  }
+
+  void MappedFileDeserializer::PreDeserialize(uint8_t *data, size_t len){
+    if (!len)
+      return;
+    std::memcpy(data, Require(len), len);
+  }
+
+  BlockView MappedFileDeserializer::ReadBlock(size_t len){
+    const uint8_t *data = Require(len);
+    m_pos += len;
+    return BlockView(m_map, data, len);
+  }
+}
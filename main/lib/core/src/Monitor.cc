@@ -68,6 +68,9 @@ namespace eudaq {
     auto conf = GetConfiguration();
     try {
       SetStatus(Status::STATE_UNCONF, "Configuring");
+      SetPoolCapacity(this, conf->Get("EUDAQ_EVENT_POOL", 0));
+      SetQueueLimit(uint64_t(conf->Get("EUDAQ_DR_BUFFER_MB", 64.)*1024*1024));
+      SetDecodeThreads(conf->Get("EUDAQ_DR_DECODE_THREADS", 0));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -128,6 +131,11 @@ namespace eudaq {
     
   void Monitor::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
+    auto cmp = GetCompressionStatus();
+    if(cmp.wire_bytes){
+      SetStatusTag("RecvCompressRatio", std::to_string(double(cmp.raw_bytes)/cmp.wire_bytes));
+      SetStatusTag("RecvDecompressMs", std::to_string(cmp.cpu_ms));
+    }
     DoStatus();
     CommandReceiver::OnStatus();
   }
@@ -1,12 +1,37 @@
 #include "eudaq/FileDeserializer.hh"
+#include "eudaq/MappedFileDeserializer.hh"
+#include "eudaq/BlockDeserializer.hh"
+#include "eudaq/NativeFormat.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/Logger.hh"
+
+#include <functional>
 
 class NativeFileReader : public eudaq::FileReader {
 public:
   NativeFileReader(const std::string& filename);
   eudaq::EventSPC GetNextEvent()override;
+  bool Seek(uint32_t event_n)override;
+  bool SeekTrigger(uint32_t trigger_n)override;
+  bool SeekTimestamp(uint64_t timestamp)override;
+  bool CanReadRecords()override;
+  bool GetNextRecord(eudaq::BlockView &record)override;
 private:
+  typedef eudaq::NativeFormat::RecordInfo RecordInfo;
+  void Open();
+  void OpenIndex();
+  uint64_t Tell();
+  void SeekOffset(uint64_t offset);
+  bool SeekEntry(const eudaq::FileIndex::Entry *entry);
+  bool SeekRecord(std::function<bool(const RecordInfo&)> match);
   std::unique_ptr<eudaq::FileDeserializer> m_des;
+  std::unique_ptr<eudaq::MappedFileDeserializer> m_mapped;
+  eudaq::Deserializer *m_cur;
+  std::unique_ptr<eudaq::FileIndex> m_index;
+  bool m_has_index;
+  uint32_t m_version;
+  bool m_truncated;
   std::string m_filename;
 };
 
@@ -18,23 +43,150 @@ namespace{
 }
 
 NativeFileReader::NativeFileReader(const std::string& filename)
-  :m_filename(filename){    
+  :m_cur(nullptr), m_has_index(false), m_version(0), m_truncated(false),
+   m_filename(filename){
 }
 
-eudaq::EventSPC NativeFileReader::GetNextEvent(){
-  if(!m_des){
-    m_des.reset(new eudaq::FileDeserializer(m_filename));
-    if(!m_des)
-      EUDAQ_THROW("unable to open file: " + m_filename);
+void NativeFileReader::Open(){
+  if(!m_cur){
+    // the memory mapped file is used unless it is disabled by EUDAQ_FR_MMAP = 0,
+    // blocks of the events read from it refer to the mapped pages directly
+    auto conf = GetConfiguration();
+    if(!conf || conf->Get("EUDAQ_FR_MMAP", 1)){
+      try{
+	m_mapped.reset(new eudaq::MappedFileDeserializer(m_filename));
+	m_cur = m_mapped.get();
+      }
+      catch(const eudaq::FileReadException &e){
+	EUDAQ_WARN("NativeFileReader: " + std::string(e.what()) +
+		   ", falling back to buffered reading");
+      }
+    }
+    if(!m_cur){
+      m_des.reset(new eudaq::FileDeserializer(m_filename));
+      m_cur = m_des.get();
+    }
+    m_version = eudaq::NativeFormat::ReadHeader(*m_cur);
+  }
+}
+
+void NativeFileReader::OpenIndex(){
+  Open();
+  if(!m_index){
+    m_index.reset(new eudaq::FileIndex);
+    m_has_index = m_index->Load(eudaq::FileIndex::IndexPath(m_filename));
+    if(!m_has_index && m_version < 2)
+      EUDAQ_INFO("NativeFileReader: no index for " + m_filename +
+		 ", seeking is disabled (it can be created by euCliIndexer)");
+  }
+}
+
+uint64_t NativeFileReader::Tell(){
+  return m_mapped ? m_mapped->Tell() : m_des->Tell();
+}
+
+void NativeFileReader::SeekOffset(uint64_t offset){
+  if(m_mapped)
+    m_mapped->Seek(offset);
+  else
+    m_des->Seek(offset);
+  m_truncated = false;
+}
+
+bool NativeFileReader::SeekEntry(const eudaq::FileIndex::Entry *entry){
+  if(!entry)
+    return false;
+  SeekOffset(entry->offset);
+  return true;
+}
+
+bool NativeFileReader::SeekRecord(std::function<bool(const RecordInfo&)> match){
+  // without an index the records are scanned by their headers only
+  if(m_version < 2)
+    return false;
+  uint64_t start = Tell();
+  uint64_t offset = eudaq::NativeFormat::HEADER_SIZE;
+  SeekOffset(offset);
+  try{
+    while(m_cur->HasData()){
+      RecordInfo info;
+      eudaq::NativeFormat::PeekRecord(*m_cur, info);
+      offset += eudaq::NativeFormat::RECORD_PREFIX_SIZE + info.length;
+      SeekOffset(offset);
+      // a record is only found if it is complete
+      if(match(info)){
+	SeekOffset(offset - eudaq::NativeFormat::RECORD_PREFIX_SIZE - info.length);
+	return true;
+      }
+    }
   }
-  eudaq::EventUP ev;
+  catch(const eudaq::FileReadException &){
+    // the last record is truncated, it is not found
+  }
+  SeekOffset(start);
+  return false;
+}
+
+bool NativeFileReader::Seek(uint32_t event_n){
+  OpenIndex();
+  if(m_has_index)
+    return SeekEntry(m_index->FindEvent(event_n));
+  return SeekRecord([event_n](const RecordInfo &r){return r.event_n >= event_n;});
+}
+
+bool NativeFileReader::SeekTrigger(uint32_t trigger_n){
+  OpenIndex();
+  if(m_has_index)
+    return SeekEntry(m_index->FindTrigger(trigger_n));
+  return SeekRecord([trigger_n](const RecordInfo &r){return r.trigger_n >= trigger_n;});
+}
+
+bool NativeFileReader::SeekTimestamp(uint64_t timestamp){
+  OpenIndex();
+  if(m_has_index)
+    return SeekEntry(m_index->FindTimestamp(timestamp));
+  return SeekRecord([timestamp](const RecordInfo &r){return r.timestamp >= timestamp;});
+}
+
+bool NativeFileReader::CanReadRecords(){
+  Open();
+  return m_version > 1;
+}
+
+bool NativeFileReader::GetNextRecord(eudaq::BlockView &record){
+  Open();
+  if(m_version < 2 || m_truncated || !m_cur->HasData())
+    return false;
+  try{
+    uint32_t len, type;
+    m_cur->read(len);
+    m_cur->read(type);
+    record = m_cur->ReadBlock(len);
+  }
+  catch(const eudaq::FileReadException &e){
+    EUDAQ_WARN("NativeFileReader: the last record of " + m_filename +
+	       " is truncated, it is ignored");
+    m_truncated = true;
+    return false;
+  }
+  return true;
+}
+
+eudaq::EventSPC NativeFileReader::GetNextEvent(){
+  Open();
   uint32_t id;
-  
-  if(m_des->HasData()){
-    m_des->PreRead(id);
-    ev = eudaq::Factory<eudaq::Event>::
-      Create<eudaq::Deserializer&>(id, *m_des);
-    return std::move(ev);
-  }  else  return nullptr;
-  
+  if(m_version < 2){
+    if(!m_cur->HasData())
+      return nullptr;
+    m_cur->PreRead(id);
+    return eudaq::Factory<eudaq::Event>::
+      Create<eudaq::Deserializer&>(id, *m_cur);
+  }
+  eudaq::BlockView record;
+  if(!GetNextRecord(record))
+    return nullptr;
+  eudaq::BlockDeserializer des(record);
+  des.PreRead(id);
+  return eudaq::Factory<eudaq::Event>::
+    Create<eudaq::Deserializer&>(id, des);
 }
@@ -1,16 +1,67 @@
 #include "eudaq/FileNamer.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileSerializer.hh"
+#include "eudaq/FileIndex.hh"
+#include "eudaq/NativeFormat.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 class NativeFileWriter : public eudaq::FileWriter {
 public:
   NativeFileWriter(const std::string &patt);
+  ~NativeFileWriter() override;
   void WriteEvent(eudaq::EventSPC ev) override;
+  void WriteSerialized(eudaq::SerializedEventSPC sev) override;
   uint64_t FileBytes() const override;
+  void Flush() override;
+  std::map<std::string, std::string> GetStatusTags() override;
 private:
+  // A block of serialized events that is written to the file in one go
+  struct Chunk{
+    std::string filename; // open this file before writing, if not empty
+    eudaq::BufferSerializer data;
+    std::vector<eudaq::FileIndex::Entry> index;
+  };
+  void Configure();
+  std::string OpenNext(uint32_t run_n);
+  void Open(const std::string &filename);
+  void WriteChunk(Chunk &chunk);
+  void HandOver(std::unique_lock<std::mutex> &lk);
+  void IOThread();
+
   std::unique_ptr<eudaq::FileSerializer> m_ser;
+  std::unique_ptr<eudaq::FileSerializer> m_idx;
   std::string m_filepattern;
   uint32_t m_run_n;
+  bool m_configured;
+  bool m_started;
+  bool m_index;
+  bool m_framed;
+
+  // asynchronous mode, enabled by EUDAQ_FW_BUFFER_MB > 0
+  bool m_async;
+  bool m_sync;
+  bool m_direct;
+  size_t m_buffer_bytes;
+  std::chrono::milliseconds m_flush_ms;
+  std::thread m_thd_io;
+  std::mutex m_mtx;
+  std::condition_variable m_cv_io;
+  std::condition_variable m_cv_free;
+  std::unique_ptr<Chunk> m_front;
+  std::unique_ptr<Chunk> m_back;
+  bool m_back_full;
+  bool m_exit;
+  std::string m_io_error;
+  std::atomic<uint64_t> m_file_bytes;
+  std::atomic<uint64_t> m_bytes_accepted;
+  std::atomic<uint64_t> m_bytes_written;
+  uint64_t m_bytes_last_status;
+  std::chrono::steady_clock::time_point m_tp_last_status;
 };
 
 namespace{
@@ -20,31 +71,235 @@ namespace{
     Register<NativeFileWriter, std::string&&>(eudaq::cstr2hash("native"));
 }
 
-NativeFileWriter::NativeFileWriter(const std::string &patt){
+NativeFileWriter::NativeFileWriter(const std::string &patt)
+  :m_run_n(0), m_configured(false), m_started(false), m_index(true),
+   m_framed(eudaq::NativeFormat::DEFAULT_VERSION > 1), m_async(false), m_sync(false), m_direct(false),
+   m_buffer_bytes(0), m_flush_ms(0), m_back_full(false),
+   m_exit(false), m_file_bytes(0), m_bytes_accepted(0), m_bytes_written(0),
+   m_bytes_last_status(0){
   m_filepattern = patt;
 }
-  
+
+NativeFileWriter::~NativeFileWriter(){
+  if(m_thd_io.joinable()){
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_exit = true;
+    lk.unlock();
+    m_cv_io.notify_all();
+    m_thd_io.join();
+  }
+}
+
+void NativeFileWriter::Configure(){
+  m_configured = true;
+  auto conf = GetConfiguration();
+  if(!conf)
+    return;
+  m_index = conf->Get("EUDAQ_FW_INDEX", 1);
+  m_framed = conf->Get("EUDAQ_FW_FORMAT_VERSION", int(eudaq::NativeFormat::DEFAULT_VERSION)) > 1;
+  m_buffer_bytes = size_t(conf->Get("EUDAQ_FW_BUFFER_MB", 0.)*1024*1024);
+  m_flush_ms = std::chrono::milliseconds(conf->Get("EUDAQ_FW_FLUSH_MS", 1000));
+  std::string sync = conf->Get("EUDAQ_FW_SYNC", "none");
+  m_sync = sync == "fdatasync";
+  m_direct = sync == "direct";
+  m_async = m_buffer_bytes > 0;
+  if(m_async){
+    m_front.reset(new Chunk);
+    m_back.reset(new Chunk);
+    m_tp_last_status = std::chrono::steady_clock::now();
+    m_thd_io = std::thread(&NativeFileWriter::IOThread, this);
+  }
+}
+
+std::string NativeFileWriter::OpenNext(uint32_t run_n){
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  m_run_n = run_n;
+  m_started = true;
+  m_file_bytes = 0;
+  return eudaq::FileNamer(m_filepattern).
+    Set('X', ".raw").
+    Set('R', run_n).
+    Set('D', time_str);
+}
+
+void NativeFileWriter::Open(const std::string &filename){
+  m_idx.reset();
+  m_ser.reset(new eudaq::FileSerializer(filename, false, m_direct));
+  if(m_index){
+    m_idx.reset(new eudaq::FileSerializer(eudaq::FileIndex::IndexPath(filename), true));
+    eudaq::FileIndex::WriteHeader(*m_idx);
+  }
+}
+
 void NativeFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  WriteSerialized(eudaq::SerializedEvent::Make(ev));
+}
+
+void NativeFileWriter::WriteSerialized(eudaq::SerializedEventSPC sev) {
+  const eudaq::Event *ev = &sev->GetEvent();
+  if(!m_configured)
+    Configure();
   uint32_t run_n = ev->GetRunN();
-  if(!m_ser || m_run_n != run_n){
-    std::time_t time_now = std::time(nullptr);
-    char time_buff[13];
-    time_buff[12] = 0;
-    std::strftime(time_buff, sizeof(time_buff),
-		  "%y%m%d%H%M%S", std::localtime(&time_now));
-    std::string time_str(time_buff);
-    m_ser.reset(new eudaq::FileSerializer((eudaq::FileNamer(m_filepattern).
-					   Set('X', ".raw").
-					   Set('R', run_n).
-					   Set('D', time_str))));
-    m_run_n = run_n;
+  bool new_file = !m_started || m_run_n != run_n;
+  if(!m_async){
+    if(new_file || !m_ser){
+      Open(OpenNext(run_n));
+      if(m_framed)
+	eudaq::NativeFormat::WriteHeader(*m_ser);
+    }
+    if(!m_ser)
+      EUDAQ_THROW("NativeFileWriter: Attempt to write unopened file");
+    uint64_t offset = m_ser->FileBytes();
+    if(m_framed)
+      eudaq::NativeFormat::WriteRecord(*m_ser, *sev);
+    else
+      sev->WriteTo(*m_ser);
+    m_ser->Flush();
+    m_file_bytes = m_ser->FileBytes();
+    if(m_idx){
+      // the entry is added after the event, so it never points beyond the data
+      eudaq::FileIndex::Entry entry = {ev->GetEventN(), ev->GetTriggerN(),
+				       ev->GetTimestampBegin(), offset};
+      eudaq::FileIndex::WriteEntry(*m_idx, entry);
+      m_idx->Flush();
+    }
+    return;
   }
+
+  std::unique_lock<std::mutex> lk(m_mtx);
+  if(!m_io_error.empty())
+    EUDAQ_THROW("NativeFileWriter: " + m_io_error);
+  if(new_file){
+    if(m_front->data.size())
+      HandOver(lk);
+    m_front->filename = OpenNext(run_n);
+    if(m_framed){
+      eudaq::NativeFormat::WriteHeader(m_front->data);
+      m_file_bytes += eudaq::NativeFormat::HEADER_SIZE;
+      m_bytes_accepted += eudaq::NativeFormat::HEADER_SIZE;
+    }
+  }
+  // the event is serialized into the buffer on the caller thread, all disk
+  // access happens on the I/O thread
+  size_t before = m_front->data.size();
+  if(m_framed)
+    eudaq::NativeFormat::WriteRecord(m_front->data, *sev);
+  else
+    sev->WriteTo(m_front->data);
+  size_t len = m_front->data.size() - before;
+  if(m_index){
+    eudaq::FileIndex::Entry entry = {ev->GetEventN(), ev->GetTriggerN(),
+				     ev->GetTimestampBegin(), m_file_bytes};
+    m_front->index.push_back(entry);
+  }
+  m_file_bytes += len;
+  m_bytes_accepted += len;
+  if(m_front->data.size() >= m_buffer_bytes)
+    HandOver(lk);
+}
+
+void NativeFileWriter::HandOver(std::unique_lock<std::mutex> &lk){
+  // wait for the I/O thread to finish the previous chunk
+  m_cv_free.wait(lk, [this]{return !m_back_full || !m_io_error.empty();});
+  if(!m_io_error.empty())
+    EUDAQ_THROW("NativeFileWriter: " + m_io_error);
+  std::swap(m_front, m_back);
+  m_back_full = true;
+  m_cv_io.notify_all();
+}
+
+void NativeFileWriter::WriteChunk(Chunk &chunk){
+  if(!chunk.filename.empty())
+    Open(chunk.filename);
   if(!m_ser)
     EUDAQ_THROW("NativeFileWriter: Attempt to write unopened file");
-  m_ser->write(*(ev.get())); //TODO: Serializer accepts EventSPC
-  m_ser->Flush();
+  if(chunk.data.size())
+    m_ser->append(chunk.data.data(), chunk.data.size());
+  if(m_sync)
+    m_ser->Sync();
+  else
+    m_ser->Flush();
+  if(m_idx){
+    for(auto &e: chunk.index)
+      eudaq::FileIndex::WriteEntry(*m_idx, e);
+    m_idx->Flush();
+  }
+  m_bytes_written += chunk.data.size();
+  chunk.filename.clear();
+  chunk.data.clear();
+  chunk.index.clear();
 }
-  
+
+void NativeFileWriter::IOThread(){
+  std::unique_lock<std::mutex> lk(m_mtx);
+  while(true){
+    bool timeout = false;
+    if(!m_back_full && !m_exit){
+      if(m_flush_ms.count() > 0)
+	timeout = !m_cv_io.wait_for(lk, m_flush_ms,
+				    [this]{return m_back_full || m_exit;});
+      else
+	m_cv_io.wait(lk, [this]{return m_back_full || m_exit;});
+    }
+    if(!m_back_full && (timeout || m_exit) &&
+       (m_front->data.size() || !m_front->filename.empty())){
+      std::swap(m_front, m_back);
+      m_back_full = true;
+    }
+    if(m_back_full){
+      lk.unlock();
+      std::string err;
+      try{
+	WriteChunk(*m_back);
+      }
+      catch(const std::exception &e){
+	err = e.what();
+      }
+      lk.lock();
+      if(!err.empty())
+	m_io_error = err;
+      m_back_full = false;
+      m_cv_free.notify_all();
+    }
+    else if(m_exit)
+      break;
+  }
+}
+
+void NativeFileWriter::Flush(){
+  if(!m_async){
+    if(m_ser)
+      m_ser->Flush();
+    return;
+  }
+  std::unique_lock<std::mutex> lk(m_mtx);
+  if(m_front->data.size() || !m_front->filename.empty())
+    HandOver(lk);
+  m_cv_free.wait(lk, [this]{return !m_back_full || !m_io_error.empty();});
+  if(!m_io_error.empty())
+    EUDAQ_THROW("NativeFileWriter: " + m_io_error);
+}
+
 uint64_t NativeFileWriter::FileBytes() const {
-  return m_ser ?m_ser->FileBytes() :0;
+  return m_file_bytes;
+}
+
+std::map<std::string, std::string> NativeFileWriter::GetStatusTags(){
+  std::map<std::string, std::string> tags;
+  if(!m_async)
+    return tags;
+  auto tp_now = std::chrono::steady_clock::now();
+  uint64_t written = m_bytes_written;
+  double dt = std::chrono::duration<double>(tp_now - m_tp_last_status).count();
+  if(dt > 0)
+    tags["FW_MBPS"] = std::to_string((written - m_bytes_last_status)/dt/1e6);
+  tags["FW_QUEUE_KB"] = std::to_string((m_bytes_accepted - written)/1024);
+  m_bytes_last_status = written;
+  m_tp_last_status = tp_now;
+  return tags;
 }
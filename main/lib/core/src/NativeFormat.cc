@@ -0,0 +1,70 @@
+#include "eudaq/NativeFormat.hh"
+#include "eudaq/GatherSerializer.hh"
+
+namespace eudaq {
+
+  const uint32_t NativeFormat::MAGIC;
+  const uint32_t NativeFormat::VERSION;
+  const uint32_t NativeFormat::HEADER_SIZE;
+  const uint32_t NativeFormat::RECORD_PREFIX_SIZE;
+
+  namespace {
+    // size of the Event members in front of the description string
+    const size_t EVENT_HEADER_SIZE = 48;
+
+    uint64_t get_le(const uint8_t *p, size_t n) {
+      uint64_t v = 0;
+      for (size_t i = 0; i < n; ++i)
+        v |= uint64_t(p[i]) << (8 * i);
+      return v;
+    }
+  }
+
+  void NativeFormat::WriteHeader(Serializer &ser) {
+    ser.write(MAGIC);
+    ser.write(VERSION);
+  }
+
+  void NativeFormat::WriteRecord(Serializer &ser, const Event &ev) {
+    // the length is only known once serialized; the gather serializer refers
+    // to the data blocks, so that they are copied once, into the record
+    GatherSerializer payload;
+    payload.write(ev);
+    ser.write(uint32_t(payload.size()));
+    ser.write(ev.GetType());
+    for (auto &s : payload.Segments())
+      ser.append(s.data, s.size);
+  }
+
+  void NativeFormat::WriteRecord(Serializer &ser, const SerializedEvent &ev) {
+    ser.write(uint32_t(ev.size()));
+    ser.write(ev.GetEvent().GetType());
+    ev.WriteTo(ser);
+  }
+
+  uint32_t NativeFormat::ReadHeader(Deserializer &des) {
+    if (!des.HasData())
+      return VERSION;
+    uint32_t magic;
+    des.PreRead(magic);
+    if (magic != MAGIC)
+      return 1;
+    uint32_t version;
+    des.read(magic);
+    des.read(version);
+    if (version != VERSION)
+      EUDAQ_THROW("NativeFormat: unsupported file format version " + to_string(version));
+    return version;
+  }
+
+  void NativeFormat::PeekRecord(Deserializer &des, RecordInfo &info) {
+    uint8_t buf[RECORD_PREFIX_SIZE + EVENT_HEADER_SIZE];
+    des.PreRead(buf, sizeof(buf));
+    const uint8_t *ev = buf + RECORD_PREFIX_SIZE;
+    info.length = uint32_t(get_le(buf, 4));
+    info.type = uint32_t(get_le(buf + 4, 4));
+    info.event_n = uint32_t(get_le(ev + 20, 4));
+    info.trigger_n = uint32_t(get_le(ev + 24, 4));
+    info.timestamp = get_le(ev + 32, 8);
+  }
+}
@@ -0,0 +1,58 @@
+#include "eudaq/ObjectPool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+namespace eudaq {
+  namespace{
+    std::atomic<size_t> pool_capacity(0);
+
+    // never destroyed, like the pools themselves
+    std::mutex &pools_mutex(){
+      static std::mutex *mtx = new std::mutex;
+      return *mtx;
+    }
+
+    std::vector<ObjectPoolBase*> &pools(){
+      static std::vector<ObjectPoolBase*> *v = new std::vector<ObjectPoolBase*>;
+      return *v;
+    }
+
+    // per owner, SetPoolCapacity(n) is the request of nullptr
+    std::map<const void*, size_t> &requests(){
+      static std::map<const void*, size_t> *m = new std::map<const void*, size_t>;
+      return *m;
+    }
+  }
+
+  ObjectPoolBase::ObjectPoolBase(){
+    std::lock_guard<std::mutex> lk(pools_mutex());
+    pools().push_back(this);
+  }
+
+  void SetPoolCapacity(size_t n){
+    SetPoolCapacity(nullptr, n);
+  }
+
+  void SetPoolCapacity(const void *owner, size_t n){
+    std::vector<ObjectPoolBase*> all;
+    size_t cap = 0;
+    {
+      std::lock_guard<std::mutex> lk(pools_mutex());
+      requests()[owner] = n;
+      for(auto &r: requests())
+	cap = std::max(cap, r.second);
+      size_t old = pool_capacity.exchange(cap);
+      if(cap >= old)
+	return;
+      all = pools();
+    }
+    for(auto pool: all)
+      pool->Trim(cap);
+  }
+
+  size_t GetPoolCapacity(){
+    return pool_capacity;
+  }
+}
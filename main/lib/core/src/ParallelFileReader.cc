@@ -0,0 +1,185 @@
+#include "eudaq/ParallelFileReader.hh"
+#include "eudaq/BlockDeserializer.hh"
+
+#include <algorithm>
+
+namespace eudaq {
+
+  namespace {
+    // limit on the number of events read ahead, in addition to the budget
+    const uint64_t MAX_EVENTS_AHEAD = 4096;
+
+    // memory held by an event read ahead, counted against the budget
+    uint64_t EventBytes(const Event &ev) {
+      uint64_t bytes = sizeof(Event);
+      for (auto n : ev.GetBlockNumList())
+        bytes += ev.GetBlockView(n).size();
+      for (auto &sub : ev.GetSubEvents())
+        bytes += EventBytes(*sub);
+      return bytes;
+    }
+  }
+
+  ParallelFileReader::ParallelFileReader(FileReaderSP reader, uint32_t n_workers,
+                                         uint64_t budget_bytes)
+    : m_reader(reader), m_n_workers(n_workers), m_budget(budget_bytes),
+      m_records(false), m_running(false), m_stop(false), m_eof(false),
+      m_seq_in(0), m_seq_out(0), m_bytes(0) {
+    if (!m_reader)
+      EUDAQ_THROW("ParallelFileReader: no FileReader to read from");
+    if (!m_n_workers)
+      m_n_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  ParallelFileReader::~ParallelFileReader() {
+    Stop();
+  }
+
+  void ParallelFileReader::Start() {
+    m_records = m_reader->CanReadRecords();
+    m_stop = false;
+    m_running = true;
+    m_thd_prefetch = std::thread(&ParallelFileReader::Prefetch, this);
+    if (m_records)
+      for (uint32_t i = 0; i < m_n_workers; i++)
+        m_thd_workers.emplace_back(&ParallelFileReader::Work, this);
+  }
+
+  void ParallelFileReader::Stop() {
+    // the threads are stopped, but what was read ahead is kept
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_stop = true;
+    lk.unlock();
+    m_cv_prefetch.notify_all();
+    m_cv_work.notify_all();
+    if (m_thd_prefetch.joinable())
+      m_thd_prefetch.join();
+    for (auto &thd : m_thd_workers)
+      thd.join();
+    m_thd_workers.clear();
+    m_running = false;
+  }
+
+  void ParallelFileReader::Reset() {
+    m_jobs.clear();
+    m_results.clear();
+    m_prefetch_err = nullptr;
+    m_eof = false;
+    m_seq_in = m_seq_out = 0;
+    m_bytes = 0;
+  }
+
+  void ParallelFileReader::Prefetch() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (!m_eof) {
+      m_cv_prefetch.wait(lk, [this] {
+        return m_stop || (m_bytes < m_budget && m_seq_in - m_seq_out < MAX_EVENTS_AHEAD);
+      });
+      if (m_stop)
+        break;
+      lk.unlock();
+      BlockView record;
+      EventSPC ev;
+      bool ok = false;
+      std::exception_ptr err;
+      try {
+        if (m_records)
+          ok = m_reader->GetNextRecord(record);
+        else
+          ok = bool(ev = m_reader->GetNextEvent());
+      } catch (...) {
+        err = std::current_exception();
+      }
+      lk.lock();
+      if (!ok) {
+        m_prefetch_err = err;
+        m_eof = true;
+      } else if (m_records) {
+        Job job = {m_seq_in++, record};
+        m_bytes += record.size();
+        m_jobs.push_back(job);
+        m_cv_work.notify_one();
+      } else {
+        Result res = {ev, EventBytes(*ev), nullptr};
+        m_bytes += res.bytes;
+        m_results[m_seq_in++] = res;
+      }
+      m_cv_out.notify_all();
+    }
+    m_cv_work.notify_all();
+  }
+
+  void ParallelFileReader::Work() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (true) {
+      m_cv_work.wait(lk, [this] { return m_stop || !m_jobs.empty() || m_eof; });
+      if (m_stop || m_jobs.empty())
+        break;
+      Job job = m_jobs.front();
+      m_jobs.pop_front();
+      lk.unlock();
+      Result res = {nullptr, job.record.size(), nullptr};
+      try {
+        BlockDeserializer des(job.record);
+        uint32_t id;
+        des.PreRead(id);
+        res.ev = Factory<Event>::Create<Deserializer &>(id, des);
+      } catch (...) {
+        res.err = std::current_exception();
+      }
+      lk.lock();
+      m_results[job.seq] = res;
+      m_cv_out.notify_all();
+    }
+  }
+
+  EventSPC ParallelFileReader::GetNextEvent() {
+    if (!m_running)
+      Start();
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_cv_out.wait(lk, [this] {
+      return m_results.count(m_seq_out) || (m_eof && m_seq_out == m_seq_in);
+    });
+    auto it = m_results.find(m_seq_out);
+    if (it == m_results.end()) {
+      std::exception_ptr err = m_prefetch_err;
+      m_prefetch_err = nullptr;
+      if (err)
+        std::rethrow_exception(err);
+      return nullptr;
+    }
+    Result res = it->second;
+    m_results.erase(it);
+    m_seq_out++;
+    m_bytes -= res.bytes;
+    lk.unlock();
+    m_cv_prefetch.notify_one();
+    if (res.err)
+      std::rethrow_exception(res.err);
+    return res.ev;
+  }
+
+  bool ParallelFileReader::Seek(uint32_t event_n) {
+    Stop();
+    if (!m_reader->Seek(event_n))
+      return false;
+    Reset();
+    return true;
+  }
+
+  bool ParallelFileReader::SeekTrigger(uint32_t trigger_n) {
+    Stop();
+    if (!m_reader->SeekTrigger(trigger_n))
+      return false;
+    Reset();
+    return true;
+  }
+
+  bool ParallelFileReader::SeekTimestamp(uint64_t timestamp) {
+    Stop();
+    if (!m_reader->SeekTimestamp(timestamp))
+      return false;
+    Reset();
+    return true;
+  }
+}
@@ -1,6 +1,8 @@
 #include "eudaq/TransportClient.hh"
 #include "eudaq/Producer.hh"
 
+#include <algorithm>
+
 namespace eudaq {
 
   template class DLLEXPORT Factory<Producer>;
@@ -43,6 +45,7 @@ namespace eudaq {
       if(!conf)
 	EUDAQ_THROW("No Configuration Section for OnConfigure");
       m_pdc_n = conf->Get("EUDAQ_ID", m_pdc_n);
+      SetPoolCapacity(this, conf->Get("EUDAQ_EVENT_POOL", 0));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const std::exception &e) {
@@ -61,6 +64,22 @@ namespace eudaq {
 	EUDAQ_THROW("OnStartRun can not be called unless in STATE_CONF");
       std::map<std::string, std::shared_ptr<DataSender>> senders;
       std::string dc_str = GetConfiguration()->Get("EUDAQ_DC", "");
+      // asynchronous sending through a bounded queue, if EUDAQ_DS_BUFFER_MB > 0
+      uint64_t ds_bytes = uint64_t(GetConfiguration()->Get("EUDAQ_DS_BUFFER_MB", 0.)*1024*1024);
+      std::string ds_policy = GetConfiguration()->Get("EUDAQ_DS_POLICY", "block");
+      DataSender::QueuePolicy policy = DataSender::QUEUE_BLOCK;
+      if(ds_policy == "drop")
+	policy = DataSender::QUEUE_DROP;
+      else if(ds_policy == "signal")
+	policy = DataSender::QUEUE_SIGNAL;
+      else if(ds_policy != "block")
+	EUDAQ_WARN("Unknown EUDAQ_DS_POLICY '" + ds_policy + "', using 'block'");
+      // several small events per packet, if EUDAQ_DS_BATCH_KB > 0
+      uint32_t batch_bytes = uint32_t(GetConfiguration()->Get("EUDAQ_DS_BATCH_KB", 0.)*1024);
+      uint32_t batch_us = GetConfiguration()->Get("EUDAQ_DS_BATCH_US", 1000);
+      // compressed packets, if the collector supports the codec (lz4 or zstd)
+      CompressionCodec codec = CompressionCodecFromName(GetConfiguration()->Get("EUDAQ_DS_COMPRESSION", "none"));
+      int codec_level = GetConfiguration()->Get("EUDAQ_DS_COMPRESSION_LEVEL", 0);
       std::vector<std::string> col_dc_name = split(dc_str, ";,", true);
       std::string cur_backup = GetConfiguration()->GetCurrentSectionName();
       GetConfiguration()->SetSection("");
@@ -69,6 +88,10 @@ namespace eudaq {
 	if(!dc_addr.empty()){
 	  senders[dc_addr]
 	    = std::unique_ptr<DataSender>(new DataSender("Producer", GetName()));
+	  senders[dc_addr]->SetQueue(ds_bytes, policy);
+	  senders[dc_addr]->SetBatching(batch_bytes, batch_us);
+	  senders[dc_addr]->SetCompression(codec, codec_level);
+	  senders[dc_addr]->SetBackpressureCallback([this](bool busy){DoBackpressure(busy);});
 	  senders[dc_addr]->Connect(dc_addr);
 	}
       }
@@ -140,6 +163,38 @@ namespace eudaq {
   void Producer::OnStatus(){
     try{
       SetStatusTag("EventN", std::to_string(m_evt_c));
+      std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = m_senders;
+      lk.unlock();
+      DataSender::QueueStatus sum = {0, 0, 0, 0};
+      DataSender::CompressionStatus cmp = {CompressionCodec::NONE, 0, 0, 0};
+      bool async = false;
+      for(auto &e: senders){
+	if(!e.second)
+	  continue;
+	auto cst = e.second->GetCompressionStatus();
+	cmp.raw_bytes += cst.raw_bytes;
+	cmp.wire_bytes += cst.wire_bytes;
+	cmp.cpu_ms += cst.cpu_ms;
+	if(!e.second->IsAsync())
+	  continue;
+	auto st = e.second->GetQueueStatus();
+	async = true;
+	sum.bytes += st.bytes;
+	sum.events += st.events;
+	sum.dropped += st.dropped;
+	sum.latency_ms = std::max(sum.latency_ms, st.latency_ms);
+      }
+      if(async){
+	SetStatusTag("SendQueueKB", std::to_string(sum.bytes/1024));
+	SetStatusTag("SendQueueN", std::to_string(sum.events));
+	SetStatusTag("SendDropped", std::to_string(sum.dropped));
+	SetStatusTag("SendLatencyMs", std::to_string(sum.latency_ms));
+      }
+      if(cmp.wire_bytes){
+	SetStatusTag("SendCompressRatio", std::to_string(double(cmp.raw_bytes)/cmp.wire_bytes));
+	SetStatusTag("SendCompressMs", std::to_string(cmp.cpu_ms));
+      }
       DoStatus();
     }catch (const std::exception &e) {
       printf("Caught exception: %s\n", e.what());
@@ -164,9 +219,11 @@ namespace eudaq {
     std::unique_lock<std::mutex> lk(m_mtx_sender);
     auto senders = m_senders; //hold on the ptrs
     lk.unlock();
+    // serialized once for all the data collectors
+    auto sev = SerializedEvent::Make(ev);
     for(auto &e: senders){
       if(e.second)
-	e.second->SendEvent(ev);
+	e.second->SendEvent(sev);
       else
 	EUDAQ_THROW("Producer::SendEvent, using a null pointer of DataSender");
     }
@@ -2,8 +2,8 @@
 
 namespace eudaq {  
   namespace{
-    auto dummy0 = Factory<Event>::Register<RawEvent, Deserializer&>(RawEvent::m_id_factory);
-    auto dummy3 = Factory<Event>::Register<RawEvent>(RawEvent::m_id_factory);
+    auto dummy0 = Factory<Event>::RegisterPooled<RawEvent, Deserializer&>(RawEvent::m_id_factory);
+    auto dummy3 = Factory<Event>::RegisterPooled<RawEvent>(RawEvent::m_id_factory);
   }
   
   RawEvent::RawEvent(){
@@ -12,7 +12,16 @@ namespace eudaq {
   
   RawEvent::RawEvent(Deserializer &ds)
     :Event(ds){
-  }  
+  }
+
+  void RawEvent::Reset(){
+    Event::Reset();
+    SetType(m_id_factory);
+  }
+
+  void RawEvent::Reset(Deserializer &ds){
+    Event::Reset(ds);
+  }
 }
 
   // RawDataEvent::RawDataEvent(const std::string& dspt, uint32_t dev_n, uint32_t run_n, uint32_t ev_n)
@@ -0,0 +1,26 @@
+#include "eudaq/SerializedEvent.hh"
+#include "eudaq/Exception.hh"
+
+namespace eudaq {
+
+  SerializedEvent::SerializedEvent(EventSPC ev)
+    :m_ev(ev){
+    if(!m_ev)
+      EUDAQ_THROW("SerializedEvent: null event");
+  }
+
+  SerializedEventSPC SerializedEvent::Make(EventSPC ev){
+    return std::make_shared<const SerializedEvent>(ev);
+  }
+
+  const GatherSerializer &SerializedEvent::Data() const {
+    std::call_once(m_once, [this]{m_ev->Serialize(m_ser);});
+    return m_ser;
+  }
+
+  void SerializedEvent::WriteTo(Serializer &ser) const {
+    for(auto &s: Data().Segments())
+      ser.append(s.data, s.size);
+  }
+
+}
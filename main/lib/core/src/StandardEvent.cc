@@ -7,8 +7,8 @@
 namespace eudaq {
 
   namespace{
-    auto dummy0 = Factory<Event>::Register<StandardEvent, Deserializer&>(StandardEvent::m_id_factory);
-    auto dummy3 = Factory<Event>::Register<StandardEvent>(StandardEvent::m_id_factory);
+    auto dummy0 = Factory<Event>::RegisterPooled<StandardEvent, Deserializer&>(StandardEvent::m_id_factory);
+    auto dummy3 = Factory<Event>::RegisterPooled<StandardEvent>(StandardEvent::m_id_factory);
   }
 
   StdEventSP StandardEvent::MakeShared(){
@@ -21,11 +21,45 @@ namespace eudaq {
   }
 
   StandardEvent::StandardEvent(Deserializer &ds) : Event(ds) {
-    ds.read(m_planes);
+    Read(ds);
+  }
+
+  void StandardEvent::Reset(){
+    Event::Reset();
+    SetType(m_id_factory);
+    for(auto &plane: m_planes)
+      m_spare_planes.push_back(std::move(plane));
+    m_planes.clear();
+    time_begin = 0;
+    time_end = 0;
+    detector_type.clear();
+  }
+
+  void StandardEvent::Reset(Deserializer &ds){
+    Reset();
+    Event::Reset(ds);
+    Read(ds);
+  }
+
+  void StandardEvent::Read(Deserializer &ds){
+    uint32_t n;
+    ds.read(n);
+    for(uint32_t i = 0; i < n; i++){
+      if(m_spare_planes.empty())
+	m_planes.emplace_back(ds);
+      else
+	NextPlane().Reset(ds);
+    }
     ds.read(time_begin);
     ds.read(time_end);
   }
 
+  StandardPlane &StandardEvent::NextPlane(){
+    m_planes.push_back(std::move(m_spare_planes.back()));
+    m_spare_planes.pop_back();
+    return m_planes.back();
+  }
+
   void StandardEvent::Serialize(Serializer &ser) const {
     Event::Serialize(ser);
     ser.write(m_planes);
@@ -64,7 +98,21 @@ namespace eudaq {
   }
 
   StandardPlane &StandardEvent::AddPlane(const StandardPlane &plane) {
-    m_planes.push_back(plane);
+    if(m_spare_planes.empty())
+      m_planes.push_back(plane);
+    else
+      NextPlane() = plane;
     return m_planes.back();
   }
+
+  StandardPlane &StandardEvent::AddPlane(uint32_t id, const std::string &type,
+					 const std::string &sensor) {
+    if(m_spare_planes.empty()){
+      m_planes.emplace_back(id, type, sensor);
+      return m_planes.back();
+    }
+    StandardPlane &plane = NextPlane();
+    plane.Reset(id, type, sensor);
+    return plane;
+  }
 }
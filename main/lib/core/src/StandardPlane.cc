@@ -1,18 +1,96 @@
 #include "eudaq/StandardPlane.hh"
 
+#include <stdexcept>
+
 namespace eudaq{
+  namespace{
+    // Set in the serialized flags to mark the columnar layout, planes
+    // without it are read from the nested vectors of older files.
+    const uint32_t FORMAT_COLUMNS = 0x80000000;
+    // Set with FORMAT_COLUMNS when the coordinates are written as doubles
+    const uint32_t FORMAT_WIDE_COORDS = 0x40000000;
+
+    template <typename T>
+    void InsertAt(std::vector<T> &v, size_t i, const T &value) {
+      if (i == v.size())
+        v.push_back(value);
+      else
+        v.insert(v.begin() + i, value);
+    }
+
+    template <typename T>
+    void FillColumn(std::vector<T> &dst, const std::vector<double> &values) {
+      dst.resize(values.size());
+      for (size_t i = 0; i < values.size(); ++i)
+        dst[i] = static_cast<T>(values[i]);
+    }
+
+    StandardPlane::PIXELTYPE PixelTypeOf(double pix) {
+      if (pix >= 0 && pix <= 0xff && pix == static_cast<uint8_t>(pix))
+        return StandardPlane::PIXEL_UINT8;
+      if (pix >= 0 && pix <= 0xffff && pix == static_cast<uint16_t>(pix))
+        return StandardPlane::PIXEL_UINT16;
+      if (pix >= INT32_MIN && pix <= INT32_MAX && pix == static_cast<int32_t>(pix))
+        return StandardPlane::PIXEL_INT32;
+      return StandardPlane::PIXEL_DOUBLE;
+    }
+
+    bool IsCoord(double c) {
+      return c >= 0 && c <= 0xffff && c == static_cast<uint16_t>(c);
+    }
+  }
+
   StandardPlane::StandardPlane()
-    : m_id(0), m_xsize(0), m_ysize(0), m_flags(0),
-      m_pivotpixel(0), m_result_pix(0), m_result_x(0), m_result_y(0) {}
+    : m_id(0), m_xsize(0), m_ysize(0), m_flags(0), m_pivotpixel(0),
+      m_pixtype(PIXEL_UINT8), m_pixtype_min(PIXEL_UINT8),
+      m_result(false), m_result_direct(false) {}
 
   StandardPlane::StandardPlane(uint32_t id, const std::string &type,
 			       const std::string &sensor)
     : m_type(type), m_sensor(sensor), m_id(id), m_xsize(0),
-      m_ysize(0), m_flags(0), m_pivotpixel(0), m_result_pix(0), m_result_x(0),
-      m_result_y(0) {}
+      m_ysize(0), m_flags(0), m_pivotpixel(0),
+      m_pixtype(PIXEL_UINT8), m_pixtype_min(PIXEL_UINT8),
+      m_result(false), m_result_direct(false) {}
 
   StandardPlane::StandardPlane(Deserializer &ds)
-    : m_result_pix(0), m_result_x(0), m_result_y(0) {
+    : m_pixtype(PIXEL_UINT8), m_pixtype_min(PIXEL_UINT8),
+      m_result(false), m_result_direct(false) {
+    Reset(ds);
+  }
+
+  void StandardPlane::Reset(uint32_t id, const std::string &type,
+                            const std::string &sensor) {
+    m_type = type;
+    m_sensor = sensor;
+    m_id = id;
+    m_xsize = 0;
+    m_ysize = 0;
+    m_flags = 0;
+    m_pivotpixel = 0;
+    m_timestamp = 0;
+    m_offsets.clear();
+    m_pixtype = PIXEL_UINT8;
+    m_pixtype_min = PIXEL_UINT8;
+    m_pix_u8.clear();
+    m_pix_u16.clear();
+    m_pix_i32.clear();
+    m_pix_f64.clear();
+    m_coord_wide = false;
+    m_x.clear();
+    m_y.clear();
+    m_xw.clear();
+    m_yw.clear();
+    m_pivot.clear();
+    m_mat.clear();
+    m_time.clear();
+    m_waveform.clear();
+    m_waveform_x0.clear();
+    m_waveform_dx.clear();
+    m_result = false;
+  }
+
+  void StandardPlane::Reset(Deserializer &ds) {
+    Reset(0, "", "");
     ds.read(m_type);
     ds.read(m_sensor);
     ds.read(m_id);
@@ -20,15 +98,88 @@ namespace eudaq{
     ds.read(m_ysize);
     ds.read(m_flags);
     ds.read(m_pivotpixel);
-    ds.read(m_pix);
+    if (!(m_flags & FORMAT_COLUMNS)) {
+      ReadLegacy(ds);
+      return;
+    }
+    m_coord_wide = (m_flags & FORMAT_WIDE_COORDS) != 0;
+    m_flags &= ~(FORMAT_COLUMNS | FORMAT_WIDE_COORDS);
+    ds.read(m_offsets);
+    uint32_t pixtype;
+    ds.read(pixtype);
+    if (pixtype > PIXEL_DOUBLE)
+      EUDAQ_THROW("Unknown pixel type " + to_string(pixtype) + " in StandardPlane");
+    m_pixtype = static_cast<PIXELTYPE>(pixtype);
+    switch (m_pixtype) {
+    case PIXEL_UINT8: ds.read(m_pix_u8); break;
+    case PIXEL_UINT16: ds.read(m_pix_u16); break;
+    case PIXEL_INT32: ds.read(m_pix_i32); break;
+    case PIXEL_DOUBLE: ds.read(m_pix_f64); break;
+    }
+    if (m_coord_wide) {
+      ds.read(m_xw);
+      ds.read(m_yw);
+    } else {
+      ds.read(m_x);
+      ds.read(m_y);
+    }
+    ds.read(m_pivot);
+    ds.read(m_mat);
+    ds.read(m_time);
     ds.read(m_waveform);
     ds.read(m_waveform_x0);
     ds.read(m_waveform_dx);
-    ds.read(m_x);
-    ds.read(m_y);
-    ds.read(m_pivot);
+  }
+
+  void StandardPlane::ReadLegacy(Deserializer &ds) {
+    std::vector<std::vector<double>> pix, x0, dx, x, y;
+    std::vector<std::vector<std::vector<double>>> waveform;
+    std::vector<std::vector<bool>> pivot;
+    std::vector<std::vector<uint64_t>> time;
+    ds.read(pix);
+    ds.read(waveform);
+    ds.read(x0);
+    ds.read(dx);
+    ds.read(x);
+    ds.read(y);
+    ds.read(pivot);
     ds.read(m_mat);
-    ds.read(m_time);
+    ds.read(time);
+
+    size_t n = 0;
+    m_offsets.assign(1, 0);
+    for (auto &frame : pix) {
+      for (auto p : frame)
+        InsertPixValue(n++, p);
+      m_offsets.push_back(n);
+    }
+    bool has_time = false, has_waveform = false;
+    for (size_t s = 0; s < x.size(); ++s) {
+      for (size_t i = 0; i < x[s].size(); ++i) {
+        InsertCoord(NumCoords(), x[s][i], y.at(s).at(i));
+        if (s < pivot.size())
+          m_pivot.push_back(pivot[s].at(i));
+        uint64_t t = s < time.size() && i < time[s].size() ? time[s][i] : 0;
+        has_time |= t != 0;
+        has_waveform |= s < waveform.size() && i < waveform[s].size() &&
+          !waveform[s][i].empty();
+      }
+    }
+    if (has_time) {
+      for (size_t s = 0; s < x.size(); ++s)
+        for (size_t i = 0; i < x[s].size(); ++i)
+          m_time.push_back(i < time.at(s).size() ? time[s][i] : 0);
+    }
+    if (has_waveform) {
+      for (size_t s = 0; s < x.size(); ++s) {
+        for (size_t i = 0; i < x[s].size(); ++i) {
+          bool set = s < waveform.size() && i < waveform[s].size();
+          m_waveform.push_back(set ? waveform[s][i] : std::vector<double>());
+          m_waveform_x0.push_back(set ? x0.at(s).at(i) : 0.);
+          m_waveform_dx.push_back(set ? dx.at(s).at(i) : 0.);
+        }
+      }
+    }
   }
 
   void StandardPlane::Serialize(Serializer &ser) const {
@@ -37,17 +188,29 @@ namespace eudaq{
     ser.write(m_id);
     ser.write(m_xsize);
     ser.write(m_ysize);
-    ser.write(m_flags);
+    ser.write(m_flags | FORMAT_COLUMNS | (m_coord_wide ? FORMAT_WIDE_COORDS : 0));
     ser.write(m_pivotpixel);
-    ser.write(m_pix);
-    ser.write(m_waveform);
-    ser.write(m_waveform_x0);
-    ser.write(m_waveform_dx);
-    ser.write(m_x);
-    ser.write(m_y);
+    ser.write(m_offsets);
+    ser.write(static_cast<uint32_t>(m_pixtype));
+    switch (m_pixtype) {
+    case PIXEL_UINT8: ser.write(m_pix_u8); break;
+    case PIXEL_UINT16: ser.write(m_pix_u16); break;
+    case PIXEL_INT32: ser.write(m_pix_i32); break;
+    case PIXEL_DOUBLE: ser.write(m_pix_f64); break;
+    }
+    if (m_coord_wide) {
+      ser.write(m_xw);
+      ser.write(m_yw);
+    } else {
+      ser.write(m_x);
+      ser.write(m_y);
+    }
     ser.write(m_pivot);
     ser.write(m_mat);
     ser.write(m_time);
+    ser.write(m_waveform);
+    ser.write(m_waveform_x0);
+    ser.write(m_waveform_dx);
   }
 
 
@@ -57,9 +220,9 @@ namespace eudaq{
 
   void StandardPlane::Print(std::ostream &os, size_t offset) const  {
     os << std::string(offset, ' ') << m_id << ", " << m_type << ":" << m_sensor << ", "
-       << m_xsize << "x" << m_ysize << "x" << m_pix.size()
-       << " (" << (m_pix.size() ? m_pix[0].size() : 0) << "), pivot=" << m_pivotpixel
-       << " timestamps:" << m_time[0].size()<< std::endl; }
+       << m_xsize << "x" << m_ysize << "x" << NumFrames()
+       << " (" << (NumFrames() ? HitPixels(0) : 0) << "), pivot=" << m_pivotpixel
+       << " timestamps:" << m_time.size() << std::endl; }
   void StandardPlane::SetSizeRaw(uint32_t w, uint32_t h, uint32_t frames,
 				 int flags) {
 
@@ -71,202 +234,246 @@ namespace eudaq{
   void StandardPlane::SetSizeZS(uint32_t w, uint32_t h, uint32_t npix,
 				uint32_t frames, int flags) {
     m_flags = flags | FLAG_ZS;
-    // std::cout << "DBG flags " << hexdec(m_flags) << std::endl;
     m_xsize = w;
     m_ysize = h;
-    m_pix.resize(frames);
-    m_waveform.resize(frames);
-    m_waveform_x0.resize(frames);
-    m_waveform_dx.resize(frames);
-    m_time.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
-    m_x.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
-    m_y.resize(GetFlags(FLAG_DIFFCOORDS) ? frames : 1);
-    m_pivot.resize(GetFlags(FLAG_WITHPIVOT)
-		   ? (GetFlags(FLAG_DIFFCOORDS) ? frames : 1)
-		   : 0);
-    for (size_t i = 0; i < frames; ++i) {
-      m_pix[i].resize(npix);
-    }
-    for (size_t i = 0; i < m_x.size(); ++i) {
-      m_x[i].resize(npix);
-      m_y[i].resize(npix);
-      m_waveform[i].resize(npix);
-      m_waveform_x0[i].resize(npix);
-      m_waveform_dx[i].resize(npix);
-      m_time[i].resize(npix);
-      if (m_pivot.size()) {
-        m_pivot[i].resize(npix);
-      }
+    m_offsets.resize(frames + 1);
+    for (size_t f = 0; f <= frames; ++f)
+      m_offsets[f] = f * npix;
+    m_pixtype = m_pixtype_min;
+    size_t nvalues = size_t(frames) * npix;
+    m_pix_u8.clear();
+    m_pix_u16.clear();
+    m_pix_i32.clear();
+    m_pix_f64.clear();
+    switch (m_pixtype) {
+    case PIXEL_UINT8: m_pix_u8.assign(nvalues, 0); break;
+    case PIXEL_UINT16: m_pix_u16.assign(nvalues, 0); break;
+    case PIXEL_INT32: m_pix_i32.assign(nvalues, 0); break;
+    case PIXEL_DOUBLE: m_pix_f64.assign(nvalues, 0); break;
     }
+    size_t ncoords = CoordFrames() * npix;
+    m_coord_wide = false;
+    m_x.assign(ncoords, 0);
+    m_y.assign(ncoords, 0);
+    m_xw.clear();
+    m_yw.clear();
+    m_pivot.assign(GetFlags(FLAG_WITHPIVOT) ? ncoords : 0, 0);
+    m_time.clear();
+    m_waveform.clear();
+    m_waveform_x0.clear();
+    m_waveform_dx.clear();
+    m_result = false;
+  }
+
+  void StandardPlane::SetPixelType(PIXELTYPE type) {
+    m_pixtype_min = type;
+    if (type > m_pixtype)
+      ConvertPixels(type);
+    else if (m_offsets.empty() || m_offsets.back() == 0)
+      m_pixtype = type;
+  }
+
+  StandardPlane::PIXELTYPE StandardPlane::GetPixelType() const {
+    return m_pixtype;
   }
 
   void StandardPlane::PushPixelHelper(uint32_t x, uint32_t y, double p, uint64_t time_ps,
 				      bool pivot, uint32_t frame) {
-    if (frame > m_x.size())
+    if (frame >= NumFrames())
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in PushPixel");
-    m_x[frame].push_back(x);
-    m_y[frame].push_back(y);
-    m_pix[frame].push_back(p);
-    m_waveform[frame].push_back(std::vector<double>());
-    m_waveform_x0[frame].push_back(0);
-    m_waveform_dx[frame].push_back(0);
-    m_time[frame].push_back(time_ps);
-    if (m_pivot.size())
-      m_pivot[frame].push_back(pivot);
-    // std::cout << "DBG: " << frame << ", " << x << ", " << y << ", " << p <<
-    // ";" << m_pix[0].size() << ", " << m_pivot.size() << std::endl;
+    uint32_t pos = m_offsets[frame + 1];
+    InsertPixValue(pos, p);
+    for (size_t f = frame + 1; f < m_offsets.size(); ++f)
+      ++m_offsets[f];
+    m_result = false;
+    // without FLAG_DIFFCOORDS the coordinates are those of frame 0
+    if (!GetFlags(FLAG_DIFFCOORDS)) {
+      if (frame != 0)
+        return;
+      pos = NumCoords();
+    }
+    InsertCoord(pos, x, y);
+    if (GetFlags(FLAG_WITHPIVOT))
+      InsertAt(m_pivot, pos, uint8_t(pivot));
+    if (time_ps || !m_time.empty()) {
+      m_time.resize(NumCoords() - 1);
+      InsertAt(m_time, pos, time_ps);
+    }
+    if (!m_waveform.empty()) {
+      InsertAt(m_waveform, pos, std::vector<double>());
+      InsertAt(m_waveform_x0, pos, 0.);
+      InsertAt(m_waveform_dx, pos, 0.);
+    }
   }
 
   void StandardPlane::SetWaveform(uint32_t index, std::vector<double> waveform, double x0, double dx, uint32_t frame) {
-    if (frame > m_x.size()) {
+    if (frame >= NumFrames()) {
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in SetWaveform");
     }
 
-    if(index >= m_waveform.at(frame).size()) {
-      EUDAQ_THROW("Bad pixel index " + to_string(frame) + " in SetWaveform");
+    if(index >= HitPixels(frame)) {
+      EUDAQ_THROW("Bad pixel index " + to_string(index) + " in SetWaveform");
     }
 
-    m_waveform.at(frame).at(index) = std::move(waveform);
-    m_waveform_x0.at(frame).at(index) = x0;
-    m_waveform_dx.at(frame).at(index) = dx;
+    uint32_t c = CoordIndex(index, frame);
+    if (m_waveform.empty()) {
+      m_waveform.resize(NumCoords());
+      m_waveform_x0.resize(NumCoords());
+      m_waveform_dx.resize(NumCoords());
+    }
+    m_waveform[c] = std::move(waveform);
+    m_waveform_x0[c] = x0;
+    m_waveform_dx[c] = dx;
   }
 
   void StandardPlane::SetPixelHelper(uint32_t index, uint32_t x, uint32_t y,
 				     double pix, uint64_t time_ps, bool pivot, uint32_t frame) {
-    if (frame >= m_pix.size())
+    if (frame >= NumFrames())
       EUDAQ_THROW("Bad frame number " + to_string(frame) + " in SetPixel");
-    if (frame < m_x.size()) {
-      m_x.at(frame).at(index) = x;
-    }
-    if (frame < m_y.size()) {
-      m_y.at(frame).at(index) = y;
-    }
-    if (frame < m_pivot.size()) {
-      m_pivot.at(frame).at(index) = pivot;
-    }
-    if (frame < m_pix.size()) {
-      m_pix.at(frame).at(index) = pix;
-    }
-    if (frame < m_waveform.size()) {
-      m_waveform.at(frame).at(index) = std::vector<double>();
-    }
-    if (frame < m_waveform_x0.size()) {
-      m_waveform_x0.at(frame).at(index) = 0.;
-    }
-    if (frame < m_waveform_dx.size()) {
-      m_waveform_dx.at(frame).at(index) = 0.;
-    }
-    if (frame < m_time.size()) {
-      m_time.at(frame).at(index) = time_ps;
+    SetPixValue(PixIndex(index, frame), pix);
+    m_result = false;
+    if (!GetFlags(FLAG_DIFFCOORDS) && frame != 0)
+      return;
+    uint32_t c = CoordIndex(index, frame);
+    SetCoord(c, x, y);
+    if (c < m_pivot.size())
+      m_pivot[c] = pivot;
+    if (time_ps && m_time.empty())
+      m_time.resize(NumCoords());
+    if (!m_time.empty())
+      m_time[c] = time_ps;
+    if (!m_waveform.empty()) {
+      m_waveform[c] = std::vector<double>();
+      m_waveform_x0[c] = 0.;
+      m_waveform_dx[c] = 0.;
     }
   }
 
-  void StandardPlane::SetFlags(StandardPlane::FLAGS flags) { m_flags |= flags; }
+  void StandardPlane::SetFlags(StandardPlane::FLAGS flags) {
+    m_flags |= flags;
+    if (GetFlags(FLAG_WITHPIVOT))
+      m_pivot.resize(NumCoords());
+  }
 
   bool StandardPlane::HasWaveform(uint32_t index, uint32_t frame) const {
-    return !m_waveform.at(frame).at(index).empty();
+    uint32_t c = CoordIndex(index, frame);
+    return !m_waveform.empty() && !m_waveform[c].empty();
   }
 
   std::vector<double> StandardPlane::GetWaveform(uint32_t index, uint32_t frame) const {
-    return m_waveform.at(frame).at(index);
+    uint32_t c = CoordIndex(index, frame);
+    return m_waveform.empty() ? std::vector<double>() : m_waveform[c];
   }
   double StandardPlane::GetWaveformX0(uint32_t index, uint32_t frame) const {
-    return m_waveform_x0.at(frame).at(index);
+    uint32_t c = CoordIndex(index, frame);
+    return m_waveform_x0.empty() ? 0. : m_waveform_x0[c];
   }
   double StandardPlane::GetWaveformDX(uint32_t index, uint32_t frame) const {
-    return m_waveform_dx.at(frame).at(index);
+    uint32_t c = CoordIndex(index, frame);
+    return m_waveform_dx.empty() ? 0. : m_waveform_dx[c];
   }
 
   bool StandardPlane::HasWaveform(uint32_t index) const {
-    SetupResult();
-    return !m_result_waveform->at(index).empty();
+    uint32_t c = ResultCoordIndex(index);
+    return !m_waveform.empty() && !m_waveform[c].empty();
   }
 
   std::vector<double> StandardPlane::GetWaveform(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform->at(index);
+    uint32_t c = ResultCoordIndex(index);
+    return m_waveform.empty() ? std::vector<double>() : m_waveform[c];
   }
   double StandardPlane::GetWaveformX0(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform_x0->at(index);
+    uint32_t c = ResultCoordIndex(index);
+    return m_waveform_x0.empty() ? 0. : m_waveform_x0[c];
   }
   double StandardPlane::GetWaveformDX(uint32_t index) const {
-    SetupResult();
-    return m_result_waveform_dx->at(index);
+    uint32_t c = ResultCoordIndex(index);
+    return m_waveform_dx.empty() ? 0. : m_waveform_dx[c];
   }
 
   double StandardPlane::GetPixel(uint32_t index, uint32_t frame) const {
-    return m_pix.at(frame).at(index);
+    return PixValue(PixIndex(index, frame));
   }
   double StandardPlane::GetPixel(uint32_t index) const {
     SetupResult();
-    return m_result_pix->at(index);
+    if (m_result_direct)
+      return PixValue(PixIndex(index, 0));
+    if (!m_result_value.empty())
+      return m_result_value.at(index);
+    return PixValue(m_result_pix.at(index));
   }
   uint64_t StandardPlane::GetTimestamp(uint32_t index, uint32_t frame) const {
-      if (!GetFlags(FLAG_DIFFCOORDS))
-        frame = 0;
-      return m_time.at(frame).at(index);
+    uint32_t c = CoordIndex(index, frame);
+    return m_time.empty() ? 0 : m_time[c];
   }
   uint64_t StandardPlane::GetTimestamp(uint32_t index) const {
-    SetupResult();
-    return m_result_time->at(index);
+    uint32_t c = ResultCoordIndex(index);
+    return m_time.empty() ? 0 : m_time[c];
   }
   double StandardPlane::GetX(uint32_t index, uint32_t frame) const {
-    if (!GetFlags(FLAG_DIFFCOORDS))
-      frame = 0;
-    return m_x.at(frame).at(index);
+    return CoordX(CoordIndex(index, frame));
   }
   double StandardPlane::GetX(uint32_t index) const {
-    SetupResult();
-    return m_result_x->at(index);
+    return CoordX(ResultCoordIndex(index));
   }
   double StandardPlane::GetY(uint32_t index, uint32_t frame) const {
-    if (!GetFlags(FLAG_DIFFCOORDS))
-      frame = 0;
-    return m_y.at(frame).at(index);
+    return CoordY(CoordIndex(index, frame));
   }
   double StandardPlane::GetY(uint32_t index) const {
-    SetupResult();
-    return m_result_y->at(index);
+    return CoordY(ResultCoordIndex(index));
   }
   bool StandardPlane::GetPivot(uint32_t index, uint32_t frame) const {
-    if (!GetFlags(FLAG_DIFFCOORDS))
-      frame = 0;
-    return m_pivot.at(frame).at(index);
+    return m_pivot.at(CoordIndex(index, frame)) != 0;
   }
 
   void StandardPlane::SetPivot(uint32_t index, uint32_t frame, bool PivotFlag) {
-    m_pivot.at(frame).at(index) = PivotFlag;
+    m_pivot.at(CoordIndex(index, frame)) = PivotFlag;
+    m_result = false;
   }
 
-  const std::vector<StandardPlane::coord_t> &
+  std::vector<StandardPlane::coord_t>
   StandardPlane::XVector(uint32_t frame) const {
-    return GetFrame(m_x, frame);
+    std::vector<coord_t> v(HitPixels(frame));
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetX(i, frame);
+    return v;
   }
 
-  const std::vector<StandardPlane::coord_t> &StandardPlane::XVector() const {
-    SetupResult();
-    return *m_result_x;
+  std::vector<StandardPlane::coord_t> StandardPlane::XVector() const {
+    std::vector<coord_t> v(HitPixels());
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetX(i);
+    return v;
   }
 
-  const std::vector<StandardPlane::coord_t> &
+  std::vector<StandardPlane::coord_t>
   StandardPlane::YVector(uint32_t frame) const {
-    return GetFrame(m_y, frame);
+    std::vector<coord_t> v(HitPixels(frame));
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetY(i, frame);
+    return v;
   }
 
-  const std::vector<StandardPlane::coord_t> &StandardPlane::YVector() const {
-    SetupResult();
-    return *m_result_y;
+  std::vector<StandardPlane::coord_t> StandardPlane::YVector() const {
+    std::vector<coord_t> v(HitPixels());
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetY(i);
+    return v;
   }
 
-  const std::vector<StandardPlane::pixel_t> &
+  std::vector<StandardPlane::pixel_t>
   StandardPlane::PixVector(uint32_t frame) const {
-    return GetFrame(m_pix, frame);
+    std::vector<pixel_t> v(HitPixels(frame));
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetPixel(i, frame);
+    return v;
   }
 
-  const std::vector<StandardPlane::pixel_t> &StandardPlane::PixVector() const {
-    SetupResult();
-    return *m_result_pix;
+  std::vector<StandardPlane::pixel_t> StandardPlane::PixVector() const {
+    std::vector<pixel_t> v(HitPixels());
+    for (uint32_t i = 0; i < v.size(); ++i)
+      v[i] = GetPixel(i);
+    return v;
   }
 
   void StandardPlane::SetXSize(uint32_t x) { m_xsize = x; }
@@ -285,17 +492,21 @@ namespace eudaq{
 
   uint32_t StandardPlane::YSize() const { return m_ysize; }
 
-  uint32_t StandardPlane::NumFrames() const { return m_pix.size(); }
+  uint32_t StandardPlane::NumFrames() const {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
 
   uint32_t StandardPlane::TotalPixels() const { return m_xsize * m_ysize; }
 
   uint32_t StandardPlane::HitPixels(uint32_t frame) const {
-    return GetFrame(m_pix, frame).size();
+    if (frame >= NumFrames())
+      throw std::out_of_range("StandardPlane: bad frame number " + to_string(frame));
+    return m_offsets[frame + 1] - m_offsets[frame];
   }
 
   uint32_t StandardPlane::HitPixels() const {
     SetupResult();
-    return m_result_pix->size();
+    return m_result_direct ? HitPixels(0) : m_result_coord.size();
   }
 
   uint32_t StandardPlane::PivotPixel() const { return m_pivotpixel; }
@@ -308,122 +519,195 @@ namespace eudaq{
     return GetFlags(FLAG_NEGATIVE) ? -1 : 1;
   }
 
-  const std::vector<StandardPlane::pixel_t> &
-  StandardPlane::GetFrame(const std::vector<std::vector<pixel_t>> &v,
-			  uint32_t f) const {
-    return v.at(f);
+  uint32_t StandardPlane::CoordFrames() const {
+    return GetFlags(FLAG_DIFFCOORDS) ? NumFrames() : 1;
+  }
+
+  uint32_t StandardPlane::PixIndex(uint32_t index, uint32_t frame) const {
+    if (index >= HitPixels(frame))
+      throw std::out_of_range("StandardPlane: bad pixel index " + to_string(index));
+    return m_offsets[frame] + index;
+  }
+
+  uint32_t StandardPlane::CoordIndex(uint32_t index, uint32_t frame) const {
+    if (GetFlags(FLAG_DIFFCOORDS))
+      return PixIndex(index, frame);
+    if (index >= NumCoords())
+      throw std::out_of_range("StandardPlane: bad pixel index " + to_string(index));
+    return index;
+  }
+
+  uint32_t StandardPlane::ResultCoordIndex(uint32_t index) const {
+    SetupResult();
+    return m_result_direct ? CoordIndex(index, 0) : m_result_coord.at(index);
+  }
+
+  size_t StandardPlane::NumCoords() const {
+    return m_coord_wide ? m_xw.size() : m_x.size();
+  }
+
+  double StandardPlane::CoordX(size_t c) const {
+    return m_coord_wide ? m_xw[c] : m_x[c];
+  }
+
+  double StandardPlane::CoordY(size_t c) const {
+    return m_coord_wide ? m_yw[c] : m_y[c];
+  }
+
+  void StandardPlane::SetCoord(size_t c, double x, double y) {
+    if (!m_coord_wide && !(IsCoord(x) && IsCoord(y)))
+      WidenCoords();
+    if (m_coord_wide) {
+      m_xw[c] = x;
+      m_yw[c] = y;
+    } else {
+      m_x[c] = static_cast<uint16_t>(x);
+      m_y[c] = static_cast<uint16_t>(y);
+    }
+  }
+
+  void StandardPlane::InsertCoord(size_t c, double x, double y) {
+    if (!m_coord_wide && !(IsCoord(x) && IsCoord(y)))
+      WidenCoords();
+    if (m_coord_wide) {
+      InsertAt(m_xw, c, x);
+      InsertAt(m_yw, c, y);
+    } else {
+      InsertAt(m_x, c, static_cast<uint16_t>(x));
+      InsertAt(m_y, c, static_cast<uint16_t>(y));
+    }
+  }
+
+  void StandardPlane::WidenCoords() {
+    m_xw.assign(m_x.begin(), m_x.end());
+    m_yw.assign(m_y.begin(), m_y.end());
+    std::vector<uint16_t>().swap(m_x);
+    std::vector<uint16_t>().swap(m_y);
+    m_coord_wide = true;
+  }
+
+  double StandardPlane::PixValue(size_t i) const {
+    switch (m_pixtype) {
+    case PIXEL_UINT8: return m_pix_u8[i];
+    case PIXEL_UINT16: return m_pix_u16[i];
+    case PIXEL_INT32: return m_pix_i32[i];
+    default: return m_pix_f64[i];
+    }
+  }
+
+  void StandardPlane::SetPixValue(size_t i, double pix) {
+    WidenPixels(pix);
+    switch (m_pixtype) {
+    case PIXEL_UINT8: m_pix_u8[i] = static_cast<uint8_t>(pix); break;
+    case PIXEL_UINT16: m_pix_u16[i] = static_cast<uint16_t>(pix); break;
+    case PIXEL_INT32: m_pix_i32[i] = static_cast<int32_t>(pix); break;
+    case PIXEL_DOUBLE: m_pix_f64[i] = pix; break;
+    }
+  }
+
+  void StandardPlane::InsertPixValue(size_t i, double pix) {
+    WidenPixels(pix);
+    switch (m_pixtype) {
+    case PIXEL_UINT8: InsertAt(m_pix_u8, i, static_cast<uint8_t>(pix)); break;
+    case PIXEL_UINT16: InsertAt(m_pix_u16, i, static_cast<uint16_t>(pix)); break;
+    case PIXEL_INT32: InsertAt(m_pix_i32, i, static_cast<int32_t>(pix)); break;
+    case PIXEL_DOUBLE: InsertAt(m_pix_f64, i, pix); break;
+    }
+  }
+
+  void StandardPlane::WidenPixels(double pix) {
+    if (m_pixtype == PIXEL_DOUBLE)
+      return;
+    PIXELTYPE type = PixelTypeOf(pix);
+    if (type > m_pixtype)
+      ConvertPixels(type);
+  }
+
+  void StandardPlane::ConvertPixels(PIXELTYPE type) {
+    size_t n = 0;
+    switch (m_pixtype) {
+    case PIXEL_UINT8: n = m_pix_u8.size(); break;
+    case PIXEL_UINT16: n = m_pix_u16.size(); break;
+    case PIXEL_INT32: n = m_pix_i32.size(); break;
+    case PIXEL_DOUBLE: n = m_pix_f64.size(); break;
+    }
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; ++i)
+      values[i] = PixValue(i);
+    std::vector<uint8_t>().swap(m_pix_u8);
+    std::vector<uint16_t>().swap(m_pix_u16);
+    std::vector<int32_t>().swap(m_pix_i32);
+    std::vector<double>().swap(m_pix_f64);
+    m_pixtype = type;
+    switch (m_pixtype) {
+    case PIXEL_UINT8: FillColumn(m_pix_u8, values); break;
+    case PIXEL_UINT16: FillColumn(m_pix_u16, values); break;
+    case PIXEL_INT32: FillColumn(m_pix_i32, values); break;
+    case PIXEL_DOUBLE: FillColumn(m_pix_f64, values); break;
+    }
   }
 
   void StandardPlane::SetupResult() const {
-    if (m_result_pix)
+    if (m_result)
       return;
-    m_result_x = &m_x[0];
-    m_result_y = &m_y[0];
-    m_result_time = &m_time[0];
-    m_result_waveform = &m_waveform[0];
-    m_result_waveform_x0 = &m_waveform_x0[0];
-    m_result_waveform_dx = &m_waveform_dx[0];
+    m_result_direct = false;
+    m_result_pix.clear();
+    m_result_coord.clear();
+    m_result_value.clear();
+    uint32_t frames = NumFrames();
 
     if (GetFlags(FLAG_ACCUMULATE)) {
-      m_temp_pix.resize(0);
-      m_temp_x.resize(0);
-      m_temp_y.resize(0);
-      m_temp_time.resize(0);
-      m_temp_waveform.resize(0);
-      m_temp_waveform_x0.resize(0);
-      m_temp_waveform_dx.resize(0);
-      for (size_t f = 0; f < m_pix.size(); ++f) {
-        for (size_t p = 0; p < m_pix[f].size(); ++p) {
-          m_temp_x.push_back(GetX(p, f));
-          m_temp_y.push_back(GetY(p, f));
-          m_temp_pix.push_back(GetPixel(p, f));
-          m_temp_time.push_back(GetTimestamp(p,f));
-          m_temp_waveform.push_back(GetWaveform(p, f));
-          m_temp_waveform_x0.push_back(GetWaveformX0(p, f));
-          m_temp_waveform_dx.push_back(GetWaveformDX(p,f));
+      for (uint32_t f = 0; f < frames; ++f) {
+        for (uint32_t p = 0; p < HitPixels(f); ++p) {
+          m_result_pix.push_back(PixIndex(p, f));
+          m_result_coord.push_back(CoordIndex(p, f));
         }
       }
-      m_result_x = &m_temp_x;
-      m_result_y = &m_temp_y;
-      m_result_pix = &m_temp_pix;
-      m_result_time = & m_temp_time;
-      m_result_waveform = &m_temp_waveform;
-      m_result_waveform_x0 = &m_temp_waveform_x0;
-      m_result_waveform_dx = &m_temp_waveform_dx;
-    } else if (m_pix.size() == 1 && !GetFlags(FLAG_NEEDCDS)) {
-      m_result_pix = &m_pix[0];
-    } else if (m_pix.size() == 2) {
+    } else if (frames == 1 && !GetFlags(FLAG_NEEDCDS)) {
+      m_result_direct = true;
+    } else if (frames == 2) {
       if (GetFlags(FLAG_NEEDCDS)) {
-        m_temp_pix.resize(m_pix[0].size());
-        for (size_t i = 0; i < m_temp_pix.size(); ++i) {
-          m_temp_pix[i] = m_pix[1][i] - m_pix[0][i];
+        for (uint32_t i = 0; i < HitPixels(0); ++i) {
+          m_result_value.push_back(GetPixel(i, 1) - GetPixel(i, 0));
+          m_result_coord.push_back(CoordIndex(i, 0));
+        }
+      } else if (!GetFlags(FLAG_DIFFCOORDS)) {
+        for (uint32_t i = 0; i < HitPixels(0); ++i) {
+          m_result_pix.push_back(PixIndex(i, 1 - m_pivot.at(i)));
+          m_result_coord.push_back(i);
         }
-        m_result_pix = &m_temp_pix;
       } else {
-        if (m_x.size() == 1) {
-          m_temp_pix.resize(m_pix[0].size());
-          for (size_t i = 0; i < m_temp_pix.size(); ++i) {
-            m_temp_pix[i] = m_pix[1 - m_pivot[0][i]][i];
-          }
-          m_temp_waveform = m_waveform[0];
-          m_temp_waveform_x0 = m_waveform_x0[0];
-          m_temp_waveform_dx = m_waveform_dx[0];
-        } else {
-          m_temp_x.resize(0);
-          m_temp_y.resize(0);
-          m_temp_pix.resize(0);
-          m_temp_time.resize(0);
-          m_temp_waveform.resize(0);
-          m_temp_waveform_x0.resize(0);
-          m_temp_waveform_dx.resize(0);
-          const bool inverse = false;
-          size_t i;
-          for (i = 0; i < m_pix[1 - inverse].size(); ++i) {
-            if (m_pivot[1][i])
+        const uint32_t inverse = 0;
+        uint32_t i;
+        for (i = 0; i < HitPixels(1 - inverse); ++i) {
+          if (GetPivot(i, 1))
             break;
-            m_temp_x.push_back(m_x[1 - inverse][i]);
-            m_temp_y.push_back(m_y[1 - inverse][i]);
-            m_temp_pix.push_back(m_pix[1 - inverse][i]);
-            m_temp_time.push_back(m_time[1-inverse][i]);
-            m_temp_waveform.push_back(GetWaveform(i, 1-inverse));
-            m_temp_waveform_x0.push_back(GetWaveformX0(i, 1-inverse));
-            m_temp_waveform_dx.push_back(GetWaveformDX(i, 1-inverse));
-          }
-          for (i = 0; i < m_pix[0 + inverse].size(); ++i) {
-            if (m_pivot[0 + inverse][i])
+          m_result_pix.push_back(PixIndex(i, 1 - inverse));
+          m_result_coord.push_back(CoordIndex(i, 1 - inverse));
+        }
+        for (i = 0; i < HitPixels(0 + inverse); ++i) {
+          if (GetPivot(i, 0 + inverse))
             break;
-          }
-          for (/**/; i < m_pix[0 + inverse].size(); ++i) {
-            m_temp_x.push_back(m_x[0 + inverse][i]);
-            m_temp_y.push_back(m_y[0 + inverse][i]);
-            m_temp_pix.push_back(m_pix[0 + inverse][i]);
-            m_temp_time.push_back(m_time[0 + inverse][i]);
-            m_temp_waveform.push_back(GetWaveform(i, 0 + inverse));
-            m_temp_waveform_x0.push_back(GetWaveformX0(i, 0 + inverse));
-            m_temp_waveform_dx.push_back(GetWaveformDX(i, 0 + inverse));
-          }
-          m_result_x = &m_temp_x;
-          m_result_y = &m_temp_y;
-          m_result_time = &m_temp_time;
         }
-        m_result_pix = &m_temp_pix;
-        m_result_waveform = &m_temp_waveform;
-        m_result_waveform_x0 = &m_temp_waveform_x0;
-        m_result_waveform_dx = &m_temp_waveform_dx;
+        for (/**/; i < HitPixels(0 + inverse); ++i) {
+          m_result_pix.push_back(PixIndex(i, 0 + inverse));
+          m_result_coord.push_back(CoordIndex(i, 0 + inverse));
+        }
       }
-    } else if (m_pix.size() == 3 && GetFlags(FLAG_NEEDCDS)) {
-      m_temp_pix.resize(m_pix[0].size());
-      for (size_t i = 0; i < m_temp_pix.size(); ++i) {
-        m_temp_pix[i] = m_pix[0][i] * (m_pivot[0][i] - 1) +
-        m_pix[1][i] * (2 * m_pivot[0][i] - 1) +
-        m_pix[2][i] * (m_pivot[0][i]);
+    } else if (frames == 3 && GetFlags(FLAG_NEEDCDS)) {
+      for (uint32_t i = 0; i < HitPixels(0); ++i) {
+        int pivot = m_pivot.at(i);
+        m_result_value.push_back(GetPixel(i, 0) * (pivot - 1) +
+                                 GetPixel(i, 1) * (2 * pivot - 1) +
+                                 GetPixel(i, 2) * pivot);
+        m_result_coord.push_back(i);
       }
-      m_result_pix = &m_temp_pix;
     } else {
-      EUDAQ_THROW("Unrecognised pixel format (" + to_string(m_pix.size()) +
+      EUDAQ_THROW("Unrecognised pixel format (" + to_string(frames) +
       " frames, CDS=" +
       (GetFlags(FLAG_NEEDCDS) ? "Needed" : "Done") + ")");
     }
+    m_result = true;
   }
 
   template std::vector<short> StandardPlane::GetPixels<>() const;
@@ -0,0 +1,219 @@
+#include "eudaq/StdEventBatchConverter.hh"
+
+#include <algorithm>
+
+namespace eudaq {
+
+  StdEventBatchConverter::StdEventBatchConverter(ConfigurationSPC conf, uint32_t n_workers)
+    :m_conf(conf), m_n_workers(n_workers), m_in(nullptr), m_out(nullptr),
+     m_next_free(0), m_generation(0), m_busy(0), m_exit(false){
+    if(!m_n_workers)
+      m_n_workers = std::max(1u, std::thread::hardware_concurrency());
+    m_pinned.resize(m_n_workers);
+    for(uint32_t i = 0; i < m_n_workers; i++)
+      m_ctxs.emplace_back(new StdEventConversionContext(conf));
+    // a single worker converts on the calling thread
+    if(m_n_workers > 1)
+      for(uint32_t i = 0; i < m_n_workers; i++)
+	m_thds.emplace_back(&StdEventBatchConverter::Work, this, i);
+  }
+
+  StdEventBatchConverter::~StdEventBatchConverter(){
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_exit = true;
+    lk.unlock();
+    m_cv_work.notify_all();
+    for(auto &thd: m_thds)
+      thd.join();
+  }
+
+  void StdEventBatchConverter::SetConfiguration(ConfigurationSPC conf){
+    m_conf = conf;
+    for(auto &ctx: m_ctxs)
+      ctx->SetConfiguration(conf);
+  }
+
+  int StdEventBatchConverter::Stateless(uint32_t id){
+    auto it = m_stateless.find(id);
+    if(it != m_stateless.end())
+      return it->second;
+    // the converter is only asked for its kind, the workers create their own
+    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    return m_stateless[id] = cvt ? int(cvt->IsStateless()) : -1;
+  }
+
+  bool StdEventBatchConverter::IsStateless(const Event &ev){
+    if(ev.IsFlagFake())
+      return true;
+    if(ev.IsFlagPacket()){
+      for(auto &subev: ev.GetSubEvents())
+	if(!IsStateless(*subev))
+	  return false;
+      return true;
+    }
+    // same converter lookup as StdEventConversionContext::Convert
+    uint32_t id = ev.GetType();
+    if(id == cstr2hash("RawEvent")){
+      int kind = Stateless(ev.GetExtendWord());
+      if(kind >= 0)
+	return kind;
+    }
+    // an event without converter fails on any worker
+    return Stateless(id) != 0;
+  }
+
+  void StdEventBatchConverter::AddUnits(size_t i, EventSPC ev){
+    if(ev == (*m_in)[i] && ev->IsFlagPacket() && !ev->IsFlagFake()){
+      // the sub-events may belong to streams pinned to different workers
+      for(auto &subev: ev->GetSubEvents())
+	AddUnits(i, subev);
+      return;
+    }
+    size_t u = m_units.size();
+    m_units.push_back(Unit{i, ev, StandardEvent::MakeShared()});
+    if(ev != (*m_in)[i])
+      // as in StdEventConversionContext::Convert, a sub-event is converted
+      // into an event carrying the header of its packet
+      StdEventConverter::CopyHeader(*(*m_in)[i], *m_units[u].out);
+    if(IsStateless(*ev))
+      m_free.push_back(u);
+    else
+      m_pinned[ev->GetStreamN() % m_n_workers].push_back(u);
+  }
+
+  void StdEventBatchConverter::Merge(size_t i, size_t u0, size_t u1){
+    auto &out = (*m_out)[i];
+    bool ok = true;
+    for(size_t u = u0; u < u1; u++){
+      ok = ok && m_ok[u];
+      if(m_err[u] && !m_err_ev[i])
+	m_err_ev[i] = m_err[u];
+    }
+    m_ok_ev[i] = ok;
+    if(u1 - u0 == 1 && m_units[u0].ev == (*m_in)[i]){
+      out = m_units[u0].out;
+      return;
+    }
+    out = StandardEvent::MakeShared();
+    StdEventConverter::CopyHeader(*(*m_in)[i], *out);
+    // what each sub-event changed with respect to the packet header
+    const StandardEvent &head = *out;
+    uint32_t flags = head.GetFlag();
+    uint32_t tg_n = head.GetTriggerN();
+    uint64_t ts_b = head.GetTimestampBegin(), ts_e = head.GetTimestampEnd();
+    std::string dspt = head.GetDescription();
+    for(size_t u = u0; u < u1; u++){
+      StandardEvent &sub = *m_units[u].out;
+      for(size_t p = 0; p < sub.NumPlanes(); p++)
+	out->AddPlane(sub.GetPlane(p));
+      for(auto &tag: sub.GetTags())
+	out->SetTag(tag.first, tag.second);
+      out->SetFlagBit(sub.GetFlag() & ~flags);
+      if(sub.GetTriggerN() != tg_n)
+	out->SetTriggerN(sub.GetTriggerN(), sub.IsFlagTrigger());
+      if(sub.GetTimestampBegin() != ts_b || sub.GetTimestampEnd() != ts_e)
+	out->SetTimestamp(sub.GetTimestampBegin(), sub.GetTimestampEnd(), sub.IsFlagTimestamp());
+      if(sub.GetDescription() != dspt)
+	out->SetDescription(sub.GetDescription());
+      if(sub.GetTimeBegin())
+	out->SetTimeBegin(sub.GetTimeBegin());
+      if(sub.GetTimeEnd())
+	out->SetTimeEnd(sub.GetTimeEnd());
+      if(!sub.GetDetectorType().empty())
+	out->SetDetectorType(sub.GetDetectorType());
+    }
+    if(ok)
+      out->ClearFlagBit(Event::Flags::FLAG_PACK);
+  }
+
+  void StdEventBatchConverter::Convert(uint32_t worker, size_t u){
+    auto &unit = m_units[u];
+    try{
+      m_ok[u] = m_ctxs[worker]->Convert(unit.ev, unit.out);
+    }
+    catch(...){
+      m_err[u] = std::current_exception();
+    }
+  }
+
+  void StdEventBatchConverter::Work(uint32_t worker){
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while(true){
+      m_cv_work.wait(lk, [&]{return m_exit || m_generation != generation;});
+      if(m_exit)
+	break;
+      generation = m_generation;
+      lk.unlock();
+      // the events of the pinned streams first, in order, then help with the rest
+      for(auto i: m_pinned[worker])
+	Convert(worker, i);
+      size_t k;
+      while((k = m_next_free++) < m_free.size())
+	Convert(worker, m_free[k]);
+      lk.lock();
+      if(--m_busy == 0)
+	m_cv_done.notify_all();
+    }
+  }
+
+  std::vector<bool> StdEventBatchConverter::ConvertBatch(const std::vector<EventSPC> &in,
+							 std::vector<StdEventSP> &out,
+							 std::vector<std::exception_ptr> *errors){
+    size_t n = in.size();
+    out.assign(n, nullptr);
+    m_in = &in;
+    m_out = &out;
+    for(auto &p: m_pinned)
+      p.clear();
+    m_free.clear();
+    m_units.clear();
+    std::vector<size_t> first(n + 1);
+    for(size_t i = 0; i < n; i++){
+      first[i] = m_units.size();
+      AddUnits(i, in[i]);
+    }
+    first[n] = m_units.size();
+    m_ok.assign(m_units.size(), 0);
+    m_err.assign(m_units.size(), nullptr);
+    m_next_free = 0;
+
+    if(m_thds.empty()){
+      for(size_t u = 0; u < m_units.size(); u++)
+	Convert(0, u);
+    }
+    else{
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_busy = m_n_workers;
+      m_generation++;
+      m_cv_work.notify_all();
+      m_cv_done.wait(lk, [this]{return m_busy == 0;});
+    }
+
+    m_ok_ev.assign(n, 0);
+    m_err_ev.assign(n, nullptr);
+    for(size_t i = 0; i < n; i++){
+      if(first[i] == first[i + 1]){
+	// a packet without sub-events
+	out[i] = StandardEvent::MakeShared();
+	StdEventConverter::CopyHeader(*in[i], *out[i]);
+	out[i]->ClearFlagBit(Event::Flags::FLAG_PACK);
+	m_ok_ev[i] = 1;
+      }
+      else
+	Merge(i, first[i], first[i + 1]);
+    }
+    m_units.clear();
+    m_in = nullptr;
+    m_out = nullptr;
+
+    if(errors)
+      *errors = m_err_ev;
+    else
+      for(auto &err: m_err_ev)
+	if(err)
+	  std::rethrow_exception(err);
+    return std::vector<bool>(m_ok_ev.begin(), m_ok_ev.end());
+  }
+
+}
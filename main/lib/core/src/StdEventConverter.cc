@@ -5,46 +5,114 @@ namespace eudaq{
   template DLLEXPORT
   std::map<uint32_t, typename Factory<StdEventConverter>::UP(*)()>&
   Factory<StdEventConverter>::Instance<>();
-  
+
+  void StdEventConverter::CopyHeader(const Event &d1, StandardEvent &d2){
+    d2.SetVersion(d1.GetVersion());
+    d2.SetFlag(d1.GetFlag());
+    d2.SetRunN(d1.GetRunN());
+    d2.SetEventN(d1.GetEventN());
+    d2.SetDeviceN(d1.GetDeviceN());
+    d2.SetTriggerN(d1.GetTriggerN(), d1.IsFlagTrigger());
+    d2.SetTimestamp(d1.GetTimestampBegin(), d1.GetTimestampEnd(), d1.IsFlagTimestamp());
+    d2.SetDescription(d1.GetDescription());
+  }
+
+  bool StdEventConverter::ConvertingWithState(EventSPC d1, StdEventSP d2, ConfigurationSPC conf,
+					      StdEventConversionContext &/*ctx*/) const{
+    return Converting(d1, d2, conf);
+  }
+
   bool StdEventConverter::Convert(EventSPC d1, StdEventSP d2, ConfigurationSPC conf){
+    auto &ctx = StdEventConversionContext::ThreadDefault();
+    if(ctx.GetConfiguration() == conf)
+      return ctx.Convert(d1, d2);
+    if(!ctx.m_depth){
+      ctx.SetConfiguration(conf);
+      return ctx.Convert(d1, d2);
+    }
+    // a converter of this context is running and converts its sub-events
+    // with another configuration, its cached converters must stay alive
+    StdEventConversionContext tmp(conf);
+    std::swap(tmp.m_states, ctx.m_states);
+    bool ok = tmp.Convert(d1, d2);
+    std::swap(tmp.m_states, ctx.m_states);
+    return ok;
+  }
+
+  StdEventConversionContext::StdEventConversionContext(ConfigurationSPC conf)
+    :m_conf(conf), m_depth(0){
+  }
+
+  StdEventConversionContext &StdEventConversionContext::ThreadDefault(){
+    thread_local StdEventConversionContext ctx;
+    return ctx;
+  }
+
+  void StdEventConversionContext::ResetStates(uint32_t stream_n){
+    for(auto it = m_states.begin(); it != m_states.end();){
+      if(it->first.first == stream_n)
+	it = m_states.erase(it);
+      else
+	++it;
+    }
+  }
+
+  void StdEventConversionContext::ResetStates(){
+    m_states.clear();
+  }
 
+  void StdEventConversionContext::SetConfiguration(ConfigurationSPC conf){
+    m_conf = conf;
+    m_cvts.clear();
+  }
+
+  const StdEventConverter *StdEventConversionContext::GetConverter(uint32_t id){
+    auto it = m_cvts.find(id);
+    if(it != m_cvts.end())
+      return it->second.get();
+    // a missing converter is cached as well, the factory is asked only once
+    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    if(cvt)
+      cvt->Initialize(m_conf);
+    return (m_cvts[id] = std::move(cvt)).get();
+  }
+
+  bool StdEventConversionContext::Convert(EventSPC d1, StdEventSP d2){
     if(d1->IsFlagFake()){
       return true;
     }
-    
+
     if(d1->IsFlagPacket()){
-      d2->SetVersion(d1->GetVersion());
-      d2->SetFlag(d1->GetFlag());
-      d2->SetRunN(d1->GetRunN());
-      d2->SetEventN(d1->GetEventN());
-      d2->SetDeviceN(d1->GetDeviceN());
-      d2->SetTriggerN(d1->GetTriggerN(), d1->IsFlagTrigger());
-      d2->SetTimestamp(d1->GetTimestampBegin(), d1->GetTimestampEnd(), d1->IsFlagTimestamp());
-      d2->SetDescription(d1->GetDescription());
+      StdEventConverter::CopyHeader(*d1, *d2);
       size_t nsub = d1->GetNumSubEvent();
       for(size_t i=0; i<nsub; i++){
-	auto subev = d1->GetSubEvent(i);
-	if(!d1->IsFlagFake())
-	  if(!StdEventConverter::Convert(subev, d2, conf))
-	    return false;
+	if(!Convert(d1->GetSubEvent(i), d2))
+	  return false;
       }
       d2->ClearFlagBit(Event::Flags::FLAG_PACK);
-      return  true;
-    }
-    if(!d2->IsFlagPacket()){
-      d2->SetVersion(d1->GetVersion());
-      d2->SetFlag(d1->GetFlag());
-      d2->SetRunN(d1->GetRunN());
-      d2->SetEventN(d1->GetEventN());
-      d2->SetDeviceN(d1->GetDeviceN());
-      d2->SetTriggerN(d1->GetTriggerN(), d1->IsFlagTrigger());
-      d2->SetTimestamp(d1->GetTimestampBegin(), d1->GetTimestampEnd(), d1->IsFlagTimestamp());
-      d2->SetDescription(d1->GetDescription());
+      return true;
     }
+    if(!d2->IsFlagPacket())
+      StdEventConverter::CopyHeader(*d1, *d2);
+    if(d1->IsBORE())
+      ResetStates(d1->GetStreamN());
+    // keeps the converters alive while a converter calls back into this context
+    struct Depth{
+      uint32_t &d;
+      Depth(uint32_t &d_):d(d_){d++;}
+      ~Depth(){d--;}
+    } depth(m_depth);
     uint32_t id = d1->GetType();
-    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    if(id == cstr2hash("RawEvent")){
+      // skip the RawEvent dispatcher, which would create the converter of
+      // the extend word for every event
+      auto cvt = GetConverter(d1->GetExtendWord());
+      if(cvt)
+	return cvt->ConvertingWithState(d1, d2, m_conf, *this);
+    }
+    auto cvt = GetConverter(id);
     if(cvt){
-      return cvt->Converting(d1, d2, conf);
+      return cvt->ConvertingWithState(d1, d2, m_conf, *this);
     }
     else{
       std::cerr<<"StdEventConverter: WARNING, no converter for EventID = "<<d1<<"\n";
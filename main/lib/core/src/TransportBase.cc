@@ -26,17 +26,26 @@ namespace eudaq {
     m_callback = callback;
   }
 
+  void TransportBase::SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                                 const ConnectionInfo &inf, bool duringconnect) {
+    std::vector<unsigned char> buf;
+    for (auto &s : segments)
+      buf.insert(buf.end(), s.data, s.data + s.size);
+    SendPacket(buf.data(), buf.size(), inf, duringconnect);
+  }
+
   void TransportBase::Process(int timeout) {
     if (timeout == -1)
       timeout = DEFAULT_TIMEOUT;
     std::unique_lock<std::recursive_mutex> lk(m_mutex);
-    ProcessEvents(timeout);
+    // events queued outside ProcessEvents (e.g. on resuming a connection) are not delayed
+    ProcessEvents(m_events.empty() ? timeout : 0);
     lk.unlock();
     for (;;) {
       std::unique_lock<std::recursive_mutex> lk(m_mutex);
       if (m_events.empty())
         break;
-      TransportEvent evt(m_events.front());
+      TransportEvent evt(std::move(m_events.front()));
       m_events.pop();
       lk.unlock();
       m_callback(evt);
@@ -61,7 +70,7 @@ namespace eudaq {
     bool ret = false;
     if (!m_events.empty() && conn.Matches(*(m_events.front().id))) {
       ret = true;
-      *packet = m_events.front().packet;
+      *packet = std::move(m_events.front().packet);
       m_events.pop();
     }
     return ret;
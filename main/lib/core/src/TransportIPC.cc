@@ -0,0 +1,116 @@
+#include "eudaq/TransportIPC.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+#include "eudaq/Logger.hh"
+
+#if !(EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW))
+#include "eudaq/TransportTCP_POSIX.hh"
+
+#include <climits>
+#include <cstring>
+#include <sys/un.h>
+
+namespace eudaq {
+  const std::string IPCServer::name = "ipc";
+  const std::string IPCClient::name = "ipc";
+
+  namespace{
+    auto d0=Factory<TransportServer>::Register<IPCServer, const std::string&>
+      (str2hash(IPCServer::name));
+    auto d1=Factory<TransportClient>::Register<IPCClient, const std::string&>
+      (str2hash(IPCClient::name));
+  }
+
+  namespace {
+    static const int MAXPENDING = 16;
+
+    // relative paths are resolved here, the address is passed on to other processes
+    std::string absolute_path(const std::string &param) {
+      std::string path = trim(param);
+      if (path.empty())
+        EUDAQ_THROW_NOLOG("TransportIPC:: No socket path given");
+      if (path[0] != '/') {
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof cwd))
+          path = std::string(cwd) + "/" + path;
+      }
+      return path;
+    }
+
+    sockaddr_un make_addr(const std::string &path) {
+      sockaddr_un addr;
+      std::memset(&addr, 0, sizeof addr);
+      addr.sun_family = AF_UNIX;
+      if (path.size() >= sizeof addr.sun_path)
+        EUDAQ_THROW_NOLOG("TransportIPC:: Socket path is too long: " + path);
+      std::strncpy(addr.sun_path, path.c_str(), sizeof addr.sun_path - 1);
+      return addr;
+    }
+
+    SOCKET connect_socket(const std::string &path) {
+      sockaddr_un addr = make_addr(path);
+      SOCKET sock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (sock == INVALID_SOCKET)
+        EUDAQ_THROW_NOLOG(LastSockErrorString("IPCClient:: Failed to create socket"));
+      if (connect(sock, (sockaddr *)&addr, sizeof addr)) {
+        std::string err = LastSockErrorString(
+            "Are you sure the server is running? - Error connecting to ipc://" + path);
+        closesocket(sock);
+        EUDAQ_THROW_NOLOG(err);
+      }
+      setup_socket(sock); // set to non-blocking
+      return sock;
+    }
+
+    SOCKET listen_socket(const std::string &path) {
+      sockaddr_un addr = make_addr(path);
+      SOCKET sock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (sock == INVALID_SOCKET)
+        EUDAQ_THROW_NOLOG(LastSockErrorString("IPCServer:: Failed to create socket"));
+      int result = bind(sock, (sockaddr *)&addr, sizeof addr);
+      if (result && LastSockError() == EADDRINUSE) {
+        // a socket file without a server behind it is left over, replace it
+        SOCKET probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool alive = probe != INVALID_SOCKET &&
+          connect(probe, (sockaddr *)&addr, sizeof addr) == 0;
+        if (probe != INVALID_SOCKET)
+          closesocket(probe);
+        if (alive) {
+          closesocket(sock);
+          EUDAQ_THROW_NOLOG("IPCServer:: ipc://" + path + " is already in use");
+        }
+        unlink(path.c_str());
+        result = bind(sock, (sockaddr *)&addr, sizeof addr);
+      }
+      if (result) {
+        std::string err = LastSockErrorString("IPCServer:: Failed to bind socket: " + path);
+        closesocket(sock);
+        EUDAQ_THROW_NOLOG(err);
+      }
+      if (listen(sock, MAXPENDING)) {
+        std::string err = LastSockErrorString("IPCServer:: Failed to listen on socket: " + path);
+        closesocket(sock);
+        unlink(path.c_str());
+        EUDAQ_THROW_NOLOG(err);
+      }
+      setup_socket(sock);
+      return sock;
+    }
+  }
+
+  IPCServer::IPCServer(const std::string &param)
+    : TCPServer(listen_socket(absolute_path(param))), m_path(absolute_path(param)) {}
+
+  IPCServer::~IPCServer() {
+    unlink(m_path.c_str());
+  }
+
+  std::string IPCServer::ConnectionString() const {
+    return name + "://" + m_path;
+  }
+
+  IPCClient::IPCClient(const std::string &param)
+    : TCPClient(connect_socket(absolute_path(param)), name + "://" + absolute_path(param)) {}
+}
+
+#endif
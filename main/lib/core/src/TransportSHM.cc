@@ -0,0 +1,619 @@
+#include "eudaq/TransportSHM.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Time.hh"
+#include "eudaq/Utils.hh"
+#include "eudaq/Logger.hh"
+
+#if !(EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW))
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if EUDAQ_PLATFORM_IS(LINUX)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace eudaq {
+  const std::string SHMServer::name = "shm";
+  const std::string SHMClient::name = "shm";
+
+  namespace{
+    auto d0=Factory<TransportServer>::Register<SHMServer, const std::string&>
+      (str2hash(SHMServer::name));
+    auto d1=Factory<TransportClient>::Register<SHMClient, const std::string&>
+      (str2hash(SHMClient::name));
+  }
+
+  namespace {
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                  "shm:// needs lock-free atomics to share them between processes");
+
+    static const uint32_t MAGIC = 0x4d485345; // "ESHM"
+    static const size_t MAX_SLOTS = 64;
+    static const size_t MAX_SEGMENT_NAME = 64;
+    static const size_t DEFAULT_RING_MB = 16; // client to server, EUDAQ_SHM_RING_MB
+    static const size_t REPLY_RING_SIZE = 1 << 20; // server to client
+    // allocated for a packet before its bytes have arrived; beyond, the
+    // buffer grows with the received data instead of trusting the header
+    static const size_t PACKET_CHUNK = 1 << 20;
+
+    // a blocked side still looks for a closed or crashed peer this often
+    static const uint32_t WAIT_US = 10000;
+
+    enum SlotState { SLOT_FREE = 0, SLOT_CLAIMED = 1, SLOT_READY = 2 };
+
+    // wakes up a side waiting for its peer: seq changes on every ring update,
+    // a futex across the processes sharing the memory
+    struct Doorbell {
+      std::atomic<uint32_t> seq;
+      std::atomic<uint32_t> waiters;
+    };
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                  "the doorbell is used as a futex word");
+
+    // a connection request of a client, in the control segment of the server
+    struct Slot {
+      std::atomic<uint32_t> state;
+      int32_t pid;
+      char segment[MAX_SEGMENT_NAME];
+    };
+
+    struct Control {
+      uint32_t magic;
+      int32_t pid;
+      Doorbell bell; // the server, rung by the clients on new data
+      Slot slots[MAX_SLOTS];
+    };
+
+    struct alignas(64) RingHeader {
+      alignas(64) std::atomic<uint64_t> head; // bytes written by the producer
+      alignas(64) std::atomic<uint64_t> tail; // bytes read by the consumer
+    };
+
+    // index 0 is the client, 1 the server; ring i is written by side i
+    struct alignas(64) SegmentHeader {
+      uint32_t magic;
+      uint64_t size[2];
+      std::atomic<int32_t> pid[2];
+      std::atomic<uint32_t> closed[2];
+      Doorbell bell[2]; // side i waits on bell[i] for space in its ring
+      RingHeader ring[2];
+    };
+
+    size_t round_up(size_t n) { return (n + 63) & ~size_t(63); }
+
+    size_t ring_offset(const SegmentHeader *h, int i) {
+      return round_up(sizeof(SegmentHeader)) + (i ? round_up(h->size[0]) : 0);
+    }
+
+    std::string control_name(const std::string &name) { return "/eudaq." + name; }
+
+    bool process_gone(int32_t pid) {
+      return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+    }
+
+    void ring(Doorbell &bell) {
+      bell.seq.fetch_add(1);
+#if EUDAQ_PLATFORM_IS(LINUX)
+      if (bell.waiters.load())
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&bell.seq), FUTEX_WAKE, INT_MAX,
+                nullptr, nullptr, 0);
+#endif
+    }
+
+    // blocks until the bell rings after seq was seen, at most timeout_us
+    void wait(Doorbell &bell, uint32_t seen, uint32_t timeout_us) {
+      if (!timeout_us)
+        return;
+#if EUDAQ_PLATFORM_IS(LINUX)
+      timespec ts;
+      ts.tv_sec = timeout_us / 1000000;
+      ts.tv_nsec = long(timeout_us % 1000000) * 1000;
+      bell.waiters.fetch_add(1);
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(&bell.seq), FUTEX_WAIT, seen, &ts,
+              nullptr, 0);
+      bell.waiters.fetch_sub(1);
+#else
+      // no futex, poll
+      if (bell.seq.load() == seen)
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min<uint32_t>(timeout_us, 50)));
+#endif
+    }
+
+    uint32_t wait_us(const Time &remain) {
+      double us = remain.Seconds() * 1e6;
+      return us <= 0 ? 0 : static_cast<uint32_t>(std::min<double>(us, WAIT_US));
+    }
+
+    void *map_segment(int fd, size_t len) {
+      void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      return p == MAP_FAILED ? nullptr : p;
+    }
+  }
+
+  ConnectionInfoSHM::ConnectionInfoSHM(const std::string &segment, bool server,
+                                       size_t ring_size)
+    : ConnectionInfo(""), m_segment(segment), m_server(server), m_base(nullptr),
+      m_len(0), m_ctl(nullptr), m_polls(0), m_head_n(0), m_packet_len(0), m_have(0), m_paused(false) {
+    std::string shm_name = "/" + segment;
+    if (!server) {
+      int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd < 0)
+        EUDAQ_THROW_NOLOG("TransportSHM:: Failed to create segment " + shm_name +
+                          ": " + std::strerror(errno));
+      m_len = round_up(sizeof(SegmentHeader)) + round_up(ring_size) + REPLY_RING_SIZE;
+      if (ftruncate(fd, m_len)) {
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        EUDAQ_THROW_NOLOG("TransportSHM:: Failed to size segment " + shm_name +
+                          ": " + std::strerror(errno));
+      }
+      m_base = static_cast<uint8_t *>(map_segment(fd, m_len));
+      if (!m_base) {
+        shm_unlink(shm_name.c_str());
+        EUDAQ_THROW_NOLOG("TransportSHM:: Failed to map segment " + shm_name);
+      }
+      auto h = new (m_base) SegmentHeader();
+      h->size[0] = round_up(ring_size);
+      h->size[1] = REPLY_RING_SIZE;
+      h->pid[0] = getpid();
+      h->magic = MAGIC;
+      return;
+    }
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+      EUDAQ_THROW_NOLOG("TransportSHM:: Failed to open segment " + shm_name +
+                        ": " + std::strerror(errno));
+    // nobody else needs the name, the memory is freed with the last mapping
+    shm_unlink(shm_name.c_str());
+    struct stat st;
+    if (fstat(fd, &st) || size_t(st.st_size) < sizeof(SegmentHeader)) {
+      close(fd);
+      EUDAQ_THROW_NOLOG("TransportSHM:: Invalid segment " + shm_name);
+    }
+    m_len = st.st_size;
+    m_base = static_cast<uint8_t *>(map_segment(fd, m_len));
+    if (!m_base)
+      EUDAQ_THROW_NOLOG("TransportSHM:: Failed to map segment " + shm_name);
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    if (h->magic != MAGIC ||
+        ring_offset(h, 1) + h->size[1] > m_len) {
+      munmap(m_base, m_len);
+      m_base = nullptr;
+      EUDAQ_THROW_NOLOG("TransportSHM:: Invalid segment " + shm_name);
+    }
+    h->pid[1] = getpid();
+  }
+
+  ConnectionInfoSHM::~ConnectionInfoSHM() {
+    if (!m_base)
+      return;
+    Shutdown();
+    munmap(m_base, m_len);
+    if (m_ctl)
+      munmap(m_ctl, sizeof(Control));
+    if (!m_server)
+      shm_unlink(("/" + m_segment).c_str()); // in case the server never attached
+  }
+
+  void ConnectionInfoSHM::Shutdown() {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    h->closed[m_server].store(1, std::memory_order_release);
+    wake_peer(true);
+    wake_peer(false);
+  }
+
+  void ConnectionInfoSHM::AttachControl(void *ctl) {
+    m_ctl = ctl;
+  }
+
+  void ConnectionInfoSHM::wake_peer(bool data) {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    if (m_server)
+      ring(h->bell[0]);
+    else if (data && m_ctl)
+      ring(static_cast<Control *>(m_ctl)->bell); // the server waits for all clients at once
+    else
+      ring(h->bell[1]);
+  }
+
+  uint32_t ConnectionInfoSHM::Wakeups() const {
+    auto h = reinterpret_cast<const SegmentHeader *>(m_base);
+    return h->bell[m_server].seq.load();
+  }
+
+  void ConnectionInfoSHM::WaitWakeup(uint32_t seen, uint32_t timeout_us) {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    wait(h->bell[m_server], seen, timeout_us);
+  }
+
+  bool ConnectionInfoSHM::PeerClosed() {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    if (h->closed[!m_server].load(std::memory_order_acquire))
+      return true;
+    // a crashed peer cannot tell, look for its process now and then
+    return (m_polls++ % 256 == 0) && process_gone(h->pid[!m_server].load());
+  }
+
+  void ConnectionInfoSHM::write_ring(const uint8_t *data, size_t len) {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    int i = m_server;
+    RingHeader &r = h->ring[i];
+    uint8_t *buf = m_base + ring_offset(h, i);
+    uint64_t size = h->size[i];
+    while (len) {
+      uint32_t seen = h->bell[i].seq.load();
+      uint64_t head = r.head.load(std::memory_order_relaxed);
+      uint64_t space = size - (head - r.tail.load(std::memory_order_acquire));
+      if (!space) {
+        if (PeerClosed())
+          EUDAQ_THROW_NOLOG("TransportSHM:: Connection closed by peer");
+        if (h->closed[i].load(std::memory_order_acquire))
+          EUDAQ_THROW_NOLOG("TransportSHM:: Connection closed");
+        wait(h->bell[i], seen, WAIT_US);
+        continue;
+      }
+      size_t n = static_cast<size_t>(std::min<uint64_t>(len, space));
+      size_t pos = static_cast<size_t>(head % size);
+      size_t n1 = std::min<size_t>(n, size - pos);
+      std::memcpy(buf + pos, data, n1);
+      std::memcpy(buf, data + n1, n - n1);
+      r.head.store(head + n, std::memory_order_release);
+      wake_peer(true);
+      data += n;
+      len -= n;
+    }
+  }
+
+  void ConnectionInfoSHM::Send(const GatherSerializer::Segment *segs, size_t nsegs) {
+    std::unique_lock<std::mutex> lk(m_mtx_send);
+    size_t len = 0;
+    for (size_t i = 0; i < nsegs; ++i)
+      len += segs[i].size;
+    uint8_t header[4];
+    for (int i = 0; i < 4; ++i) {
+      header[i] = static_cast<uint8_t>(len & 0xff);
+      len >>= 8;
+    }
+    write_ring(header, 4);
+    for (size_t i = 0; i < nsegs; ++i)
+      write_ring(segs[i].data, segs[i].size);
+  }
+
+  size_t ConnectionInfoSHM::Read() {
+    auto h = reinterpret_cast<SegmentHeader *>(m_base);
+    int i = !m_server;
+    RingHeader &r = h->ring[i];
+    const uint8_t *buf = m_base + ring_offset(h, i);
+    uint64_t size = h->size[i];
+    uint64_t tail = r.tail.load(std::memory_order_relaxed);
+    uint64_t avail = r.head.load(std::memory_order_acquire) - tail;
+    size_t total = static_cast<size_t>(avail);
+    while (avail) {
+      size_t pos = static_cast<size_t>(tail % size);
+      size_t n = static_cast<size_t>(std::min<uint64_t>(avail, size - pos));
+      append(n, buf + pos);
+      tail += n;
+      avail -= n;
+    }
+    r.tail.store(tail, std::memory_order_release);
+    if (total)
+      wake_peer(false);
+    return total;
+  }
+
+  void ConnectionInfoSHM::append(size_t length, const uint8_t *data) {
+    while (length) {
+      if (m_head_n < 4) {
+        size_t n = std::min(length, 4 - m_head_n);
+        std::memcpy(m_head + m_head_n, data, n);
+        m_head_n += n;
+        data += n;
+        length -= n;
+        if (m_head_n < 4)
+          break;
+        m_packet_len = 0;
+        for (int i = 0; i < 4; ++i)
+          m_packet_len |= static_cast<size_t>(m_head[i]) << (8 * i);
+        m_have = 0;
+      }
+      size_t n = std::min(length, m_packet_len - m_have);
+      reserve(n);
+      if (n)
+        std::memcpy(&m_packet[m_have], data, n);
+      m_have += n;
+      data += n;
+      length -= n;
+      if (m_have == m_packet_len) {
+        m_ready.push_back(std::move(m_packet));
+        m_packet = std::string();
+        m_head_n = 0;
+        m_packet_len = 0;
+        m_have = 0;
+      }
+    }
+  }
+
+  void ConnectionInfoSHM::reserve(size_t length) {
+    // at most doubled beyond the received bytes
+    size_t need = m_have + length;
+    if (need <= m_packet.size())
+      return;
+    size_t size = std::max(need, std::max(m_packet.size() * 2, PACKET_CHUNK));
+    m_packet.resize(std::min(size, m_packet_len));
+  }
+
+  bool ConnectionInfoSHM::havepacket() const {
+    return !m_ready.empty();
+  }
+
+  std::string ConnectionInfoSHM::getpacket() {
+    if (!havepacket())
+      EUDAQ_THROW_NOLOG("TransportSHM:: No packet available");
+    std::string packet(std::move(m_ready.front()));
+    m_ready.pop_front();
+    return packet;
+  }
+
+  bool ConnectionInfoSHM::Matches(const ConnectionInfo &other) const {
+    const ConnectionInfoSHM *ptr = dynamic_cast<const ConnectionInfoSHM *>(&other);
+    return ptr && ptr->m_segment == m_segment;
+  }
+
+  void ConnectionInfoSHM::Print(std::ostream &os, size_t offset) const {
+    os << std::string(offset, ' ') << "<ConnectionSHM>\n";
+    os << std::string(offset + 2, ' ') << "<Segment>" << m_segment << "</Segment>\n";
+    ConnectionInfo::Print(os, offset + 2);
+    os << std::string(offset, ' ') << "</ConnectionSHM>\n";
+  }
+
+  SHMServer::SHMServer(const std::string &param)
+    : m_name(trim(param)), m_ctl(nullptr) {
+    if (m_name.empty() || m_name.find('/') != std::string::npos)
+      EUDAQ_THROW_NOLOG("SHMServer:: Invalid name: '" + param + "'");
+    std::string shm_name = control_name(m_name);
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+      // left over by a server which did not shut down
+      int fd_old = shm_open(shm_name.c_str(), O_RDWR, 0600);
+      auto old = fd_old < 0 ? nullptr : static_cast<Control *>(map_segment(fd_old, sizeof(Control)));
+      bool stale = old && (old->magic != MAGIC || process_gone(old->pid));
+      if (old)
+        munmap(old, sizeof(Control));
+      if (!stale)
+        EUDAQ_THROW_NOLOG("SHMServer:: shm://" + m_name + " is already in use");
+      shm_unlink(shm_name.c_str());
+      fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0)
+      EUDAQ_THROW_NOLOG("SHMServer:: Failed to create " + shm_name + ": " +
+                        std::strerror(errno));
+    if (ftruncate(fd, sizeof(Control))) {
+      close(fd);
+      shm_unlink(shm_name.c_str());
+      EUDAQ_THROW_NOLOG("SHMServer:: Failed to size " + shm_name);
+    }
+    m_ctl = map_segment(fd, sizeof(Control));
+    if (!m_ctl) {
+      shm_unlink(shm_name.c_str());
+      EUDAQ_THROW_NOLOG("SHMServer:: Failed to map " + shm_name);
+    }
+    auto ctl = new (m_ctl) Control();
+    ctl->pid = getpid();
+    ctl->magic = MAGIC;
+    EUDAQ_INFO("SHMServer:: Listening on shm://" + m_name);
+  }
+
+  SHMServer::~SHMServer() {
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    m_conn.clear();
+    if (m_ctl) {
+      munmap(m_ctl, sizeof(Control));
+      shm_unlink(control_name(m_name).c_str());
+    }
+  }
+
+  void SHMServer::Accept() {
+    auto ctl = static_cast<Control *>(m_ctl);
+    for (auto &slot : ctl->slots) {
+      uint32_t state = slot.state.load(std::memory_order_acquire);
+      if (state == SLOT_CLAIMED && process_gone(slot.pid))
+        slot.state.store(SLOT_FREE, std::memory_order_release);
+      if (state != SLOT_READY)
+        continue;
+      std::string segment(slot.segment, strnlen(slot.segment, MAX_SEGMENT_NAME));
+      slot.state.store(SLOT_FREE, std::memory_order_release);
+      std::shared_ptr<ConnectionInfoSHM> conn;
+      try {
+        conn = std::make_shared<ConnectionInfoSHM>(segment, true);
+      } catch (const Exception &e) {
+        EUDAQ_WARN(std::string("SHMServer:: Connection refused: ") + e.what());
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(m_mtx_conn);
+      m_conn.push_back(conn);
+      lk.unlock();
+      m_events.push(TransportEvent(TransportEvent::CONNECT, conn));
+    }
+  }
+
+  void SHMServer::Close(const ConnectionInfo &id) {
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    for (auto it = m_conn.begin(); it != m_conn.end();) {
+      if (id.Matches(**it))
+        it = m_conn.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  void SHMServer::SendPacket(const unsigned char *data, size_t len,
+                             const ConnectionInfo &id, bool duringconnect) {
+    SendPacket(std::vector<GatherSerializer::Segment>(1, GatherSerializer::Segment{data, len}),
+               id, duringconnect);
+  }
+
+  void SHMServer::SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                             const ConnectionInfo &id, bool duringconnect) {
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    auto conns = m_conn;
+    lk.unlock();
+    for (auto &conn : conns) {
+      if (id.Matches(*conn) && (conn->GetState() > 0 || duringconnect))
+        conn->Send(segments.data(), segments.size());
+    }
+  }
+
+  void SHMServer::ProcessEvents(int timeout) {
+    Time t_start = Time::Current();
+    Time t_remain = Time(0, timeout);
+    bool done = false;
+    auto ctl = static_cast<Control *>(m_ctl);
+    do {
+      uint32_t seen = ctl->bell.seq.load();
+      Accept();
+      std::unique_lock<std::mutex> lk(m_mtx_conn);
+      auto conns = m_conn;
+      lk.unlock();
+      for (auto &conn : conns) {
+        if (conn->IsPaused())
+          continue;
+        // checked before reading, so that all data sent before closing is taken
+        bool closed = conn->PeerClosed();
+        if (conn->Read()) {
+          while (conn->havepacket()) {
+            done = true;
+            m_events.push(TransportEvent(TransportEvent::RECEIVE, conn, conn->getpacket()));
+          }
+        } else if (closed) {
+          m_events.push(TransportEvent(TransportEvent::DISCONNECT, conn));
+          Close(*conn);
+        }
+      }
+      if (done)
+        break;
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+      wait(ctl->bell, seen, wait_us(t_remain));
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+    } while (t_remain > Time(0));
+  }
+
+  void SHMServer::PauseReceiving(const ConnectionInfo &id, bool pause) {
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    for (auto &conn : m_conn)
+      if (id.Matches(*conn))
+        conn->SetPaused(pause);
+  }
+
+  std::string SHMServer::ConnectionString() const {
+    return name + "://" + m_name;
+  }
+
+  std::vector<ConnectionSPC> SHMServer::GetConnections() const {
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    return std::vector<ConnectionSPC>(m_conn.begin(), m_conn.end());
+  }
+
+  SHMClient::SHMClient(const std::string &param) {
+    std::string server = trim(param);
+    std::string ctl_name = control_name(server);
+    int fd = shm_open(ctl_name.c_str(), O_RDWR, 0600);
+    auto ctl = fd < 0 ? nullptr : static_cast<Control *>(map_segment(fd, sizeof(Control)));
+    if (!ctl || ctl->magic != MAGIC) {
+      if (ctl)
+        munmap(ctl, sizeof(Control));
+      EUDAQ_THROW_NOLOG("Are you sure the server is running? - Error connecting to shm://" +
+                        server);
+    }
+    static std::atomic<uint32_t> counter(0);
+    std::string segment = "eudaq." + to_string(getpid()) + "." + to_string(counter++);
+    size_t ring_mb = DEFAULT_RING_MB;
+    if (const char *env = std::getenv("EUDAQ_SHM_RING_MB"))
+      ring_mb = std::max(1, std::atoi(env));
+    try {
+      m_buf = std::make_shared<ConnectionInfoSHM>(segment, false, ring_mb << 20);
+    } catch (...) {
+      munmap(ctl, sizeof(Control));
+      throw;
+    }
+    // hand the segment over to the server through a free slot
+    bool posted = false;
+    for (auto &slot : ctl->slots) {
+      uint32_t expected = SLOT_FREE;
+      if (!slot.state.compare_exchange_strong(expected, SLOT_CLAIMED))
+        continue;
+      slot.pid = getpid();
+      std::memset(slot.segment, 0, MAX_SEGMENT_NAME);
+      std::strncpy(slot.segment, segment.c_str(), MAX_SEGMENT_NAME - 1);
+      slot.state.store(SLOT_READY, std::memory_order_release);
+      posted = true;
+      break;
+    }
+    if (!posted) {
+      munmap(ctl, sizeof(Control));
+      EUDAQ_THROW_NOLOG("SHMClient:: No free connection slot on shm://" + server);
+    }
+    m_buf->AttachControl(ctl);
+    ring(ctl->bell);
+  }
+
+  SHMClient::~SHMClient() {}
+
+  void SHMClient::Close(const ConnectionInfo &) {
+    m_buf->Shutdown();
+  }
+
+  void SHMClient::SendPacket(const unsigned char *data, size_t len,
+                             const ConnectionInfo &id, bool) {
+    GatherSerializer::Segment seg = {data, len};
+    if (id.Matches(*m_buf))
+      m_buf->Send(&seg, 1);
+  }
+
+  void SHMClient::SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                             const ConnectionInfo &id, bool) {
+    if (id.Matches(*m_buf))
+      m_buf->Send(segments.data(), segments.size());
+  }
+
+  void SHMClient::ProcessEvents(int timeout) {
+    Time t_start = Time::Current();
+    Time t_remain = Time(0, timeout);
+    do {
+      uint32_t seen = m_buf->Wakeups();
+      bool closed = m_buf->PeerClosed();
+      if (m_buf->Read()) {
+        bool done = false;
+        while (m_buf->havepacket()) {
+          done = true;
+          m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf, m_buf->getpacket()));
+        }
+        if (done)
+          break;
+      } else if (closed) {
+        EUDAQ_THROW_NOLOG("SHMClient:: Connection closed by the server");
+      }
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+      m_buf->WaitWakeup(seen, wait_us(t_remain));
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+    } while (t_remain > Time(0));
+  }
+}
+
+#endif
@@ -45,6 +45,8 @@ at some places we have constructions like:
 #include "eudaq/Utils.hh"
 #include "eudaq/Logger.hh"
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 
 #if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
@@ -54,6 +56,10 @@ at some places we have constructions like:
 #include "eudaq/TransportTCP_POSIX.hh"
 #endif
 
+#ifdef EUDAQ_WITH_EPOLL
+#include <sys/epoll.h>
+#endif
+
 // print debug messages that are optimized out if DEBUG_TRANSPORT is not set:
 // source and details:
 // http://stackoverflow.com/questions/1644868/c-define-macro-for-debug-printing
@@ -80,8 +86,14 @@ namespace eudaq {
   
   namespace {
     static const int MAXPENDING = 16;
-    static const int MAX_BUFFER_SIZE = 10000;
-    static int to_int(char c) { return static_cast<unsigned char>(c); }
+    static const int MAX_BUFFER_SIZE = 65536;
+    static const int MAX_EPOLL_EVENTS = 64;
+    // read from one connection at a time, so that a fast sender cannot fill
+    // the memory before the callbacks have seen its packets
+    static const size_t MAX_RECEIVE_BYTES = 4 << 20;
+    // allocated for a packet before its bytes have arrived; beyond, the
+    // buffer grows with the received data instead of trusting the header
+    static const size_t PACKET_CHUNK = 1 << 20;
 #ifdef MSG_NOSIGNAL
     // On Linux (and cygwin?) send(...) can be told to
     // ignore signals by setting the flag below
@@ -99,6 +111,19 @@ namespace eudaq {
     }
 #endif
 
+    // waits until the full send buffer has room again, instead of spinning;
+    // a connection closed meanwhile makes the next send fail
+    static void wait_writable(SOCKET sock) {
+      fd_set wrset;
+      FD_ZERO(&wrset);
+      FD_SET(sock, &wrset);
+      timeval tv;
+      tv.tv_sec = 0;
+      tv.tv_usec = 100000;
+      select(static_cast<int>(sock + 1), NULL, &wrset, NULL, &tv);
+    }
+
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
     static void do_send_data(SOCKET sock, const unsigned char *data,
                              size_t len) {
       size_t sent = 0;
@@ -112,7 +137,7 @@ namespace eudaq {
 	else if (result < 0 &&
 		 (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
 		  LastSockError() == EUDAQ_ERROR_Interrupted_function_call)){
-          // continue
+          wait_writable(sock);
         }
 	else if (result == 0) {
           EUDAQ_THROW_NOLOG("TransportTCP:: Connection reset by peer");
@@ -122,9 +147,75 @@ namespace eudaq {
         }
       } while (sent < len);
     }
+#else
+#ifdef IOV_MAX
+    static const size_t MAX_IOV = IOV_MAX;
+#else
+    static const size_t MAX_IOV = 16;
+#endif
+#endif
+
+    // the length header and the segments are handed to the kernel together,
+    // without first copying them into one buffer
+    static void do_send_segments(SOCKET sock, const GatherSerializer::Segment *segs,
+                                 size_t nsegs, size_t length) {
+      size_t len = length;
+      unsigned char header[4] = {0};
+      for (int i = 0; i < 4; ++i) {
+        header[i] = static_cast<unsigned char>(len & 0xff);
+        len >>= 8;
+      }
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
+      do_send_data(sock, header, 4);
+      for (size_t i = 0; i < nsegs; ++i)
+        do_send_data(sock, segs[i].data, segs[i].size);
+#else
+      std::vector<iovec> iov;
+      iov.reserve(nsegs + 1);
+      iov.push_back(iovec{header, 4});
+      for (size_t i = 0; i < nsegs; ++i) {
+        if (segs[i].size)
+          iov.push_back(iovec{const_cast<uint8_t *>(segs[i].data), segs[i].size});
+      }
+      size_t first = 0;
+      while (first < iov.size()) {
+        msghdr msg;
+        std::memset(&msg, 0, sizeof msg);
+        msg.msg_iov = &iov[first];
+        msg.msg_iovlen = std::min(iov.size() - first, MAX_IOV);
+        ssize_t result = sendmsg(sock, &msg, FLAGS);
+        if (result > 0) {
+          // skip what has been sent, a segment may be sent partially
+          size_t sent = result;
+          while (sent) {
+            if (sent >= iov[first].iov_len) {
+              sent -= iov[first].iov_len;
+              first++;
+            } else {
+              iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + sent;
+              iov[first].iov_len -= sent;
+              sent = 0;
+            }
+          }
+        }
+        else if (result < 0 &&
+                 (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
+                  LastSockError() == EUDAQ_ERROR_Interrupted_function_call)) {
+          wait_writable(sock);
+        }
+        else if (result == 0) {
+          EUDAQ_THROW_NOLOG("TransportTCP:: Connection reset by peer");
+        }
+        else {
+          EUDAQ_THROW_NOLOG(LastSockErrorString("TransportTCP:: Error sending data"));
+        }
+      }
+#endif
+    }
 
     static void do_send_packet(SOCKET sock, const unsigned char *data,
                                size_t length){
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
       if (length < 1020) {
         size_t len = length;
         std::string buffer(len + 4, '\0');
@@ -135,16 +226,18 @@ namespace eudaq {
         std::copy(data, data + length, &buffer[4]);
         do_send_data(sock, reinterpret_cast<const unsigned char *>(&buffer[0]),
                      buffer.length());
-      } else {
-        size_t len = length;
-        unsigned char buffer[4] = {0};
-        for (int i = 0; i < 4; ++i) {
-          buffer[i] = static_cast<unsigned char>(len & 0xff);
-          len >>= 8;
-        }
-        do_send_data(sock, buffer, 4);
-        do_send_data(sock, data, length);
+        return;
       }
+#endif
+      GatherSerializer::Segment seg = {data, length};
+      do_send_segments(sock, &seg, 1, length);
+    }
+
+    static size_t segments_size(const std::vector<GatherSerializer::Segment> &segments) {
+      size_t length = 0;
+      for (auto &s : segments)
+        length += s.size;
+      return length;
     }
 
   } // anonymous namespace
@@ -165,38 +258,81 @@ namespace eudaq {
   }
 
   void ConnectionInfoTCP::append(size_t length, const char *data) {
-    m_buf += std::string(data, length);
-    update_length();
+    while (length) {
+      if (m_head_n < 4) {
+        size_t n = std::min(length, 4 - m_head_n);
+        std::memcpy(m_head + m_head_n, data, n);
+        m_head_n += n;
+        data += n;
+        length -= n;
+        if (m_head_n < 4)
+          break;
+        m_packet_len = 0;
+        for (int i = 0; i < 4; ++i)
+          m_packet_len |= static_cast<size_t>(m_head[i]) << (8 * i);
+        m_have = 0;
+        if (m_packet_len == 0) {
+          complete();
+          continue;
+        }
+      }
+      size_t n = std::min(length, m_packet_len - m_have);
+      reserve(n);
+      std::memcpy(&m_packet[m_have], data, n);
+      data += n;
+      length -= n;
+      bodyreceived(n);
+    }
+  }
+
+  void ConnectionInfoTCP::reserve(size_t length) {
+    // the packet is received into its final buffer, which is handed over to
+    // the TransportEvent as it is; at most doubled beyond the received bytes
+    size_t need = m_have + length;
+    if (need <= m_packet.size())
+      return;
+    size_t size = std::max(need, std::max(m_packet.size() * 2, PACKET_CHUNK));
+    m_packet.resize(std::min(size, m_packet_len));
+  }
+
+  char *ConnectionInfoTCP::bodybuffer(size_t &length) {
+    if (m_head_n < 4 || m_packet_len - m_have < static_cast<size_t>(MAX_BUFFER_SIZE))
+      return nullptr;
+    reserve(MAX_BUFFER_SIZE);
+    length = m_packet.size() - m_have;
+    return &m_packet[m_have];
+  }
+
+  void ConnectionInfoTCP::bodyreceived(size_t length) {
+    m_have += length;
+    if (m_have == m_packet_len)
+      complete();
+  }
+
+  void ConnectionInfoTCP::complete() {
+    m_ready.push_back(std::move(m_packet));
+    m_packet = std::string();
+    m_head_n = 0;
+    m_packet_len = 0;
+    m_have = 0;
   }
 
   bool ConnectionInfoTCP::havepacket() const {
-    return m_buf.length() >= m_len + 4;
+    return !m_ready.empty();
   }
 
   std::string ConnectionInfoTCP::getpacket() {
     if (!havepacket())
       EUDAQ_THROW_NOLOG("TransprotTCP:: No packet available");
-    std::string packet(m_buf, 4, m_len);
-    m_buf.erase(0, m_len + 4);
-    update_length(true);
+    std::string packet(std::move(m_ready.front()));
+    m_ready.pop_front();
     return packet;
   }
 
-  void ConnectionInfoTCP::update_length(bool force) {
-    if (force || m_len == 0) {
-      m_len = 0;
-      if (m_buf.length() >= 4) {
-        for (int i = 0; i < 4; ++i) {
-          m_len |= to_int(m_buf[i]) << (8 * i);
-        }
-      }
-    }
-  }
-
   TCPServer::TCPServer(const std::string &param)
       : m_port(from_string(param, 0)),
         m_srvsock(socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)),
-        m_maxfd(m_srvsock) {
+        m_maxfd(m_srvsock), m_epfd(-1) {
     if (m_srvsock == (SOCKET)-1)
       EUDAQ_THROW_NOLOG(LastSockErrorString("TCPServer:: Failed to create socket")); //$$ check if (SOCKET)-1 is correct
     setup_signal();
@@ -226,6 +362,36 @@ namespace eudaq {
       EUDAQ_THROW_NOLOG(
           LastSockErrorString("Failed to listen on socket: " + param));
     }
+
+    InitPoller();
+  }
+
+  TCPServer::TCPServer(SOCKET srvsock)
+      : m_port(0), m_srvsock(srvsock), m_maxfd(m_srvsock), m_epfd(-1) {
+    setup_signal();
+    FD_ZERO(&m_fdset);
+    FD_SET(m_srvsock, &m_fdset);
+    InitPoller();
+  }
+
+  void TCPServer::InitPoller() {
+#ifdef EUDAQ_WITH_EPOLL
+    // epoll is used unless EUDAQ_TCP_POLLER=select is set in the environment
+    const char *poller = std::getenv("EUDAQ_TCP_POLLER");
+    if (!poller || std::string(poller) != "select") {
+      m_epfd = epoll_create1(EPOLL_CLOEXEC);
+      epoll_event ev;
+      ev.events = EPOLLIN | EPOLLET;
+      ev.data.fd = m_srvsock;
+      if (m_epfd == -1 || epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_srvsock, &ev)) {
+        std::string err = LastSockErrorString("TCPServer:: Failed to set up epoll");
+        if (m_epfd != -1)
+          close(m_epfd);
+        closesocket(m_srvsock);
+        EUDAQ_THROW_NOLOG(err);
+      }
+    }
+#endif
   }
 
   TCPServer::~TCPServer() {
@@ -235,15 +401,16 @@ namespace eudaq {
       }
     }
     closesocket(m_srvsock);
+#ifdef EUDAQ_WITH_EPOLL
+    if (m_epfd != -1)
+      close(m_epfd);
+#endif
   }
 
   std::shared_ptr<ConnectionInfoTCP> TCPServer::GetInfo(SOCKET fd) const {
-    const ConnectionInfoTCP tofind(fd);
-    for(auto &conn: m_conn){
-      if (conn && tofind.Matches(*conn) && conn->GetState() >= 0) {
-	return conn;
-      }
-    }
+    auto it = m_fdconn.find(fd);
+    if (it != m_fdconn.end() && it->second->GetState() >= 0)
+      return it->second;
     EUDAQ_THROW_NOLOG("BUG: please report it");
   }
 
@@ -261,7 +428,13 @@ namespace eudaq {
     for(auto &conn: m_conn){
       if(conn && id.Matches(*conn)){
           SOCKET fd = conn->GetFd();
+#ifdef EUDAQ_WITH_EPOLL
+          if (m_epfd != -1)
+            epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr);
+          else
+#endif
           FD_CLR(fd, &m_fdset);
+          m_fdconn.erase(fd);
           closesocket(fd);
 	  conn.reset();
       }	
@@ -279,7 +452,165 @@ namespace eudaq {
     }
   }
 
+  void TCPServer::SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                             const ConnectionInfo &id, bool duringconnect) {
+    size_t length = segments_size(segments);
+    for(auto &conn: m_conn){
+      if(conn && id.Matches(*conn)){
+        if(conn->GetState() > 0 || duringconnect) {
+          do_send_segments(conn->GetFd(), segments.data(), segments.size(), length);
+        }
+      }
+    }
+  }
+
+  void TCPServer::PauseReceiving(const ConnectionInfo &id, bool pause) {
+    std::unique_lock<std::recursive_mutex> lk(m_mutex);
+    for(auto &conn: m_conn){
+      if(!conn || !id.Matches(*conn) || conn->IsPaused() == pause)
+	continue;
+      conn->SetPaused(pause);
+      SOCKET fd = conn->GetFd();
+#ifdef EUDAQ_WITH_EPOLL
+      if (m_epfd == -1)
+#endif
+      {
+	if (pause)
+	  FD_CLR(fd, &m_fdset);
+	else
+	  FD_SET(fd, &m_fdset);
+      }
+      // edge-triggered epoll does not report the data which arrived meanwhile
+      if (!pause)
+	Receive(fd);
+    }
+  }
+
+  void TCPServer::Accept() {
+    // take all pending connections, with edge-triggered epoll the listening
+    // socket is only reported again for new ones
+    for (;;) {
+      union {
+        sockaddr sa;
+        sockaddr_in in;
+        char buf[128]; // large enough for the addresses of other families
+      } addr;
+      socklen_t len = sizeof(addr);
+      SOCKET peersock = accept(static_cast<int>(m_srvsock), &addr.sa, &len);
+      if (peersock == INVALID_SOCKET) {
+        if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
+            LastSockError() == EUDAQ_ERROR_Interrupted_function_call)
+          return;
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in accept()"));
+      }
+      setup_socket(peersock);
+#ifdef EUDAQ_WITH_EPOLL
+      if (m_epfd != -1) {
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = peersock;
+        if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, peersock, &ev)) {
+          std::string err = LastSockErrorString("Error in epoll_ctl()");
+          closesocket(peersock);
+          EUDAQ_THROW_NOLOG(err);
+        }
+      }
+      else
+#endif
+      {
+        FD_SET(peersock, &m_fdset);
+        m_maxfd = (m_maxfd < peersock) ? peersock : m_maxfd;
+      }
+      std::string host;
+      if (addr.sa.sa_family == AF_INET) {
+        host = inet_ntoa(addr.in.sin_addr);
+        host = "tcp://"+host+":" + to_string(ntohs(addr.in.sin_port));
+      }
+      else
+        host = ConnectionString(); // local peers are unnamed
+      auto conn_new = std::make_shared<ConnectionInfoTCP>(peersock, host);
+      bool inserted = false;
+      for(auto &conn: m_conn) {
+        if(!conn) {
+          conn = conn_new;
+          inserted = true;
+          break;
+        }
+      }
+      if (!inserted)
+        m_conn.push_back(conn_new);
+      m_fdconn[peersock] = conn_new;
+      m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
+    }
+  }
+
+  bool TCPServer::Receive(SOCKET fd) {
+    // read until the socket is drained or the limit is reached, all
+    // complete packets are queued
+    bool packet = false;
+    size_t total = 0;
+    char buffer[MAX_BUFFER_SIZE + 1];
+    auto m = GetInfo(fd);
+    if (m->IsPaused())
+      return false;
+    for (;;) {
+      size_t len = 0;
+      char *body = m->bodybuffer(len);
+      int result;
+      do {
+        if (body)
+          result = recv(fd, body, static_cast<int>(std::min<size_t>(len, INT_MAX)), 0);
+        else
+          result = recv(fd, buffer, MAX_BUFFER_SIZE, 0);
+      } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
+               LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
+
+      if (result > 0) {
+        if (body)
+          m->bodyreceived(result);
+        else
+          m->append(result, buffer);
+        while (m->havepacket()) {
+          packet = true;
+          m_events.push(
+              TransportEvent(TransportEvent::RECEIVE, m, m->getpacket()));
+        }
+        total += result;
+        if (total >= MAX_RECEIVE_BYTES) {
+          // select() reports the rest again, edge-triggered epoll does not
+          if (m_epfd != -1)
+            m_unread.push_back(fd);
+          break;
+        }
+      }
+      else if (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
+               LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable) {
+        debug_transport(
+            "Server #%d, return=%d, WSAError:%d (%s) No Data Received.\n",
+            fd, result, errno, strerror(errno));
+        break;
+      } else {
+        // closed by the peer, reset or any other error: the connection is
+        // dropped, it would otherwise never be reported again by epoll
+        debug_transport(
+            "Server #%d, return=%d, WSAError:%d (%s) Disconnected.\n", fd,
+            result, errno, strerror(errno));
+        m_events.push(TransportEvent(TransportEvent::DISCONNECT, m));
+        Close(*m);
+        break;
+      }
+    }
+    return packet;
+  }
+
   void TCPServer::ProcessEvents(int timeout) {
+    if (m_epfd != -1)
+      ProcessEventsEpoll(timeout);
+    else
+      ProcessEventsSelect(timeout);
+  }
+
+  void TCPServer::ProcessEventsSelect(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
 #endif
@@ -299,68 +630,12 @@ namespace eudaq {
       } else if (result > 0) {
 
         if (FD_ISSET(m_srvsock, &tempset)) {
-          sockaddr_in addr;
-          socklen_t len = sizeof(addr);
-          SOCKET peersock = accept(static_cast<int>(m_srvsock), (sockaddr *)&addr, &len);
-          if (peersock == INVALID_SOCKET) {
-	    EUDAQ_THROW_NOLOG(LastSockErrorString("Error in accept()"));
-          }
-	  else {
-            FD_SET(peersock, &m_fdset);
-            m_maxfd = (m_maxfd < peersock) ? peersock : m_maxfd;
-            setup_socket(peersock);
-            std::string host = inet_ntoa(addr.sin_addr);
-            host = "tcp://"+host+":" + to_string(ntohs(addr.sin_port));
-            auto conn_new = std::make_shared<ConnectionInfoTCP>(peersock, host);
-            bool inserted = false;
-            for(auto &conn: m_conn) {
-              if(!conn) {
-                conn = conn_new;
-                inserted = true;
-		break;
-              }
-            }
-            if (!inserted)
-              m_conn.push_back(conn_new);
-            m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
-            FD_CLR(m_srvsock, &tempset);
-          }
+          Accept();
+          FD_CLR(m_srvsock, &tempset);
         }
         for (SOCKET j = 0; j < m_maxfd + 1; j++) {
-          if (FD_ISSET(j, &tempset)) {
-            char buffer[MAX_BUFFER_SIZE + 1];
-
-            do {
-              result = recv(j, buffer, MAX_BUFFER_SIZE, 0);
-            } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
-                     LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
-
-            if (result > 0) {
-              buffer[result] = 0;
-	      auto m = GetInfo(j);
-              m->append(result, buffer);
-              while (m->havepacket()) {
-                done = true;
-                m_events.push(
-                    TransportEvent(TransportEvent::RECEIVE, m, m->getpacket()));
-              }
-            }
-            else if (result == 0) {
-              debug_transport(
-                  "Server #%d, return=%d, WSAError:%d (%s) Disconnected.\n", j,
-                  result, errno, strerror(errno));
-	      auto m = GetInfo(j);
-              m_events.push(TransportEvent(TransportEvent::DISCONNECT, m));
-	      Close(*m);
-            } else if (result == EUDAQ_ERROR_NO_DATA_RECEIVED) {
-              debug_transport(
-                  "Server #%d, return=%d, WSAError:%d (%s) No Data Received.\n",
-                  j, result, errno, strerror(errno));
-            } else {
-              debug_transport("Server #%d, return=%d, WSAError:%d (%s) \n", j,
-                              result, errno, strerror(errno));
-            }
-          }
+          if (FD_ISSET(j, &tempset) && Receive(j))
+            done = true;
         }
       }
 
@@ -373,6 +648,46 @@ namespace eudaq {
     } while (!done && t_remain > Time(0));
   }
 
+  void TCPServer::ProcessEventsEpoll(int timeout) {
+#ifdef EUDAQ_WITH_EPOLL
+#if DEBUG_NOTIMEOUT == 0
+    Time t_start = Time::Current();
+#endif
+    Time t_remain = Time(0, timeout);
+    bool done = false;
+    do {
+      // connections left with data by the previous round
+      std::vector<SOCKET> unread;
+      unread.swap(m_unread);
+      for (SOCKET fd : unread)
+        if (m_fdconn.count(fd) && Receive(fd))
+          done = true;
+      timeval timeremain = t_remain;
+      int timeout_ms = done ? 0 : static_cast<int>(timeremain.tv_sec * 1000 +
+                                                   (timeremain.tv_usec + 999) / 1000);
+      epoll_event events[MAX_EPOLL_EVENTS];
+      int result = epoll_wait(m_epfd, events, MAX_EPOLL_EVENTS, timeout_ms);
+      if (result < 0 &&
+          LastSockError() != EUDAQ_ERROR_Interrupted_function_call) {
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in epoll_wait()"));
+      }
+      for (int i = 0; i < result; i++) {
+        SOCKET fd = events[i].data.fd;
+        if (fd == m_srvsock)
+          Accept();
+        else if (m_fdconn.count(fd) && Receive(fd))
+          done = true;
+      }
+
+#if DEBUG_NOTIMEOUT
+      t_remain = Time(0, timeout);
+#else
+      t_remain = Time(0, timeout) + t_start - Time::Current();
+#endif
+    } while (!done && t_remain > Time(0));
+#endif
+  }
+
   std::string TCPServer::ConnectionString() const{
 #ifdef _WIN32
     const char *host = std::getenv("computername");
@@ -404,6 +719,12 @@ namespace eudaq {
     OpenConnection();
   }
 
+  TCPClient::TCPClient(SOCKET sock, const std::string &param)
+      : m_server(param), m_port(0), m_sock(sock),
+        m_buf(std::make_shared<ConnectionInfoTCP>(m_sock, param)) {
+    setup_signal();
+  }
+
   void TCPClient::OpenConnection() {
     sockaddr_in addr;
     std::memset(&addr, 0, sizeof(addr));
@@ -435,6 +756,14 @@ namespace eudaq {
     }
   }
 
+  void TCPClient::SendPacket(const std::vector<GatherSerializer::Segment> &segments,
+                             const ConnectionInfo &id, bool) {
+    if(id.Matches(*m_buf)) {
+      do_send_segments(m_buf->GetFd(), segments.data(), segments.size(),
+                       segments_size(segments));
+    }
+  }
+
   void TCPClient::ProcessEvents(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
@@ -451,9 +780,14 @@ namespace eudaq {
       bool donereading = false;
       do {
         char buffer[MAX_BUFFER_SIZE + 1];
+        size_t len = 0;
+        char *body = m_buf->bodybuffer(len);
 
         do {
-          result = recv(m_sock, buffer, MAX_BUFFER_SIZE, 0);
+          if (body)
+            result = recv(m_sock, body, static_cast<int>(std::min<size_t>(len, INT_MAX)), 0);
+          else
+            result = recv(m_sock, buffer, MAX_BUFFER_SIZE, 0);
         } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
                  LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
 
@@ -472,7 +806,10 @@ namespace eudaq {
           EUDAQ_THROW_NOLOG(LastSockErrorString(
               "SocketClient Error (" + to_string(LastSockError()) + ")"));
         } else if (result > 0) {
-          m_buf->append(result, buffer);
+          if (body)
+            m_buf->bodyreceived(result);
+          else
+            m_buf->append(result, buffer);
           while (m_buf->havepacket()) {
             m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf,
                                          m_buf->getpacket()));
@@ -494,4 +831,14 @@ namespace eudaq {
   }
 
   TCPClient::~TCPClient() { closesocket(m_sock); }
+
+  void TCPClient::Close(const ConnectionInfo &) {
+    // may be called while another thread sends or receives: the socket is
+    // only shut down here, so that both fail at once, and closed later
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
+    shutdown(m_sock, SD_BOTH);
+#else
+    shutdown(m_sock, SHUT_RDWR);
+#endif
+  }
 }
@@ -106,7 +106,7 @@ void  init_pybind_event(py::module &m){
   
   event_.def("GetBlock",
 	     [](const eudaq::EventSP ev,uint32_t n){
-	        std::vector<uint8_t> block=ev->GetBlock(n);
+	        eudaq::BlockView block=ev->GetBlockView(n);
 	        return py::bytes((const char*)block.data(),block.size());
              },
      	     "Get block", py::arg("n"));
@@ -122,7 +122,7 @@ void  init_pybind_event(py::module &m){
 		uint32_t index, const std::string &data){
 	       std::vector<uint8_t> v;
 	       std::copy(data.begin(), data.end(), std::back_inserter(v));
-	       return ev->AddBlock(index,v);
+	       return ev->AddBlock(index,std::move(v));
 	     },
 	     "Add data block", py::arg("index"), py::arg("data"));
 }
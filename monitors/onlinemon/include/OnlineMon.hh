@@ -14,6 +14,7 @@
 #ifndef __CINT__
 #include "eudaq/Monitor.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/StdEventConverter.hh"
 #include "eudaq/Logger.hh"
 #include "eudaq/Utils.hh"
 #include "eudaq/OptionParser.hh"
@@ -68,6 +69,7 @@ class RootMonitor : public eudaq::Monitor{
   OnlineMonWindow *getOnlineMon() const;
   OnlineMonConfiguration mon_configdata; // FIXME
   std::shared_ptr<eudaq::Configuration> eu_cfgPtr;
+  std::unique_ptr<eudaq::StdEventConversionContext> eu_stdCtx;
 private:
   std::vector<BaseCollection *> _colls;
   OnlineMonWindow *onlinemon;
@@ -46,6 +46,8 @@
 #include "eudaq/StandardEvent.hh"
 #include "eudaq/StdEventConverter.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/ParallelFileReader.hh"
+#include "eudaq/StdEventBatchConverter.hh"
 using namespace std;
 
 RootMonitor::RootMonitor(const std::string & runcontrol,
@@ -86,6 +88,7 @@ RootMonitor::RootMonitor(const std::string & runcontrol,
 
   // Config for converters
   eu_cfgPtr = eudaq::Configuration::MakeUniqueReadFile(conffile);
+  eu_stdCtx.reset(new eudaq::StdEventConversionContext(eu_cfgPtr));
 
   //initialize with default configuration
   mon_configdata.SetDefaults();
@@ -173,7 +176,7 @@ void RootMonitor::DoReceive(eudaq::EventSP evsp) {
   auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(evsp);
   if(!stdev){
     stdev = eudaq::StandardEvent::MakeShared();
-    eudaq::StdEventConverter::Convert(evsp, stdev, eu_cfgPtr);
+    eu_stdCtx->Convert(evsp, stdev);
   }
   
   uint32_t ev_plane_c = stdev->NumPlanes();
@@ -369,26 +372,66 @@ string RootMonitor::GetSnapShotDir()const{
   return snapshotdir;
 }
 
-uint64_t OfflineReading(eudaq::Monitor *mon, eudaq::FileReaderSP reader, uint32_t ev_n_l, uint32_t ev_n_h, uint32_t ev_c_max){
+uint64_t OfflineReading(RootMonitor *mon, eudaq::FileReaderSP reader, uint32_t ev_n_l, uint32_t ev_n_h, uint32_t ev_c_max){
   // DoConfigure(); //TODO setup the configure and init file.
   mon->DoStartRun();
+  // events are converted to StdEvent in batches on all cores, events
+  // skipped by the reduce factor are not converted at all
+  eudaq::StdEventBatchConverter converter(mon->eu_cfgPtr);
+  const size_t batch_size = 256;
+  std::vector<eudaq::EventSPC> batch;
+  std::vector<eudaq::StdEventSP> batch_std;
+  std::vector<std::exception_ptr> errors;
+  uint32_t reduce = mon->getOnlineMon()->getReduce();
   uint32_t ev_c = 0;
-  while(1){
-    auto ev = std::const_pointer_cast<eudaq::Event>(reader->GetNextEvent());
+  uint32_t skipped = 0;
+  bool done = false;
+  if(ev_n_l)
+    reader->Seek(ev_n_l);
+  while(!done){
+    auto ev = reader->GetNextEvent();
     if(!ev){
       std::cout<<"end of data file with "<< ev_c << " events" <<std::endl;
-      break;
+      done = true;
     }
-    uint32_t ev_n = ev->GetEventN();
-    if(ev_n>=ev_n_l & ev_n<=ev_n_h){
-      mon->DoReceive(ev);
-      ev_c ++;
-      if(ev_c > ev_c_max){
-	std::cout<<"reach to event count "<< ev_c<<std::endl;
-	break;
+    else{
+      uint32_t ev_n = ev->GetEventN();
+      if(ev_n>=ev_n_l & ev_n<=ev_n_h){
+	if(ev_n <= 10 || ev_n % reduce == 0)
+	  batch.push_back(ev);
+	ev_c ++;
+	if(ev_c > ev_c_max){
+	  std::cout<<"reach to event count "<< ev_c<<std::endl;
+	  done = true;
+	}
+      }
+      if(!done && batch.size() < batch_size)
+	continue;
+    }
+    auto ok = converter.ConvertBatch(batch, batch_std, &errors);
+    for(size_t i = 0; i < batch.size(); i++){
+      // events the converters discard or cannot convert are not shown
+      try{
+	if(errors[i])
+	  std::rethrow_exception(errors[i]);
       }
+      catch(const eudaq::StdEventConverterException &e){
+	std::cout<<"event "<< batch[i]->GetEventN() <<" skipped: "<< e.what() <<std::endl;
+	ok[i] = false;
+      }
+      catch(const std::exception &e){
+	std::cout<<"event "<< batch[i]->GetEventN() <<" skipped, conversion failed: "<< e.what() <<std::endl;
+	ok[i] = false;
+      }
+      if(ok[i])
+	mon->DoReceive(batch_std[i]);
+      else
+	skipped++;
     }
+    batch.clear();
   }
+  if(skipped)
+    std::cout<< skipped <<" events could not be converted and were skipped"<<std::endl;
   mon->DoStopRun();
   return ev_c;
 }
@@ -409,6 +452,7 @@ int main(int argc, const char ** argv) {
   eudaq::Option<uint32_t>        event_amount_max(op, "ea", "event_amount_max", 0xffffffff, "running is offlinemode - analyse until reach events amount");
   
   eudaq::Option<std::string>     datafile(op, "d", "datafile",  " ", "offline mode data file");
+  eudaq::Option<uint32_t>        jobs(op, "j", "jobs", 1, "threads deserializing the data file (1: no read ahead, 0: all cores)");
   eudaq::Option<std::string>     configfile(op, "c", "config_file"," ", "filename","Config file to use for onlinemon");
   eudaq::Option<std::string>     monitorname(op, "t", "monitor_name","StdEventMonitor", "StdEventMonitor","Name for onlinemon");	
   eudaq::OptionFlag do_rootatend (op, "rf","root","Write out root-file after each run");
@@ -450,6 +494,8 @@ int main(int argc, const char ** argv) {
       std::cerr<<"OnlineMon:: ERROR, unable to access data file "<< infile_path<<std::endl;
       throw;
     }
+    if(jobs.Value() != 1)
+      reader = std::make_shared<eudaq::ParallelFileReader>(reader, jobs.Value());
     fut_async_rd = std::async(std::launch::async, &OfflineReading, &mon, reader, event_id_low.Value(), event_id_high.Value(), event_amount_max.Value() );
   }
   else{
@@ -1,6 +1,7 @@
 #include "eudaq/ROOTMonitor.hh"
 #include "eudaq/FileDeserializer.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/NativeFormat.hh"
 #include "eudaq/DataConverter.hh"
 
 #include "TH1.h"
@@ -110,9 +111,15 @@ namespace eudaq {
     DoConfigure();
     eudaq::EventUP ev;
     eudaq::FileDeserializer reader(path);
+    uint32_t version = eudaq::NativeFormat::ReadHeader(reader);
     do {
       if (m_interrupt)
         return;
+      if (version > 1) {
+        uint32_t len, type;
+        reader.read(len);
+        reader.read(type);
+      }
       reader.PreRead(id);
       ev = eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, reader);
       eudaq::EventSP evt(std::move(ev));
@@ -83,11 +83,9 @@ namespace eudaq {
   class CLICTDEvent2StdEventConverter: public eudaq::StdEventConverter{
   public:
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf,
+                             eudaq::StdEventConversionContext &ctx) const override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("CaribouCLICTDEvent");
-  private:
-    static size_t t0_seen_;
-    static bool t0_is_high_;
-    static uint64_t last_shutter_open_;
   };
 
   class DSO9254AEvent2StdEventConverter: public eudaq::StdEventConverter{
@@ -145,10 +143,9 @@ namespace eudaq {
   class CLICpix2Event2StdEventConverter: public eudaq::StdEventConverter{
   public:
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf,
+                             eudaq::StdEventConversionContext &ctx) const override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("CaribouCLICpix2Event");
-  private:
-    static size_t t0_seen_;
-    static uint64_t last_shutter_open_;
   };
 
   class ATLASPixEvent2StdEventConverter: public eudaq::StdEventConverter{
@@ -173,10 +170,10 @@ namespace eudaq {
   class H2MEvent2StdEventConverter: public eudaq::StdEventConverter{
   public:
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf,
+                             eudaq::StdEventConversionContext &ctx) const override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("CaribouH2MEvent");
   private:
-    static size_t last_frame_id_;
-    static bool frame_id_jumped_;
     void loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat) const;
   };
 } // namespace eudaq
@@ -9,12 +9,21 @@ using namespace eudaq;
 namespace{
   auto dummy0 = eudaq::Factory<eudaq::StdEventConverter>::
   Register<CLICTDEvent2StdEventConverter>(CLICTDEvent2StdEventConverter::m_id_factory);
+
+  // frame decoder and T0 tracking of one CLICTD stream
+  struct CLICTDState : public eudaq::StdEventConverterState {
+    std::unique_ptr<caribou::CLICTDFrameDecoder> decoder;
+    size_t t0_seen = 0;
+    bool t0_is_high = false;
+    uint64_t last_shutter_open = 0;
+  };
 }
 
-bool CLICTDEvent2StdEventConverter::t0_is_high_(false);
-size_t CLICTDEvent2StdEventConverter::t0_seen_(0);
-uint64_t CLICTDEvent2StdEventConverter::last_shutter_open_(0);
 bool CLICTDEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+  return ConvertingWithState(d1, d2, conf, StdEventConversionContext::ThreadDefault());
+}
+
+bool CLICTDEvent2StdEventConverter::ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf, eudaq::StdEventConversionContext &ctx) const{
   auto ev = std::dynamic_pointer_cast<const eudaq::RawEvent>(d1);
 
   // Retrieve matrix configuration from config:
@@ -27,12 +36,21 @@ bool CLICTDEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standa
   auto discard_tot_below = conf->Get("discard_tot_below", -1);
   auto discard_toa_below = conf->Get("discard_toa_below", -1);
 
-  static caribou::CLICTDFrameDecoder decoder(longcnt);
   // No event
   if(!ev) {
     return false;
   }
 
+  // Prepare frame decoder, once per stream:
+  auto &st = ctx.GetState<CLICTDState>(ev->GetStreamN());
+  if(!st.decoder) {
+    st.decoder.reset(new caribou::CLICTDFrameDecoder(longcnt));
+  }
+  auto &decoder = *st.decoder;
+  auto &t0_seen_ = st.t0_seen;
+  auto &t0_is_high_ = st.t0_is_high;
+  auto &last_shutter_open_ = st.last_shutter_open;
+
   // Data containers:
   std::vector<uint64_t> timestamps;
   caribou::pearyRawData rawdata;
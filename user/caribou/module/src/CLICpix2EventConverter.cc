@@ -9,11 +9,21 @@ using namespace eudaq;
 namespace{
   auto dummy0 = eudaq::Factory<eudaq::StdEventConverter>::
   Register<CLICpix2Event2StdEventConverter>(CLICpix2Event2StdEventConverter::m_id_factory);
+
+  // matrix decoder and T0 tracking of one CLICpix2 stream
+  struct CLICpix2State : public eudaq::StdEventConverterState {
+    std::map<std::pair<uint8_t, uint8_t>, caribou::pixelConfig> matrix;
+    std::unique_ptr<caribou::clicpix2_frameDecoder> decoder;
+    size_t t0_seen = 0;
+    uint64_t last_shutter_open = 0;
+  };
 }
 
-size_t CLICpix2Event2StdEventConverter::t0_seen_(0);
-uint64_t CLICpix2Event2StdEventConverter::last_shutter_open_(0);
 bool CLICpix2Event2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+  return ConvertingWithState(d1, d2, conf, StdEventConversionContext::ThreadDefault());
+}
+
+bool CLICpix2Event2StdEventConverter::ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf, eudaq::StdEventConversionContext &ctx) const{
   auto ev = std::dynamic_pointer_cast<const eudaq::RawEvent>(d1);
 
   // Retrieve matrix configuration and compression status from config:
@@ -26,24 +36,24 @@ bool CLICpix2Event2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Stan
   auto discard_tot_below = conf->Get("discard_tot_below", -1);
   auto discard_toa_below = conf->Get("discard_toa_below", -1);
 
-  // Prepare matrix decoder:
-  static auto matrix_config = [counting, longcnt]() {
-    std::map<std::pair<uint8_t, uint8_t>, caribou::pixelConfig> matrix;
+  // No event
+  if(!ev) {
+    return false;
+  }
+
+  // Prepare matrix decoder, once per stream:
+  auto &st = ctx.GetState<CLICpix2State>(ev->GetStreamN());
+  if(!st.decoder) {
     for(uint8_t x = 0; x < 128; x++) {
       for(uint8_t y = 0; y < 128; y++) {
         // FIXME hard-coded matrix configuration for CLICpix2 - needs to be read from a configuration!
-        matrix[std::make_pair(y,x)] = caribou::pixelConfig(true, 3, counting, false, longcnt);
+        st.matrix[std::make_pair(y,x)] = caribou::pixelConfig(true, 3, counting, false, longcnt);
       }
     }
-    return matrix;
-  };
-
-  static auto matrix = matrix_config();
-  static caribou::clicpix2_frameDecoder decoder(comp, sp_comp, matrix);
-  // No event
-  if(!ev) {
-    return false;
+    st.decoder.reset(new caribou::clicpix2_frameDecoder(comp, sp_comp, st.matrix));
   }
+  auto &matrix = st.matrix;
+  auto &decoder = *st.decoder;
 
   // Data containers:
   std::vector<uint64_t> timestamps;
@@ -130,10 +140,10 @@ bool CLICpix2Event2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Stan
   }
 
   // Check if there was a T0:
-  if(last_shutter_open_ > shutter_open) {
-      t0_seen_++;
+  if(st.last_shutter_open > shutter_open) {
+      st.t0_seen++;
   }
-  last_shutter_open_ = shutter_open;
+  st.last_shutter_open = shutter_open;
 
   // Check for a sane shutter:
   if(shutter_open > shutter_close) {
@@ -144,12 +154,12 @@ bool CLICpix2Event2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Stan
   // FIXME - hardcoded configuration:
   bool drop_before_t0 = true;
   // No T0 signal seen yet, dropping frame:
-  if(drop_before_t0 && (t0_seen_==0)) {
+  if(drop_before_t0 && (st.t0_seen==0)) {
     return false;
   }
   // throw exception when T0 occurs more than once:
-  if(t0_seen_>1) {
-      throw DataInvalid("Detected T0 " + std::to_string(t0_seen_) + " times.");
+  if(st.t0_seen>1) {
+      throw DataInvalid("Detected T0 " + std::to_string(st.t0_seen) + " times.");
   }
 
   // Decode the data:
@@ -14,16 +14,26 @@ using namespace eudaq;
 namespace {
   auto dummy0 = eudaq::Factory<eudaq::StdEventConverter>::Register<
       H2MEvent2StdEventConverter>(H2MEvent2StdEventConverter::m_id_factory);
-}
 
-static bool m_first_time = true;
-static std::vector<std::vector<float>> vtot; // for ToT calibration
+  // calibration, frame decoder and frame ID tracking of one H2M stream
+  struct H2MState : public eudaq::StdEventConverterState {
+    bool first_time = true;
+    std::vector<std::vector<float>> vtot; // for ToT calibration
+    caribou::H2MFrameDecoder decoder;
+    size_t last_frame_id = 0;
+    bool frame_id_jumped = false;
+  };
+}
 
-size_t H2MEvent2StdEventConverter::last_frame_id_ = 0;
-bool H2MEvent2StdEventConverter::frame_id_jumped_ = false;
 bool H2MEvent2StdEventConverter::Converting(
     eudaq::EventSPC d1, eudaq::StandardEventSP d2,
     eudaq::ConfigurationSPC conf) const {
+  return ConvertingWithState(d1, d2, conf, StdEventConversionContext::ThreadDefault());
+}
+
+bool H2MEvent2StdEventConverter::ConvertingWithState(
+    eudaq::EventSPC d1, eudaq::StandardEventSP d2,
+    eudaq::ConfigurationSPC conf, eudaq::StdEventConversionContext &ctx) const {
   auto ev = std::dynamic_pointer_cast<const eudaq::RawEvent>(d1);
 
   // No event
@@ -38,8 +48,13 @@ bool H2MEvent2StdEventConverter::Converting(
   // Read acquisition mode from configuration, defaulting to ToT.
   uint8_t acq_mode = conf->Get("acq_mode", 0x1);
   uint64_t delay_to_frame_end = conf->Get("delay_to_frame_end", -999);
+  auto &st = ctx.GetState<H2MState>(ev->GetStreamN());
+  auto &vtot = st.vtot;
+  auto &last_frame_id_ = st.last_frame_id;
+  auto &frame_id_jumped_ = st.frame_id_jumped;
+
   // Load ToT calibration data from configuration
-  if (m_first_time) {
+  if (st.first_time) {
     if (conf && conf->Has("calibration_path_tot")) {
       std::string calibrationPathToT = conf->Get("calibration_path_tot", "");
 
@@ -49,11 +64,11 @@ bool H2MEvent2StdEventConverter::Converting(
     } else {
       EUDAQ_INFO("No calibration file path for ToT; data will be uncalibrated.");
     }
-    m_first_time = false;
+    st.first_time = false;
   }
 
-  // get an instance of the frame decoder
-  static caribou::H2MFrameDecoder decoder;
+  // the frame decoder of this stream
+  auto &decoder = st.decoder;
 
   // Data container:
   std::vector<uint32_t> rawdata;
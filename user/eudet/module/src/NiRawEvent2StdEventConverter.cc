@@ -6,12 +6,17 @@
 #define PIVOTPIXELOFFSET 64
 
 class NiRawEvent2StdEventConverter: public eudaq::StdEventConverter{
-  typedef std::vector<uint8_t>::const_iterator datait;
+  typedef eudaq::BlockView::const_iterator datait;
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+  void Initialize(eudaq::ConfigurationSPC conf) override;
+  bool IsStateless() const override {return true;}
   void DecodeFrame(eudaq::StandardPlane& plane, const uint32_t fm_n,
            const uint8_t *const d, const size_t l32, bool fix_pivot = false) const;
   static const uint32_t m_id_factory = eudaq::cstr2hash("NiRawDataEvent");
+private:
+  bool m_initialized = false;
+  bool m_use_all_hits = false;
 };
 
 namespace{
@@ -19,6 +24,11 @@ namespace{
     Register<NiRawEvent2StdEventConverter>(NiRawEvent2StdEventConverter::m_id_factory);
 }
 
+void NiRawEvent2StdEventConverter::Initialize(eudaq::ConfigurationSPC conf){
+  m_use_all_hits = (conf != nullptr ? bool(conf->Get("use_all_hits",0)) : false);
+  m_initialized = true;
+}
+
 bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
 
   static const std::vector<uint32_t> m_ids = {0, 1, 2, 3, 4, 5};
@@ -40,15 +50,16 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
   }
 
   auto &rawev = *ev;
-  if (rawev.NumBlocks() < 2 || rawev.GetBlock(0).size() < 20 ||
-      rawev.GetBlock(1).size() < 20) {
+  if (rawev.NumBlocks() < 2 || rawev.GetBlockView(0).size() < 20 ||
+      rawev.GetBlockView(1).size() < 20) {
     EUDAQ_WARN("Ignoring bad event " + std::to_string(rawev.GetEventNumber()));
     return false;
   }
-  auto use_all_hits = (conf != nullptr ? bool(conf->Get("use_all_hits",0)) : false);
+  auto use_all_hits = m_initialized ? m_use_all_hits :
+    (conf != nullptr ? bool(conf->Get("use_all_hits",0)) : false);
 
-  const std::vector<uint8_t> &data0 = rawev.GetBlock(0);
-  const std::vector<uint8_t> &data1 = rawev.GetBlock(1);
+  const eudaq::BlockView data0 = rawev.GetBlockView(0);
+  const eudaq::BlockView data1 = rawev.GetBlockView(1);
   uint32_t header0 = eudaq::getlittleendian<uint32_t>(&data0[0]);
   uint32_t header1 = eudaq::getlittleendian<uint32_t>(&data1[0]);
   uint16_t pivot = eudaq::getlittleendian<uint16_t>(&data0[4]);
@@ -91,7 +102,11 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
       break;
     }
 
-    eudaq::StandardPlane plane(id, "NI", "MIMOSA26");
+    // decoded aside, so that a frame failing to decode leaves no half-filled
+    // plane in the event; the buffers are kept per thread and copied into the
+    // (possibly recycled) plane of the event
+    static thread_local eudaq::StandardPlane plane;
+    plane.Reset(id, "NI", "MIMOSA26");
     plane.SetSizeZS(1152, 576, 0, 2, eudaq::StandardPlane::FLAG_WITHPIVOT |
 		    eudaq::StandardPlane::FLAG_DIFFCOORDS);
     plane.SetPivotPixel((9216 + pivot + PIVOTPIXELOFFSET) % 9216);
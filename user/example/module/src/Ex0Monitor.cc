@@ -26,6 +26,7 @@ class Ex0Monitor : public eudaq::Monitor {
   bool m_en_print;
   bool m_en_std_converter;
   bool m_en_std_print;
+  eudaq::StdEventConversionContext m_std_ctx;
 };
 
 namespace{
@@ -69,7 +70,7 @@ void Ex0Monitor::DoReceive(eudaq::EventSP ev){
     auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(ev);
     if(!stdev){
       stdev = eudaq::StandardEvent::MakeShared();
-      eudaq::StdEventConverter::Convert(ev, stdev, nullptr); //no conf
+      m_std_ctx.Convert(ev, stdev); //no conf
       if(m_en_std_print)
 	stdev->Print(std::cout);
     }
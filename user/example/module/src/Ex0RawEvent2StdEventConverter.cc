@@ -4,6 +4,7 @@
 class Ex0RawEvent2StdEventConverter: public eudaq::StdEventConverter{
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::StdEventSP d2, eudaq::ConfigSPC conf) const override;
+  bool IsStateless() const override {return true;}
   static const uint32_t m_id_factory = eudaq::cstr2hash("Ex0Raw");
 };
 
@@ -17,7 +18,7 @@ bool Ex0RawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::StdEve
   size_t nblocks= ev->NumBlocks();
   auto block_n_list = ev->GetBlockNumList();
   for(auto &block_n: block_n_list){
-    std::vector<uint8_t> block = ev->GetBlock(block_n);
+    auto block = ev->GetBlockView(block_n);
     if(block.size() < 2)
       EUDAQ_THROW("Unknown data");
     uint8_t x_pixel = block[0];
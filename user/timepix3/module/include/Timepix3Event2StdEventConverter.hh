@@ -2,6 +2,9 @@
 #include "eudaq/RawEvent.hh"
 #include "eudaq/Logger.hh"
 
+#include <memory>
+#include <mutex>
+
 /**
 * Timepix3 event converter, converting from raw detector data to EUDAQ StandardEvent format
 * SPIDR provides two event types, pixel data and trigger information events.
@@ -10,25 +13,42 @@ namespace eudaq {
   class Timepix3RawEvent2StdEventConverter: public eudaq::StdEventConverter{
   public:
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf,
+                             eudaq::StdEventConversionContext &ctx) const override;
+    void Initialize(eudaq::ConfigurationSPC conf) override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("Timepix3RawEvent");
   private:
-    static uint64_t m_syncTime;
-    static uint64_t m_syncTime_prev;
-    static uint64_t m_delta_t0;
-    static bool m_clearedHeader;
-    static bool m_first_time;
-    static std::vector<std::vector<float>> vtot;
-    static std::vector<std::vector<float>> vtoa;
+    // timing information carried from one event of a stream to the next
+    struct State : public eudaq::StdEventConverterState {
+      uint64_t syncTime = 0;
+      uint64_t syncTime_prev = 0;
+      bool clearedHeader = false;
+    };
+    struct Calibration {
+      std::vector<std::vector<float>> vtot;
+      std::vector<std::vector<float>> vtoa;
+    };
+    // read once, in Initialize or else at the first conversion
+    mutable std::once_flag m_setup;
+    mutable uint64_t m_delta_t0 = 1e6;
+    mutable std::shared_ptr<const Calibration> m_cal;
 
-    void loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat) const;
+    void Setup(eudaq::ConfigurationSPC conf) const;
+    static std::shared_ptr<const Calibration> getCalibration(const std::string &pathToT, const std::string &pathToA);
+    static void loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat);
   };
 
   class Timepix3TrigEvent2StdEventConverter: public eudaq::StdEventConverter{
   public:
     bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+    bool ConvertingWithState(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf,
+                             eudaq::StdEventConversionContext &ctx) const override;
     static const uint32_t m_id_factory = eudaq::cstr2hash("Timepix3TrigEvent");
-    static long long int m_syncTimeTDC;
-    static int m_TDCoverflowCounter;
+  private:
+    struct State : public eudaq::StdEventConverterState {
+      long long int syncTimeTDC = 0;
+      int TDCoverflowCounter = 0;
+    };
   };
 
 } // namespace eudaq
@@ -1,5 +1,6 @@
 #include "Timepix3Event2StdEventConverter.hh"
 #include <cmath> // for sqrt()
+#include <map>
 
 using namespace eudaq;
 
@@ -10,9 +11,11 @@ namespace {
   Register<Timepix3TrigEvent2StdEventConverter>(Timepix3TrigEvent2StdEventConverter::m_id_factory);
 }
 
-long long int Timepix3TrigEvent2StdEventConverter::m_syncTimeTDC(0);
-int Timepix3TrigEvent2StdEventConverter::m_TDCoverflowCounter(0);
 bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+  return ConvertingWithState(ev, d2, conf, StdEventConversionContext::ThreadDefault());
+}
+
+bool Timepix3TrigEvent2StdEventConverter::ConvertingWithState(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf, eudaq::StdEventConversionContext &ctx) const{
 
   // Bad event
   if(ev->NumBlocks() != 1) {
@@ -22,12 +25,12 @@ bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::
 
   // Retrieve data from Block 0:
   uint64_t trigdata;
-  auto data = ev->GetBlock(0);
+  auto data = ev->GetBlockView(0);
   if(data.size() / sizeof(uint64_t) > 1) {
     EUDAQ_WARN("Ignoring packet " + std::to_string(ev->GetEventNumber()) + " with unexpected data");
     return false;
   }
-  memcpy(&trigdata, &data[0],data.size());
+  memcpy(&trigdata, data.data(), data.size());
 
   // Get the header (first 4 bits): 0x4 is the "heartbeat" signal, 0xA and 0xB are pixel data
   const uint8_t header = static_cast<uint8_t>((trigdata & 0xF000000000000000) >> 60) & 0xF;
@@ -60,11 +63,12 @@ bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::
   }
 
   // if jump back in time is larger than 1 sec, overflow detected...
-  if((m_syncTimeTDC - timestamp_raw) > 0x1312d000) {
-    m_TDCoverflowCounter++;
+  auto &st = ctx.GetState<State>(ev->GetStreamN());
+  if((st.syncTimeTDC - timestamp_raw) > 0x1312d000) {
+    st.TDCoverflowCounter++;
   }
-  m_syncTimeTDC = timestamp_raw;
-  timestamp = timestamp_raw + (static_cast<long long int>(m_TDCoverflowCounter) << 35);
+  st.syncTimeTDC = timestamp_raw;
+  timestamp = timestamp_raw + (static_cast<long long int>(st.TDCoverflowCounter) << 35);
 
   // Calculate timestamp in picoseconds assuming 320 MHz clock:
   uint64_t triggerTime = timestamp * 3125 +(stamp * 3125) / 12;
@@ -79,72 +83,83 @@ bool Timepix3TrigEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::
   return true;
 }
 
-uint64_t Timepix3RawEvent2StdEventConverter::m_syncTime(0);
-uint64_t Timepix3RawEvent2StdEventConverter::m_syncTime_prev(0);
-uint64_t Timepix3RawEvent2StdEventConverter::m_delta_t0(1e6);
-bool Timepix3RawEvent2StdEventConverter::m_clearedHeader(false);
-bool Timepix3RawEvent2StdEventConverter::m_first_time(true);
-std::vector<std::vector<float>> Timepix3RawEvent2StdEventConverter::vtot;
-std::vector<std::vector<float>> Timepix3RawEvent2StdEventConverter::vtoa;
+void Timepix3RawEvent2StdEventConverter::Initialize(eudaq::ConfigurationSPC conf){
+  std::call_once(m_setup, &Timepix3RawEvent2StdEventConverter::Setup, this, conf);
+}
 
-bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+std::shared_ptr<const Timepix3RawEvent2StdEventConverter::Calibration>
+Timepix3RawEvent2StdEventConverter::getCalibration(const std::string &pathToT, const std::string &pathToA){
+  // converters created for every event (e.g. through the RawEvent converter) share the tables
+  static std::mutex mtx;
+  static std::map<std::pair<std::string, std::string>, std::shared_ptr<const Calibration>> cache;
+  std::lock_guard<std::mutex> lk(mtx);
+  auto &cal = cache[std::make_pair(pathToT, pathToA)];
+  if(cal)
+    return cal;
+
+  auto newcal = std::make_shared<Calibration>();
+  loadCalibration(pathToT, ' ', newcal->vtot);
+  loadCalibration(pathToA, ' ', newcal->vtoa);
+
+  // every pixel needs its ToT and ToA parameters, throws out_of_range otherwise
+  for(size_t px = 0; px < 256 * 256; px++) {
+    newcal->vtot.at(px).at(5);
+    newcal->vtoa.at(px).at(4);
+  }
+  cal = newcal;
+  return cal;
+}
+
+void Timepix3RawEvent2StdEventConverter::Setup(eudaq::ConfigurationSPC conf) const{
 
   // Read from configuration:
-  if(m_first_time) {
-      m_delta_t0 = (conf ? conf->Get("delta_t0", 1e6) : 1e6); // default: 1sec
-
-      EUDAQ_INFO("Will detect 2nd T0 indirectly if timestamp jumps back by more than " + to_string(m_delta_t0) + "us.");
-      m_first_time = false;
-
-      if(conf && conf->Has("calibration_path_tot") && conf->Has("calibration_path_toa")) {
-          std::string calibrationPathToT = conf->Get("calibration_path_tot","");
-          std::string calibrationPathToA = conf->Get("calibration_path_toa","");
-
-          if(calibrationPathToT.find("toa") != std::string::npos) {
-              throw DataInvalid("Timepix3: Parameter calibration_path_tot contains substring \"toa\", please update your configuration file!");
-          }
-          if(calibrationPathToA.find("tot") != std::string::npos) {
-              throw DataInvalid("Timepix3: Parameter calibration_path_toa contains substring \"tot\", please update your configuration file!");
-          }
-
-          EUDAQ_INFO("Applying ToT calibration from " + calibrationPathToT);
-          EUDAQ_INFO("Applying ToA calibration from " + calibrationPathToA);
-
-          std::string tmp;
-          loadCalibration(calibrationPathToT, ' ', vtot);
-          loadCalibration(calibrationPathToA, ' ', vtoa);
-
-            for(size_t row = 0; row < 256; row++) {
-                for(size_t col = 0; col < 256; col++) {
-                    float a = vtot.at(256 * row + col).at(2);
-                    float b = vtot.at(256 * row + col).at(3);
-                    float c = vtot.at(256 * row + col).at(4);
-                    float t = vtot.at(256 * row + col).at(5);
-                    float toa_c = vtoa.at(256 * row + col).at(2);
-                    float toa_t = vtoa.at(256 * row + col).at(3);
-                    float toa_d = vtoa.at(256 * row + col).at(4);
-
-                    double cold = static_cast<double>(col);
-                    double rowd = static_cast<double>(row);
-                }
-            }
-        } else {
-            EUDAQ_INFO("No calibration file path for ToT or ToA; data will be uncalibrated.");
-        }
+  m_delta_t0 = (conf ? conf->Get("delta_t0", 1e6) : 1e6); // default: 1sec
+
+  EUDAQ_INFO("Will detect 2nd T0 indirectly if timestamp jumps back by more than " + to_string(m_delta_t0) + "us.");
+
+  if(conf && conf->Has("calibration_path_tot") && conf->Has("calibration_path_toa")) {
+    std::string calibrationPathToT = conf->Get("calibration_path_tot","");
+    std::string calibrationPathToA = conf->Get("calibration_path_toa","");
+
+    if(calibrationPathToT.find("toa") != std::string::npos) {
+      throw DataInvalid("Timepix3: Parameter calibration_path_tot contains substring \"toa\", please update your configuration file!");
+    }
+    if(calibrationPathToA.find("tot") != std::string::npos) {
+      throw DataInvalid("Timepix3: Parameter calibration_path_toa contains substring \"tot\", please update your configuration file!");
     }
 
+    EUDAQ_INFO("Applying ToT calibration from " + calibrationPathToT);
+    EUDAQ_INFO("Applying ToA calibration from " + calibrationPathToA);
+
+    m_cal = getCalibration(calibrationPathToT, calibrationPathToA);
+  } else {
+    EUDAQ_INFO("No calibration file path for ToT or ToA; data will be uncalibrated.");
+  }
+}
+
+bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const{
+  return ConvertingWithState(ev, d2, conf, StdEventConversionContext::ThreadDefault());
+}
+
+bool Timepix3RawEvent2StdEventConverter::ConvertingWithState(eudaq::EventSPC ev, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf, eudaq::StdEventConversionContext &ctx) const{
+
   bool data_found = false;
 
+  // converters used without a conversion context are never initialized
+  std::call_once(m_setup, &Timepix3RawEvent2StdEventConverter::Setup, this, conf);
+  const Calibration *cal = m_cal.get();
+
   // No event
   if(!ev || ev->NumBlocks() < 1) {
     return false;
   }
+  auto &st = ctx.GetState<State>(ev->GetStreamN());
 
   // Retrieve data from Block 0:
   std::vector<uint64_t> vpixdata;
-  auto data = ev->GetBlock(0);
+  auto data = ev->GetBlockView(0);
   vpixdata.resize(data.size() / sizeof(uint64_t));
-  memcpy(&vpixdata[0], &data[0], data.size());
+  memcpy(vpixdata.data(), data.data(), vpixdata.size() * sizeof(uint64_t));
 
   // Create a StandardPlane representing one sensor plane
   eudaq::StandardPlane plane(0, "SPIDR", "Timepix3");
@@ -173,28 +188,28 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
       // 0x4 is the least significant part of the timestamp
       if(header2 == 0x4) {
         // The data is shifted 16 bits to the right, then 12 to the left in order to match the timestamp format (net 4 right)
-        m_syncTime = (m_syncTime & 0xFFFFF00000000000) + ((pixdata & 0x0000FFFFFFFF0000) >> 4);
+        st.syncTime = (st.syncTime & 0xFFFFF00000000000) + ((pixdata & 0x0000FFFFFFFF0000) >> 4);
       }
       // 0x5 is the most significant part of the timestamp
       if(header2 == 0x5) {
         // The data is shifted 16 bits to the right, then 44 to the left in order to match the timestamp format (net 28 left)
-        m_syncTime = (m_syncTime & 0x00000FFFFFFFFFFF) + ((pixdata & 0x00000000FFFF0000) << 28);
+        st.syncTime = (st.syncTime & 0x00000FFFFFFFFFFF) + ((pixdata & 0x00000000FFFF0000) << 28);
 
-        if(!m_clearedHeader && (m_syncTime / 4096 / 40) < 6000000) { // < 6sec
+        if(!st.clearedHeader && (st.syncTime / 4096 / 40) < 6000000) { // < 6sec
           EUDAQ_INFO("Timepix3: Detected T0 signal. Header cleared.");
-          m_clearedHeader = true;
+          st.clearedHeader = true;
 
         // From SPS data we know that even though pixel timestamps are not perfectly chronological, they are not more
         // than "mixed up by -20us". At DESY, this is hardly (ever?) the case due to the lower occupancies.
         // Hence, if the current timestamp is more than 20us earlier than the previous timestamp, we can assume that
         // a 2nd T0 has occured. With some safety margin, set delta_t0 = 1e6 (1s, default).
         // This implies we cannot detect a 2nd T0 within the first "delta_t0" microseconds after the initial T0.
-        } else if ((m_syncTime + m_delta_t0 * 4096 * 40) < m_syncTime_prev) { // delta_t0 on left side to avoid neg. difference between uint64_t
-          throw DataInvalid("Timepix3: Detected second T0 signal. Time jumps back by " + to_string((m_syncTime_prev - m_syncTime) / 4096 / 40) + "us.");
+        } else if ((st.syncTime + m_delta_t0 * 4096 * 40) < st.syncTime_prev) { // delta_t0 on left side to avoid neg. difference between uint64_t
+          throw DataInvalid("Timepix3: Detected second T0 signal. Time jumps back by " + to_string((st.syncTime_prev - st.syncTime) / 4096 / 40) + "us.");
         }
-        EUDAQ_DEBUG("ST = " + to_string(m_syncTime) + " STPrev = " + to_string(m_syncTime_prev) + " " + to_string(m_syncTime < m_syncTime_prev));
+        EUDAQ_DEBUG("ST = " + to_string(st.syncTime) + " STPrev = " + to_string(st.syncTime_prev) + " " + to_string(st.syncTime < st.syncTime_prev));
 
-        m_syncTime_prev = m_syncTime;
+        st.syncTime_prev = st.syncTime;
       }
     }
 
@@ -202,7 +217,7 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
     // this "header" data has been cleared, when the heart beat signal starts from a low number (~few seconds max).
     // To detect a possible second T0, we have no better gauge than the same criterion:
     // Comparing the timestamp to the previous timestamp (see above).
-    if(!m_clearedHeader) {
+    if(!st.clearedHeader) {
         continue;
     }
 
@@ -225,14 +240,14 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
       const uint64_t toa((data & 0x0FFFC000) >> 14);
 
       // Calculate the timestamp.
-      uint64_t time = (((spidrTime << 18) + (toa << 4) + (15 - ftoa)) << 8) + (m_syncTime & 0xFFFFFC0000000000);
+      uint64_t time = (((spidrTime << 18) + (toa << 4) + (15 - ftoa)) << 8) + (st.syncTime & 0xFFFFFC0000000000);
 
       // Adjusting phases for double column shift
       time += ((static_cast<uint64_t>(col) / 2 - 1) % 16) * 256;
 
       // The time from the pixels has a maximum value of ~26 seconds. We compare the pixel time to the "heartbeat"
       // signal (which has an overflow of ~4 years) and check if the pixel time has wrapped back around to 0
-      while(static_cast<long long>(m_syncTime) - static_cast<long long>(time) > 0x0000020000000000) {
+      while(static_cast<long long>(st.syncTime) - static_cast<long long>(time) > 0x0000020000000000) {
         time += 0x0000040000000000;
       }
 
@@ -244,7 +259,9 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
 
       // Apply calibration if both vtot and vtoa are not empty
       // (copied over from Corryvreckan EventLoaderTimepix3)
-      if(!vtot.empty() && !vtoa.empty()) {
+      if(cal) {
+        auto &vtot = cal->vtot;
+        auto &vtoa = cal->vtoa;
         EUDAQ_DEBUG("Applying calibration to DUT");
         size_t scol = static_cast<size_t>(col);
         size_t srow = static_cast<size_t>(row);
@@ -301,7 +318,7 @@ bool Timepix3RawEvent2StdEventConverter::Converting(eudaq::EventSPC ev, eudaq::S
   return data_found;
 }
 
-void Timepix3RawEvent2StdEventConverter::loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat) const {
+void Timepix3RawEvent2StdEventConverter::loadCalibration(std::string path, char delim, std::vector<std::vector<float>>& dat) {
     // copied from Corryvreckan EventLoaderTimepix3
     std::ifstream f;
     f.open(path);
@@ -4,6 +4,7 @@
 class TluRawEvent2StdEventConverter: public eudaq::StdEventConverter{
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
+  bool IsStateless() const override {return true;}
   static const uint32_t m_id_factory = eudaq::cstr2hash("TluRawDataEvent");
 };
 
@@ -53,7 +54,7 @@ bool TluRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standa
   // Allowing compact data requires us to also take care of reading data
   // Compact data contains a data block, whcih is used as check
   if (d1->NumBlocks()==1){
-    auto data = d1->GetBlock(0);
+    auto data = d1->GetBlockView(0);
     if(data.size() != 24) {
       // medium-legacy data format - already decoded and re-packed
       fts_0 = data[0];
@@ -1,5 +1,6 @@
 #include "XRootDFileDeserializer.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/NativeFormat.hh"
 
 class XRootDNativeFileReader : public eudaq::FileReader {
 public:
@@ -8,6 +9,7 @@ class XRootDNativeFileReader : public eudaq::FileReader {
 private:
   std::unique_ptr<eudaq::XRootDFileDeserializer> m_des;
   std::string m_filename;
+  uint32_t m_version;
 };
 
 namespace{
@@ -18,7 +20,7 @@ namespace{
 }
 
 XRootDNativeFileReader::XRootDNativeFileReader(const std::string& filename)
-  :m_filename(filename){    
+  :m_filename(filename), m_version(0){
 }
 
 eudaq::EventSPC XRootDNativeFileReader::GetNextEvent(){
@@ -26,11 +28,17 @@ eudaq::EventSPC XRootDNativeFileReader::GetNextEvent(){
     m_des.reset(new eudaq::XRootDFileDeserializer(m_filename));
     if(!m_des)
       EUDAQ_THROW("unable to open file: " + m_filename);
+    m_version = eudaq::NativeFormat::ReadHeader(*m_des);
   }
   eudaq::EventUP ev;
   uint32_t id;
   
   if(m_des->HasData()){
+    if(m_version > 1){
+      uint32_t len, type;
+      m_des->read(len);
+      m_des->read(type);
+    }
     m_des->PreRead(id);
     ev = eudaq::Factory<eudaq::Event>::
       Create<eudaq::Deserializer&>(id, *m_des);